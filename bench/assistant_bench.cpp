@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "assistant.hpp"
+#include "synthetic.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <span>
+#include <vector>
+
+// Usage: assistant_bench [size] [edits]
+// Plays random correct moves on a size x size board (default: 200x200) and
+// measures the time from each edit to the assistant's result, against a
+// 60 Hz frame.  A second run makes edits in bursts of four without waiting,
+// so that all but the last analysis in each burst is cancelled.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const int size{args.size() > 1 ? std::atoi(args[1]) : 200};
+    const int edits{args.size() > 2 ? std::atoi(args[2]) : 500};
+    constexpr double frame_ms{1000.0 / 60.0};
+
+    const auto puzzle{grandrounds::bench::make_synthetic_puzzle(size, size,
+                                                                0.6, 1)};
+    std::mutex mutex;
+    std::condition_variable done;
+    std::uint64_t finished{0};
+    grandrounds::hint_assistant assistant{
+        puzzle.dimensions, puzzle.row_hints, puzzle.col_hints, [&] {
+            {
+                const std::lock_guard lock{mutex};
+                finished++;
+            }
+            done.notify_one();
+        }};
+
+    std::mt19937 rng{1};
+    std::uniform_int_distribution<std::size_t> cell{0,
+                                                    puzzle.solution.size() - 1};
+    for (const int burst : {1, 4}) {
+        std::vector<grandrounds::board_cell> board(puzzle.solution.size());
+        std::vector<double> latencies;
+        for (int i{0}; i < edits; i++) {
+            const auto start{clock::now()};
+            for (int j{0}; j < burst; j++) {
+                const auto index{cell(rng)};
+                board[index] = puzzle.solution[index] ==
+                                       grandrounds::board_cell::filled
+                                   ? grandrounds::board_cell::filled
+                                   : grandrounds::board_cell::marked;
+                assistant.analyze(board);
+            }
+            std::unique_lock lock{mutex};
+            done.wait(lock, [&] {
+                const auto latest{assistant.latest()};
+                return latest &&
+                       latest->generation == assistant.generation();
+            });
+            latencies.push_back(milliseconds{clock::now() - start}.count());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile{[&](double p) {
+            return latencies[static_cast<std::size_t>(
+                p * static_cast<double>(latencies.size() - 1))];
+        }};
+        fmt::print(
+            "{}x{}, bursts of {}: median {:.3f} ms, 99th percentile {:.3f} "
+            "ms, max {:.3f} ms (frame: {:.1f} ms)\n",
+            size, size, burst, percentile(0.5), percentile(0.99),
+            latencies.back(), frame_ms);
+    }
+}
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "cnf.hpp"
+#include "solver.hpp"
+#include "synthetic.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <span>
+
+// Usage: cnf_bench [dimacs_output_dir]
+// Proves uniqueness (or finds two solutions) for each puzzle in the synthetic
+// corpus with both the native solver and the CNF encoding plus CDCL solver,
+// reporting encoding size and wall time side by side.  If a directory is
+// given, each encoding is also written there as a DIMACS file so it can be
+// handed to an external SAT solver for comparison.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using ms = std::chrono::duration<double, std::milli>;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const std::filesystem::path dimacs_dir{args.size() > 1 ? args[1] : ""};
+
+    fmt::print("{:<26} {:>7} {:>8} {:>8} {:>9} {:>9} {:>9} {:>10} {:>10}\n",
+               "puzzle", "unique", "vars", "clauses", "literals", "conflicts",
+               "encode ms", "cdcl ms", "native ms");
+    double total_cdcl{0.0};
+    double total_native{0.0};
+    for (const auto& puzzle : grandrounds::bench::synthetic_corpus()) {
+        const auto encode_start{clock::now()};
+        const auto encoded{grandrounds::encode_nonogram(
+            puzzle.dimensions, puzzle.row_hints, puzzle.col_hints)};
+        const ms encode_time{clock::now() - encode_start};
+        if (!dimacs_dir.empty()) {
+            std::ofstream out{dimacs_dir / (puzzle.name + ".cnf")};
+            grandrounds::write_dimacs(out, encoded.formula);
+        }
+
+        // solve_nonogram_cnf encodes again; the encoding time is reported
+        // separately above and is small next to the solve.
+        const auto cdcl_start{clock::now()};
+        const auto cnf{grandrounds::solve_nonogram_cnf(
+            puzzle.dimensions, puzzle.row_hints, puzzle.col_hints)};
+        const ms cdcl_time{clock::now() - cdcl_start};
+
+        const auto native_start{clock::now()};
+        const auto native{grandrounds::solve_nonogram(
+            puzzle.dimensions, puzzle.row_hints, puzzle.col_hints)};
+        const ms native_time{clock::now() - native_start};
+
+        total_cdcl += cdcl_time.count();
+        total_native += native_time.count();
+        const bool agree{cnf.status == native.status};
+        fmt::print(
+            "{:<26} {:>7} {:>8} {:>8} {:>9} {:>9} {:>9.2f} {:>10.2f} {:>10.2f}"
+            "{}\n",
+            puzzle.name,
+            cnf.status == grandrounds::solve_status::unique ? "yes" : "no",
+            cnf.variables, cnf.clauses, cnf.literals, cnf.stats.conflicts,
+            encode_time.count(), cdcl_time.count(), native_time.count(),
+            agree ? "" : "  SOLVERS DISAGREE");
+    }
+    fmt::print("total: {:.1f} ms CDCL, {:.1f} ms native\n", total_cdcl,
+               total_native);
+}
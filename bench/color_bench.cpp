@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "color_solver.hpp"
+#include "nonogram.hpp"
+#include "solver.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace {
+
+// A random board about 60% filled, with the filled cells spread evenly over
+// `colors` colours.
+std::vector<grandrounds::board_cell> random_board(int width,
+                                                  int height,
+                                                  int colors,
+                                                  unsigned int seed)
+{
+    std::mt19937 rng{seed};
+    std::bernoulli_distribution filled{0.6};
+    std::uniform_int_distribution<int> color{0, colors - 1};
+    std::vector<grandrounds::board_cell> out(
+        static_cast<std::size_t>(width * height));
+    for (auto& cell : out) {
+        cell = filled(rng) ? grandrounds::filled_cell(
+                                 static_cast<std::uint8_t>(color(rng)))
+                           : grandrounds::board_cell::clear;
+    }
+    return out;
+}
+
+std::vector<grandrounds::color> test_palette(int colors)
+{
+    std::vector<grandrounds::color> out;
+    for (int i{0}; i < colors; i++) {
+        out.push_back({static_cast<std::uint8_t>(i * 30), 0, 128});
+    }
+    return out;
+}
+
+}  // namespace
+
+// Usage: color_bench [repetitions]
+// Times hint extraction and solution checks on large boards in black and
+// white and in four colours, which share a single pass over each line, then
+// solves random colour puzzles.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using microseconds = std::chrono::duration<double, std::micro>;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const int count{args.size() > 1 ? std::atoi(args[1]) : 50};
+
+    for (const int side : {30, 100, 255}) {
+        const auto mono{random_board(side, side, 1, 1)};
+        const auto colored{random_board(side, side, 4, 1)};
+        const auto time{[&](auto work) {
+            const auto start{clock::now()};
+            for (int i{0}; i < count; i++) {
+                work();
+            }
+            return microseconds{clock::now() - start}.count() / count;
+        }};
+
+        std::size_t sink{0};
+        const double mono_hints{time([&] {
+            sink += grandrounds::calculate_row_hints(mono, side).size();
+            sink += grandrounds::calculate_col_hints(mono, side).size();
+        })};
+        const double color_hints{time([&] {
+            std::vector<std::vector<std::uint8_t>> colors;
+            sink += grandrounds::calculate_row_hints(colored, side, colors)
+                        .size();
+            sink += grandrounds::calculate_col_hints(colored, side, colors)
+                        .size();
+        })};
+
+        grandrounds::nonogram_game mono_game{
+            std::make_shared<grandrounds::nonogram_puzzle>(
+                grandrounds::board_coords{side, side}, mono),
+            mono};
+        grandrounds::nonogram_game color_game{
+            std::make_shared<grandrounds::nonogram_puzzle>(
+                grandrounds::board_coords{side, side}, colored,
+                test_palette(4)),
+            colored};
+        const auto check{[&](const grandrounds::nonogram_game& game) {
+            return time([&] {
+                if (grandrounds::check_solution(game)) {
+                    sink++;
+                }
+            });
+        }};
+        const double mono_check{check(mono_game)};
+        const double color_check{check(color_game)};
+
+        fmt::print(
+            "{0}x{0}: hints {1:.1f} us, in colour {2:.1f} us ({3:.2f}x); "
+            "check {4:.1f} us, in colour {5:.1f} us ({6:.2f}x) [{7}]\n",
+            side, mono_hints, color_hints, color_hints / mono_hints,
+            mono_check, color_check, color_check / mono_check, sink);
+    }
+
+    for (const int colors : {2, 4, 8}) {
+        const auto start{clock::now()};
+        std::uint64_t nodes{0};
+        int unique{0};
+        for (int i{0}; i < count; i++) {
+            const grandrounds::nonogram_puzzle puzzle{
+                {25, 20},
+                random_board(25, 20, colors, static_cast<unsigned int>(i)),
+                test_palette(colors)};
+            const auto result{grandrounds::solve_colored_nonogram(puzzle)};
+            nodes += result.stats.nodes;
+            if (result.status == grandrounds::solve_status::unique) {
+                unique++;
+            }
+        }
+        const double elapsed{microseconds{clock::now() - start}.count()};
+        fmt::print("25x20 in {} colours: {:.1f} us a puzzle, {:.1f} nodes, "
+                   "{}/{} unique\n",
+                   colors, elapsed / count,
+                   static_cast<double>(nodes) / count, unique, count);
+    }
+}
@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "fixed_board.hpp"
+#include "synthetic.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+// Usage: fixed_board_bench [puzzles]
+// Runs line propagation from an empty board on random puzzles of each size,
+// once through propagate_lines(), which uses a fixed_board for the common
+// sizes, and once through the dynamic line_solver path.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using microseconds = std::chrono::duration<double, std::micro>;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const int count{args.size() > 1 ? std::atoi(args[1]) : 200};
+
+    for (const auto& [width, height] : {std::pair{10, 10}, std::pair{25, 20},
+                                       std::pair{30, 30}, std::pair{31, 31}}) {
+        std::vector<grandrounds::bench::synthetic_puzzle> puzzles;
+        for (int i{0}; i < count; i++) {
+            puzzles.push_back(grandrounds::bench::make_synthetic_puzzle(
+                width, height, 0.6, static_cast<unsigned int>(i)));
+        }
+        const auto time{[&](auto propagate) {
+            const auto start{clock::now()};
+            for (const auto& puzzle : puzzles) {
+                std::vector<grandrounds::solver_cell> cells(
+                    puzzle.solution.size());
+                static_cast<void>(propagate(puzzle.dimensions,
+                                            puzzle.row_hints,
+                                            puzzle.col_hints, cells));
+            }
+            return microseconds{clock::now() - start}.count() / count;
+        }};
+        const double fixed{time(grandrounds::propagate_lines)};
+        const double dynamic{time(grandrounds::propagate_lines_dynamic)};
+        fmt::print("{}x{}: dispatched {:.1f} us, dynamic {:.1f} us ({:.2f}x)\n",
+                   width, height, fixed, dynamic, dynamic / fixed);
+    }
+}
@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "generator.hpp"
+#include "task_pool.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A photo-sized image of overlapping coloured ellipses on a gradient.
+grandrounds::loaded_image make_photo(unsigned int width,
+                                     unsigned int height,
+                                     unsigned int seed)
+{
+    struct ellipse {
+        double x, y, radius_x, radius_y;
+        std::uint8_t r, g, b;
+    };
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    std::uniform_int_distribution<int> channel{0, 255};
+    std::vector<ellipse> ellipses;
+    for (int i{0}; i < 8; i++) {
+        ellipses.push_back(
+            {unit(rng) * width, unit(rng) * height,
+             (0.05 + 0.2 * unit(rng)) * width,
+             (0.05 + 0.2 * unit(rng)) * height,
+             static_cast<std::uint8_t>(channel(rng)),
+             static_cast<std::uint8_t>(channel(rng)),
+             static_cast<std::uint8_t>(channel(rng))});
+    }
+
+    grandrounds::loaded_image out;
+    out.width = width;
+    out.height = height;
+    out.rgba_pixel_data.reserve(std::size_t{width} * height * 4);
+    for (unsigned int y{0}; y < height; y++) {
+        for (unsigned int x{0}; x < width; x++) {
+            auto shade{static_cast<std::uint8_t>(64 + 160 * x / width)};
+            std::uint8_t r{shade};
+            std::uint8_t g{shade};
+            std::uint8_t b{shade};
+            for (const auto& e : ellipses) {
+                const double dx{(x - e.x) / e.radius_x};
+                const double dy{(y - e.y) / e.radius_y};
+                if (dx * dx + dy * dy < 1.0) {
+                    r = e.r;
+                    g = e.g;
+                    b = e.b;
+                }
+            }
+            out.rgba_pixel_data.insert(out.rgba_pixel_data.end(),
+                                       {r, g, b, 255});
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+// Usage: generator_bench [photos] [threads]
+// Generates 25x20 puzzles from synthetic 1600x1200 photos (default: 64) in
+// memory, single-threaded and then with the given number of threads (default:
+// one per hardware thread).
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const int photo_count{args.size() > 1 ? std::atoi(args[1]) : 64};
+    const unsigned int threads{
+        args.size() > 2 ? static_cast<unsigned int>(std::atoi(args[2]))
+                        : std::max(1U, std::thread::hardware_concurrency())};
+
+    std::vector<grandrounds::loaded_image> photos;
+    for (int i{0}; i < photo_count; i++) {
+        photos.push_back(make_photo(1600, 1200, static_cast<unsigned int>(i)));
+    }
+
+    for (const unsigned int thread_count : {1U, threads}) {
+        std::vector<grandrounds::generated_puzzle> puzzles(photos.size());
+        const auto start{clock::now()};
+        {
+            grandrounds::task_pool pool{thread_count};
+            for (std::size_t i{0}; i < photos.size(); i++) {
+                pool.submit([&, i] {
+                    puzzles[i] = grandrounds::generate_puzzle(photos[i]);
+                });
+            }
+            pool.wait();
+        }
+        const std::chrono::duration<double, std::milli> elapsed{clock::now() -
+                                                                start};
+        const auto unique{std::count_if(
+            puzzles.begin(), puzzles.end(),
+            [](const auto& puzzle) { return puzzle.unique; })};
+        int repairs{0};
+        for (const auto& puzzle : puzzles) {
+            repairs += puzzle.repairs;
+        }
+        fmt::print(
+            "{} threads: {} photos in {:.1f} ms ({:.2f} ms each, {:.0f} per "
+            "minute), {} unique, {} repairs\n",
+            thread_count, photo_count, elapsed.count(),
+            elapsed.count() / photo_count,
+            photo_count * 60000.0 / elapsed.count(), unique, repairs);
+    }
+}
@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "grid.hpp"
+#include "nonogram.hpp"
+#include "range.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// The range-v3 views that grid.hpp used to provide, for comparison.
+namespace views {
+
+template <typename Range>
+auto grid_rows(Range& r, int width) noexcept
+{
+    return r | grandrounds::rv::chunk(width);
+}
+
+template <typename Range>
+auto grid_col(Range& r, int width, int col) noexcept
+{
+    return r | grandrounds::rv::drop(col) | grandrounds::rv::stride(width);
+}
+
+template <typename Range>
+auto grid_cols(Range& r, int width) noexcept
+{
+    return grandrounds::rv::ints(0, width) |
+           grandrounds::rv::transform(
+               [&r, width](int i) { return grid_col(r, width, i); });
+}
+
+}  // namespace views
+
+// The number of filled runs in a line, which touches every cell the way
+// computing its hints does.
+template <typename Line>
+std::size_t count_runs(const Line& line)
+{
+    std::size_t runs{0};
+    bool previous{false};
+    for (const auto cell : line) {
+        const bool filled{cell == grandrounds::board_cell::filled};
+        runs += filled && !previous ? 1 : 0;
+        previous = filled;
+    }
+    return runs;
+}
+
+}  // namespace
+
+// Usage: grid_bench [size] [repeats]
+// Sweeps every row and then every column of a random size x size board
+// (default: 2000x2000), using the old range-v3 views and then grid<T>.  The
+// grid's column sweep is timed both with a fresh transpose, as after an edit,
+// and with the transposed copy already up to date.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const int size{args.size() > 1 ? std::atoi(args[1]) : 2000};
+    const int repeats{args.size() > 2 ? std::atoi(args[2]) : 10};
+    const auto side{static_cast<std::size_t>(size)};
+
+    std::mt19937 rng{1};
+    std::vector<grandrounds::board_cell> cells(side * side);
+    for (auto& cell : cells) {
+        cell = rng() % 2 == 0 ? grandrounds::board_cell::filled
+                              : grandrounds::board_cell::clear;
+    }
+    grandrounds::grid board{side, cells};
+
+    std::size_t checksum{0};
+    const auto time{[&](auto sweep) {
+        const auto start{clock::now()};
+        for (int i{0}; i < repeats; i++) {
+            checksum += sweep();
+        }
+        return milliseconds{clock::now() - start}.count() / repeats;
+    }};
+
+    const double view_rows{time([&] {
+        std::size_t runs{0};
+        for (const auto& row : views::grid_rows(cells, size)) {
+            runs += count_runs(row);
+        }
+        return runs;
+    })};
+    const double view_cols{time([&] {
+        std::size_t runs{0};
+        for (const auto& col : views::grid_cols(cells, size)) {
+            runs += count_runs(col);
+        }
+        return runs;
+    })};
+    const double grid_rows{time([&] {
+        std::size_t runs{0};
+        for (std::size_t y{0}; y < board.height(); y++) {
+            runs += count_runs(std::as_const(board).row(y));
+        }
+        return runs;
+    })};
+    const double grid_cols_fresh{time([&] {
+        board(0, 0) = board(0, 0);  // Marks the transposed copy stale
+        const auto& fixed_board{std::as_const(board)};
+        std::size_t runs{0};
+        for (std::size_t x{0}; x < fixed_board.width(); x++) {
+            runs += count_runs(fixed_board.col(x));
+        }
+        return runs;
+    })};
+    const double grid_cols_cached{time([&] {
+        const auto& fixed_board{std::as_const(board)};
+        std::size_t runs{0};
+        for (std::size_t x{0}; x < fixed_board.width(); x++) {
+            runs += count_runs(fixed_board.col(x));
+        }
+        return runs;
+    })};
+
+    fmt::print("{}x{} board (checksum {})\n", size, size, checksum);
+    fmt::print("  range-v3 views: rows {:.2f} ms, columns {:.2f} ms\n",
+               view_rows, view_cols);
+    fmt::print(
+        "  grid:           rows {:.2f} ms, columns {:.2f} ms "
+        "({:.2f} ms with the transpose already done)\n",
+        grid_rows, grid_cols_fresh, grid_cols_cached);
+}
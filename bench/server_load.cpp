@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "server.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// How often a player clicks, for turning throughput into sessions.  Fast
+// play is a few clicks a second.
+constexpr double inputs_per_player_second{4.0};
+
+}  // namespace
+
+// Usage: server_load [sessions] [seconds] [server threads] [socket]
+// Opens `sessions` connections (default: 64), each of which clicks at random
+// on its frame as soon as the previous frame arrives, for `seconds` (default:
+// 5).  Without a socket path, a server with `server threads` event loops
+// (default: 1) is started in this process.  Reports frames per second per
+// server thread, the sessions per core that would leave at the player click
+// rate, and the latency from sending a click to receiving its frame.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const int sessions{args.size() > 1 ? std::atoi(args[1]) : 64};
+    const int seconds{args.size() > 2 ? std::atoi(args[2]) : 5};
+    const unsigned int server_threads{
+        args.size() > 3 ? static_cast<unsigned int>(std::atoi(args[3])) : 1U};
+
+    std::unique_ptr<grandrounds::puzzle_server> server;
+    std::jthread serving;
+    std::filesystem::path socket_path;
+    if (args.size() > 4) {
+        socket_path = args[4];
+    }
+    else {
+        grandrounds::server_options options;
+        options.socket_path =
+            std::filesystem::temp_directory_path() /
+            fmt::format("grandrounds-load-{}.sock", std::random_device{}());
+        options.threads = server_threads;
+        server = std::make_unique<grandrounds::puzzle_server>(options);
+        serving = std::jthread{[&] { server->run(); }};
+        socket_path = options.socket_path;
+    }
+
+    const auto deadline{clock::now() + std::chrono::seconds{seconds}};
+    std::vector<std::vector<double>> latencies(
+        static_cast<std::size_t>(sessions));
+    {
+        std::vector<std::jthread> players;
+        for (auto& session_latencies : latencies) {
+            players.emplace_back([&, seed = players.size()] {
+                grandrounds::puzzle_client client{socket_path};
+                const auto frame{client.request("open cottontail")};
+                static_cast<void>(frame);
+                std::mt19937 rng{static_cast<unsigned int>(seed)};
+                std::uniform_int_distribution<int> column{0, 99};
+                std::uniform_int_distribution<int> row{0, 39};
+                while (clock::now() < deadline) {
+                    const auto start{clock::now()};
+                    static_cast<void>(client.request(fmt::format(
+                        "press {} {} {}", column(rng), row(rng),
+                        rng() % 2 == 0 ? "left" : "right")));
+                    session_latencies.push_back(
+                        milliseconds{clock::now() - start}.count());
+                }
+            });
+        }
+    }
+    if (server) {
+        server->stop();
+    }
+
+    std::vector<double> all;
+    for (const auto& session_latencies : latencies) {
+        all.insert(all.end(), session_latencies.begin(),
+                   session_latencies.end());
+    }
+    if (all.empty()) {
+        fmt::print("No frames received\n");
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    const auto percentile{[&](double p) {
+        return all[static_cast<std::size_t>(
+            p * static_cast<double>(all.size() - 1))];
+    }};
+    const double frames_per_second{static_cast<double>(all.size()) / seconds};
+    const double per_thread{frames_per_second / server_threads};
+    fmt::print(
+        "{} sessions, {} server thread(s): {:.0f} frames/s, {:.0f} frames/s "
+        "per thread\n",
+        sessions, server_threads, frames_per_second, per_thread);
+    fmt::print("  sessions per core at {:.0f} clicks/s each: {:.0f}\n",
+               inputs_per_player_second, per_thread / inputs_per_player_second);
+    fmt::print(
+        "  input to frame: median {:.3f} ms, 99th percentile {:.3f} ms, max "
+        "{:.3f} ms\n",
+        percentile(0.5), percentile(0.99), all.back());
+}
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "shared_board.hpp"
+#include "synthetic.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Usage: shared_board_bench [updates per thread]
+// Writes random cells of a 30x30 shared board from an increasing number of
+// threads, with one more thread reading the change feed throughout as a
+// viewer would each frame, and reports cell updates per second.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    using seconds = std::chrono::duration<double>;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    const int updates{args.size() > 1 ? std::atoi(args[1]) : 2'000'000};
+
+    const auto puzzle{
+        grandrounds::bench::make_synthetic_puzzle(30, 30, 0.6, 1)};
+    const unsigned int max_threads{
+        std::max(1U, std::thread::hardware_concurrency())};
+    for (unsigned int writers{1}; writers <= max_threads; writers *= 2) {
+        const auto board{
+            std::make_shared<grandrounds::shared_board>(puzzle.solution)};
+        std::atomic<unsigned int> running{writers};
+        std::size_t changes_seen{0};
+        const auto start{clock::now()};
+        {
+            std::vector<std::jthread> threads;
+            for (unsigned int t{0}; t < writers; t++) {
+                threads.emplace_back([&, t] {
+                    std::mt19937 rng{t};
+                    std::uniform_int_distribution<std::size_t> index{
+                        0, board->size() - 1};
+                    std::uniform_int_distribution<int> cell{0, 2};
+                    for (int i{0}; i < updates; i++) {
+                        board->set(index(rng),
+                                   static_cast<grandrounds::board_cell>(
+                                       cell(rng)));
+                    }
+                    running--;
+                });
+            }
+            grandrounds::shared_board::viewer viewer{board};
+            while (running > 0) {
+                changes_seen += viewer.changes().size();
+            }
+        }
+        const double elapsed{seconds{clock::now() - start}.count()};
+        fmt::print(
+            "{} writer(s): {:.1f} million cell updates/s, viewer saw {} "
+            "changes\n",
+            writers, writers * static_cast<double>(updates) / elapsed / 1e6,
+            changes_seen);
+    }
+}
@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "solver.hpp"
+#include "synthetic.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string_view status_name(grandrounds::solve_status status)
+{
+    switch (status) {
+        case grandrounds::solve_status::contradiction:
+            return "none";
+        case grandrounds::solve_status::solved:
+            return "solved";
+        case grandrounds::solve_status::unique:
+            return "unique";
+        case grandrounds::solve_status::multiple:
+            return "multiple";
+    }
+    return "?";
+}
+
+}  // namespace
+
+// Usage: solver_bench [threads...]
+// Solves the synthetic corpus with each thread count given (default: 1, 2, 4
+// and one per hardware thread), checking uniqueness each time, then totals
+// the wall time and search effort for each count.
+int main(int argc, const char** argv)
+{
+    using clock = std::chrono::steady_clock;
+    const std::span args{argv, static_cast<std::size_t>(argc)};
+    std::vector<unsigned int> thread_counts;
+    for (const auto* arg : args.subspan(1)) {
+        thread_counts.push_back(
+            std::max(1U, static_cast<unsigned int>(std::atoi(arg))));
+    }
+    if (thread_counts.empty()) {
+        thread_counts = {1, 2, 4,
+                         std::max(1U, std::thread::hardware_concurrency())};
+    }
+    std::ranges::sort(thread_counts);
+    thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()),
+                        thread_counts.end());
+
+    struct totals {
+        double ms{0};
+        std::uint64_t nodes{0};
+        std::uint64_t probes{0};
+    };
+    std::vector<totals> sums(thread_counts.size());
+
+    fmt::print("{:<26} {:>8} {:>3} {:>9} {:>9} {:>11} {:>10}\n", "puzzle",
+               "status", "thr", "nodes", "probes", "line solves", "ms");
+    for (const auto& puzzle : grandrounds::bench::synthetic_corpus()) {
+        for (std::size_t i{0}; i < thread_counts.size(); i++) {
+            grandrounds::solver_options options;
+            options.threads = thread_counts[i];
+            const auto start{clock::now()};
+            const auto result{grandrounds::solve_nonogram(
+                puzzle.dimensions, puzzle.row_hints, puzzle.col_hints,
+                options)};
+            const std::chrono::duration<double, std::milli> elapsed{
+                clock::now() - start};
+            sums[i].ms += elapsed.count();
+            sums[i].nodes += result.stats.nodes;
+            sums[i].probes += result.stats.probes;
+            fmt::print("{:<26} {:>8} {:>3} {:>9} {:>9} {:>11} {:>10.2f}\n",
+                       puzzle.name, status_name(result.status),
+                       thread_counts[i], result.stats.nodes,
+                       result.stats.probes, result.stats.line_solves,
+                       elapsed.count());
+        }
+    }
+
+    fmt::print("\n{:>3} {:>10} {:>9} {:>9} {:>8}\n", "thr", "total ms",
+               "nodes", "probes", "speedup");
+    for (std::size_t i{0}; i < thread_counts.size(); i++) {
+        fmt::print("{:>3} {:>10.1f} {:>9} {:>9} {:>7.2f}x\n", thread_counts[i],
+                   sums[i].ms, sums[i].nodes, sums[i].probes,
+                   sums[0].ms / sums[i].ms);
+    }
+}
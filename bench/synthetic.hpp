@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include "nonogram.hpp"
+#include "solver.hpp"
+
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace grandrounds::bench {
+
+// A randomly generated puzzle.  Boards filled at around 50% density have short,
+// numerous clues that line propagation makes little headway on, which makes
+// them much harder than hand-drawn puzzles of the same size.
+struct synthetic_puzzle {
+    std::string name;
+    board_coords dimensions;
+    std::vector<board_cell> solution;
+    std::vector<line_hints> row_hints;
+    std::vector<line_hints> col_hints;
+};
+
+inline line_hints synthetic_line_hints(const std::vector<board_cell>& cells,
+                                       std::size_t start,
+                                       std::size_t step,
+                                       std::size_t count)
+{
+    line_hints out;
+    std::uint8_t run{0};
+    for (std::size_t i{0}; i < count; i++) {
+        if (cells[start + i * step] == board_cell::filled) {
+            run++;
+        }
+        else if (run > 0) {
+            out.push_back(run);
+            run = 0;
+        }
+    }
+    if (run > 0) {
+        out.push_back(run);
+    }
+    return out;
+}
+
+inline synthetic_puzzle make_synthetic_puzzle(int width,
+                                              int height,
+                                              double density,
+                                              unsigned int seed)
+{
+    synthetic_puzzle out;
+    out.name = fmt::format("random_{}x{}_d{:.2f}_s{}", width, height, density,
+                           seed);
+    out.dimensions = {width, height};
+    const auto w{static_cast<std::size_t>(width)};
+    const auto h{static_cast<std::size_t>(height)};
+
+    std::mt19937 rng{seed};
+    std::bernoulli_distribution filled{density};
+    out.solution.resize(w * h);
+    for (auto& cell : out.solution) {
+        cell = filled(rng) ? board_cell::filled : board_cell::clear;
+    }
+    for (std::size_t y{0}; y < h; y++) {
+        out.row_hints.push_back(
+            synthetic_line_hints(out.solution, y * w, 1, w));
+    }
+    for (std::size_t x{0}; x < w; x++) {
+        out.col_hints.push_back(synthetic_line_hints(out.solution, x, w, h));
+    }
+    return out;
+}
+
+// The fixed benchmark corpus.  Seeds are fixed so results are comparable
+// between runs and machines.
+inline std::vector<synthetic_puzzle> synthetic_corpus()
+{
+    std::vector<synthetic_puzzle> out;
+    for (const int size : {15, 20, 25, 30, 40}) {
+        for (const double density : {0.5, 0.6}) {
+            for (unsigned int seed{1}; seed <= 3; seed++) {
+                out.push_back(
+                    make_synthetic_puzzle(size, size, density, seed));
+            }
+        }
+    }
+    return out;
+}
+
+}  // namespace grandrounds::bench
+
+#endif  // SYNTHETIC_HPP
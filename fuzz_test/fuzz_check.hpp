@@ -0,0 +1,31 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef FUZZ_CHECK_HPP
+#define FUZZ_CHECK_HPP
+
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+namespace grandrounds {
+
+// Abort, which libFuzzer reports as a crash and saves the input for, if a
+// property the fuzz target expects doesn't hold.
+inline void fuzz_check(bool holds, std::string_view property)
+{
+    if (!holds) {
+        fmt::print(stderr, "Fuzz check failed: {}\n", property);
+        std::abort();
+    }
+}
+
+}  // namespace grandrounds
+
+#endif  // FUZZ_CHECK_HPP
@@ -0,0 +1,153 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "fixed_board.hpp"
+#include "fuzz_check.hpp"
+#include "nonogram.hpp"
+#include "shared_board.hpp"
+#include "solver.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace {
+
+using grandrounds::board_cell;
+
+// Up to 32x32, which covers every size fixed_board specializes.
+constexpr std::size_t max_side{32};
+
+// The plainest possible hints for a line of `length` cells starting at
+// `first`, `stride` apart, for checking the optimised paths against.
+std::vector<std::uint8_t> reference_hints(
+    const std::vector<board_cell>& cells,
+    std::size_t first,
+    std::size_t stride,
+    std::size_t length)
+{
+    std::vector<std::uint8_t> out;
+    std::uint8_t run{0};
+    for (std::size_t i{0}; i < length; i++) {
+        if (cells[first + i * stride] == board_cell::filled) {
+            run++;
+        }
+        else if (run > 0) {
+            out.push_back(run);
+            run = 0;
+        }
+    }
+    if (run > 0) {
+        out.push_back(run);
+    }
+    return out;
+}
+
+}  // namespace
+
+// Differential checks of the optimised hint and solution paths against
+// plain reference versions.  The input is a width and height byte, the
+// solution as one bit per cell, and then edits of three bytes each: x, y and
+// the new cell.  After every edit, the incrementally kept line satisfaction,
+// the shared board's mismatch count and check_solution() must all agree with
+// recalculating from scratch.  The fixed-size line propagation must also
+// match the dynamic version.
+// cppcheck-suppress unusedFunction symbolName=LLVMFuzzerTestOneInput
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data,
+                                      std::size_t size)
+{
+    using namespace grandrounds;
+
+    const std::span input{data, size};
+    if (input.size() < 2) {
+        return 0;
+    }
+    const std::size_t width{1 + input[0] % max_side};
+    const std::size_t height{1 + input[1] % max_side};
+    const std::size_t cells{width * height};
+    auto rest{input.subspan(2)};
+
+    std::vector<board_cell> solution(cells, board_cell::clear);
+    for (std::size_t i{0}; i < cells && i / 8 < rest.size(); i++) {
+        if (((unsigned{rest[i / 8]} >> (i % 8)) & 1U) != 0) {
+            solution[i] = board_cell::filled;
+        }
+    }
+    rest = rest.subspan(std::min(rest.size(), (cells + 7) / 8));
+
+    const board_coords dimensions{static_cast<int>(width),
+                                  static_cast<int>(height)};
+    const auto puzzle{
+        std::make_shared<const nonogram_puzzle>(dimensions, solution)};
+    for (std::size_t y{0}; y < height; y++) {
+        fuzz_check(puzzle->row_hints[y] ==
+                       reference_hints(solution, y * width, 1, width),
+                   "row hints match the reference");
+    }
+    for (std::size_t x{0}; x < width; x++) {
+        fuzz_check(puzzle->col_hints[x] ==
+                       reference_hints(solution, x, width, height),
+                   "column hints match the reference");
+    }
+
+    std::vector<solver_cell> fixed(cells, solver_cell::unknown);
+    std::vector<solver_cell> dynamic(cells, solver_cell::unknown);
+    fuzz_check(propagate_lines(dimensions, puzzle->row_hints,
+                               puzzle->col_hints, fixed) ==
+                       propagate_lines_dynamic(dimensions, puzzle->row_hints,
+                                               puzzle->col_hints, dynamic) &&
+                   fixed == dynamic,
+               "fixed-size propagation matches the dynamic version");
+
+    nonogram_game game{puzzle, std::vector<board_cell>(cells)};
+    update_satisfied_hints(game);
+    shared_board shared{solution};
+
+    const auto check_board{[&] {
+        std::size_t mismatches{0};
+        for (std::size_t i{0}; i < cells; i++) {
+            if ((game.board[i] == board_cell::filled) !=
+                (solution[i] == board_cell::filled)) {
+                mismatches++;
+            }
+        }
+        for (std::size_t y{0}; y < height; y++) {
+            fuzz_check(game.row_satisfied[y] ==
+                           (reference_hints(game.board, y * width, 1, width) ==
+                            puzzle->row_hints[y]),
+                       "row satisfaction matches the reference");
+        }
+        for (std::size_t x{0}; x < width; x++) {
+            fuzz_check(game.col_satisfied[x] ==
+                           (reference_hints(game.board, x, width, height) ==
+                            puzzle->col_hints[x]),
+                       "column satisfaction matches the reference");
+        }
+        fuzz_check(check_solution(game) == (mismatches == 0),
+                   "check_solution() matches the reference");
+        fuzz_check(shared.mismatches() == mismatches,
+                   "the shared board counts mismatches exactly");
+        fuzz_check(shared.solved() == (mismatches == 0),
+                   "the shared board is solved exactly when the game is");
+        fuzz_check(shared.snapshot() == game.board,
+                   "the shared board holds the game's cells");
+    }};
+    check_board();
+
+    for (; rest.size() >= 3; rest = rest.subspan(3)) {
+        const std::size_t x{rest[0] % width};
+        const std::size_t y{rest[1] % height};
+        const auto cell{static_cast<board_cell>(rest[2] % 3)};
+        set_cell(game, {static_cast<int>(x), static_cast<int>(y)}, cell);
+        shared.set(y * width + x, cell);
+        check_board();
+    }
+    return 0;
+}
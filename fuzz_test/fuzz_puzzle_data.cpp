@@ -0,0 +1,28 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "nonogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Puzzle data files come from directories that anyone can edit, so whatever
+// they hold must either parse or throw json_error.
+// cppcheck-suppress unusedFunction symbolName=LLVMFuzzerTestOneInput
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data,
+                                      std::size_t size)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const std::string_view text{reinterpret_cast<const char*>(data), size};
+    try {
+        static_cast<void>(grandrounds::parse_puzzle_data(text));
+    }
+    catch (const grandrounds::json_error&) {
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "fuzz_check.hpp"
+#include "nonogram.hpp"
+#include "solver.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Puzzles up to this many cells are solved too.  Larger ones could take the
+// solver's search longer than the per-input time limit without anything
+// being wrong.
+constexpr int max_solved_cells{100};
+
+}  // namespace
+
+// Nonogram images take the same path as a puzzle loaded from an edited
+// puzzle directory: decoded to a solution, then turned into hints.  Anything
+// that decodes must make a puzzle that its own solution solves.
+// cppcheck-suppress unusedFunction symbolName=LLVMFuzzerTestOneInput
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data,
+                                      std::size_t size)
+{
+    using namespace grandrounds;
+
+    board_coords dimensions;
+    std::vector<board_cell> solution;
+    try {
+        solution = solution_from_png({data, size}, dimensions);
+    }
+    catch (const file_error&) {
+        return 0;
+    }
+
+    const auto puzzle{
+        std::make_shared<const nonogram_puzzle>(dimensions, solution)};
+    fuzz_check(std::cmp_equal(puzzle->row_hints.size(), dimensions.y) &&
+                   std::cmp_equal(puzzle->col_hints.size(), dimensions.x),
+               "one hint list per line");
+
+    nonogram_game game{puzzle, puzzle->solution};
+    update_satisfied_hints(game);
+    fuzz_check(check_solution(game), "the solution solves its puzzle");
+    const auto all_true{[](const std::vector<bool>& flags) {
+        return std::all_of(flags.begin(), flags.end(),
+                           [](bool flag) { return flag; });
+    }};
+    fuzz_check(all_true(game.row_satisfied) && all_true(game.col_satisfied),
+               "the solution satisfies every hint");
+
+    if (dimensions.x * dimensions.y <= max_solved_cells) {
+        const auto result{solve_nonogram(*puzzle)};
+        fuzz_check(result.status != solve_status::contradiction,
+                   "the solver finds a solution");
+        for (const auto& found : result.solutions) {
+            fuzz_check(calculate_row_hints(found, dimensions.x) ==
+                               puzzle->row_hints &&
+                           calculate_col_hints(found, dimensions.x) ==
+                               puzzle->col_hints,
+                       "the solver's solutions have the puzzle's hints");
+        }
+        if (result.status == solve_status::unique) {
+            fuzz_check(result.solutions.front() == puzzle->solution,
+                       "a unique solution is the puzzle's own");
+        }
+    }
+    return 0;
+}
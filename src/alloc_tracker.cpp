@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "alloc_tracker.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace grandrounds {
+
+namespace {
+
+// Plain thread_local data with constant initialization, so that operator new
+// can use it at any point in a thread's life, including before main() and
+// while the thread's other thread_locals are being constructed.
+constinit thread_local allocation_tally counts{};
+constinit thread_local allocation_tag current_tag{allocation_tag::other};
+
+}  // namespace
+
+std::string_view allocation_tag_name(allocation_tag tag) noexcept
+{
+    switch (tag) {
+        case allocation_tag::other:
+            return "other";
+        case allocation_tag::load:
+            return "load";
+        case allocation_tag::hints:
+            return "hints";
+        case allocation_tag::render:
+            return "render";
+        case allocation_tag::event:
+            return "event";
+    }
+    return "unknown";
+}
+
+allocation_tally thread_allocations() noexcept
+{
+    return counts;
+}
+
+allocation_scope::allocation_scope(allocation_tag tag) noexcept
+    : previous_{current_tag}
+{
+    current_tag = tag;
+}
+
+allocation_scope::~allocation_scope()
+{
+    current_tag = previous_;
+}
+
+allocation_counts allocation_meter::since() const noexcept
+{
+    const auto now{thread_allocations()};
+    allocation_counts out;
+    for (std::size_t i{0}; i < allocation_tag_count; i++) {
+        out += now[i];
+        out -= start_[i];
+    }
+    return out;
+}
+
+}  // namespace grandrounds
+
+#ifdef GRANDROUNDS_TRACK_ALLOCATIONS
+
+// The replacements below count and then defer to malloc() and free().  The
+// nothrow forms of new call these, so they needn't be replaced.
+// NOLINTBEGIN(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+
+namespace {
+
+void count_allocation(std::size_t size) noexcept
+{
+    auto& tally{grandrounds::counts[static_cast<std::size_t>(
+        grandrounds::current_tag)]};
+    tally.allocations++;
+    tally.bytes += size;
+}
+
+void count_free(void* ptr) noexcept
+{
+    if (ptr != nullptr) {
+        grandrounds::counts[static_cast<std::size_t>(grandrounds::current_tag)]
+            .frees++;
+    }
+}
+
+void* allocate(std::size_t size)
+{
+    count_allocation(size);
+    for (;;) {
+        if (void* ptr{std::malloc(size == 0 ? 1 : size)}) {
+            return ptr;
+        }
+        const auto handler{std::get_new_handler()};
+        if (handler == nullptr) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+void* allocate_aligned(std::size_t size, std::align_val_t alignment)
+{
+    count_allocation(size);
+    const auto align{static_cast<std::size_t>(alignment)};
+    // aligned_alloc() needs the size to be a non-zero multiple of the
+    // alignment.
+    const auto rounded{std::max(align, (size + align - 1) / align * align)};
+    for (;;) {
+        if (void* ptr{std::aligned_alloc(align, rounded)}) {
+            return ptr;
+        }
+        const auto handler{std::get_new_handler()};
+        if (handler == nullptr) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocate_aligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t /*alignment*/) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr,
+                     std::size_t /*size*/,
+                     std::align_val_t /*alignment*/) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr,
+                       std::size_t /*size*/,
+                       std::align_val_t /*alignment*/) noexcept
+{
+    count_free(ptr);
+    std::free(ptr);
+}
+
+// NOLINTEND(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+
+#endif  // GRANDROUNDS_TRACK_ALLOCATIONS
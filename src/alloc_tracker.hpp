@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ALLOC_TRACKER_HPP
+#define ALLOC_TRACKER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Counts heap allocations by what the program was doing when it made them.
+// Configuring with ENABLE_ALLOCATION_TRACKING replaces the global operator
+// new and delete with versions that count into per-thread counters, under the
+// tag of the innermost allocation_scope on that thread.  Without it, scopes
+// cost nothing and every count stays zero.
+namespace grandrounds {
+
+#ifdef GRANDROUNDS_TRACK_ALLOCATIONS
+inline constexpr bool allocation_tracking_enabled{true};
+#else
+inline constexpr bool allocation_tracking_enabled{false};
+#endif
+
+enum class allocation_tag : std::uint8_t {
+    other,   // Outside any scope
+    load,    // Loading a puzzle
+    hints,   // Calculating a puzzle's hints
+    render,  // Rendering a frame
+    event,   // Handling an input event
+};
+inline constexpr std::size_t allocation_tag_count{5};
+
+[[nodiscard]] std::string_view allocation_tag_name(allocation_tag tag) noexcept;
+
+struct allocation_counts {
+    std::uint64_t allocations{0};
+    std::uint64_t bytes{0};  // Requested by those allocations
+    std::uint64_t frees{0};
+
+    allocation_counts& operator+=(const allocation_counts& other) noexcept
+    {
+        allocations += other.allocations;
+        bytes += other.bytes;
+        frees += other.frees;
+        return *this;
+    }
+
+    allocation_counts& operator-=(const allocation_counts& other) noexcept
+    {
+        allocations -= other.allocations;
+        bytes -= other.bytes;
+        frees -= other.frees;
+        return *this;
+    }
+};
+
+using allocation_tally = std::array<allocation_counts, allocation_tag_count>;
+
+// This thread's counts since it started.
+[[nodiscard]] allocation_tally thread_allocations() noexcept;
+
+// Attributes this thread's allocations to `tag` until destroyed.  Scopes
+// nest; the previous tag applies again when an inner scope ends.
+class allocation_scope {
+   public:
+    explicit allocation_scope(allocation_tag tag) noexcept;
+    ~allocation_scope();
+
+    allocation_scope(const allocation_scope&) = delete;
+    allocation_scope& operator=(const allocation_scope&) = delete;
+    allocation_scope(allocation_scope&&) = delete;
+    allocation_scope& operator=(allocation_scope&&) = delete;
+
+   private:
+    allocation_tag previous_;
+};
+
+// Measures this thread's allocations from construction, for checking a
+// piece of work against a budget.
+class allocation_meter {
+   public:
+    allocation_meter() noexcept : start_{thread_allocations()} {}
+
+    [[nodiscard]] allocation_counts since(allocation_tag tag) const noexcept
+    {
+        auto out{thread_allocations()[static_cast<std::size_t>(tag)]};
+        out -= start_[static_cast<std::size_t>(tag)];
+        return out;
+    }
+
+    // Under every tag.
+    [[nodiscard]] allocation_counts since() const noexcept;
+
+   private:
+    allocation_tally start_;
+};
+
+}  // namespace grandrounds
+
+#endif  // ALLOC_TRACKER_HPP
@@ -0,0 +1,240 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "assistant.hpp"
+
+#include <gsl/narrow>
+
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+solver_cell to_solver_cell(board_cell cell) noexcept
+{
+    switch (cell) {
+        case board_cell::filled:
+            return solver_cell::filled;
+        case board_cell::marked:
+            return solver_cell::empty;
+        default:
+            return solver_cell::unknown;
+    }
+}
+
+// Each line's deductions, kept between analyses so that after an edit only
+// the row and column through each changed cell are solved again.
+class board_analyzer {
+   public:
+    board_analyzer(board_coords dimensions,
+                   const std::vector<line_hints>& row_hints,
+                   const std::vector<line_hints>& col_hints)
+        : width_{gsl::narrow<std::size_t>(dimensions.x)},
+          height_{gsl::narrow<std::size_t>(dimensions.y)},
+          row_hints_{row_hints},
+          col_hints_{col_hints},
+          rows_(height_),
+          cols_(width_)
+    {
+    }
+
+    std::optional<assist_result> analyze(const std::vector<board_cell>& board,
+                                         const std::function<bool()>& cancelled)
+    {
+        mark_changes(board);
+        for (std::size_t y{0}; y < height_; y++) {
+            if (rows_[y].stale) {
+                if (cancelled && cancelled()) {
+                    return std::nullopt;
+                }
+                solve(rows_[y], row_hints_[y], y * width_, 1, width_);
+            }
+        }
+        for (std::size_t x{0}; x < width_; x++) {
+            if (cols_[x].stale) {
+                if (cancelled && cancelled()) {
+                    return std::nullopt;
+                }
+                solve(cols_[x], col_hints_[x], x, width_, height_);
+            }
+        }
+
+        assist_result out;
+        out.cells.assign(board_.size(), assist_hint::none);
+        for (std::size_t y{0}; y < height_; y++) {
+            apply(rows_[y], out, y * width_, 1);
+        }
+        for (std::size_t x{0}; x < width_; x++) {
+            apply(cols_[x], out, x, width_);
+        }
+        return out;
+    }
+
+   private:
+    struct line_state {
+        bool stale{true};  // Doesn't yet reflect board_
+        bool conflict{false};
+        std::vector<solver_cell> cells;
+    };
+
+    // Remember the new board and mark the lines through changed cells stale.
+    // Lines stay stale until solved, so a cancelled analysis loses nothing.
+    void mark_changes(const std::vector<board_cell>& board)
+    {
+        if (board_.size() != board.size()) {
+            board_ = board;
+            for (auto& line : rows_) {
+                line.stale = true;
+            }
+            for (auto& line : cols_) {
+                line.stale = true;
+            }
+            return;
+        }
+        for (std::size_t i{0}; i < board.size(); i++) {
+            if (board_[i] != board[i]) {
+                board_[i] = board[i];
+                rows_[i / width_].stale = true;
+                cols_[i % width_].stale = true;
+            }
+        }
+    }
+
+    void solve(line_state& state,
+               const line_hints& hints,
+               std::size_t start,
+               std::size_t step,
+               std::size_t count)
+    {
+        state.cells.clear();
+        for (std::size_t i{0}; i < count; i++) {
+            state.cells.push_back(to_solver_cell(board_[start + i * step]));
+        }
+        state.conflict = !solver_.solve(hints, state.cells);
+        state.stale = false;
+    }
+
+    void apply(const line_state& state,
+               assist_result& out,
+               std::size_t start,
+               std::size_t step) const
+    {
+        for (std::size_t i{0}; i < state.cells.size(); i++) {
+            const std::size_t index{start + i * step};
+            if (state.conflict) {
+                if (board_[index] != board_cell::clear) {
+                    out.cells[index] = assist_hint::conflict;
+                }
+                continue;
+            }
+            if (board_[index] != board_cell::clear ||
+                state.cells[i] == solver_cell::unknown) {
+                continue;
+            }
+            const auto hint{state.cells[i] == solver_cell::filled
+                                ? assist_hint::filled
+                                : assist_hint::empty};
+            auto& cell{out.cells[index]};
+            cell = cell == assist_hint::none || cell == hint
+                       ? hint
+                       : assist_hint::conflict;
+        }
+    }
+
+    std::size_t width_;
+    std::size_t height_;
+    const std::vector<line_hints>& row_hints_;
+    const std::vector<line_hints>& col_hints_;
+    std::vector<board_cell> board_;
+    std::vector<line_state> rows_;
+    std::vector<line_state> cols_;
+    line_solver solver_;
+};
+
+}  // namespace
+
+std::optional<assist_result> analyze_board(
+    board_coords dimensions,
+    const std::vector<line_hints>& row_hints,
+    const std::vector<line_hints>& col_hints,
+    const std::vector<board_cell>& board,
+    const std::function<bool()>& cancelled)
+{
+    return board_analyzer{dimensions, row_hints, col_hints}.analyze(board,
+                                                                    cancelled);
+}
+
+hint_assistant::hint_assistant(board_coords dimensions,
+                               std::vector<line_hints> row_hints,
+                               std::vector<line_hints> col_hints,
+                               std::function<void()> on_result)
+    : dimensions_{dimensions},
+      row_hints_{std::move(row_hints)},
+      col_hints_{std::move(col_hints)},
+      on_result_{std::move(on_result)},
+      worker_{[this](const std::stop_token& stop) { run(stop); }}
+{
+}
+
+void hint_assistant::analyze(const std::vector<board_cell>& board)
+{
+    {
+        const std::lock_guard lock{mutex_};
+        pending_ = board;
+        has_pending_ = true;
+        // Bumped under the lock so that the worker always sees the
+        // generation that goes with the board it takes.
+        generation_++;
+    }
+    wake_.notify_one();
+}
+
+std::shared_ptr<const assist_result> hint_assistant::latest() const
+{
+    const std::lock_guard lock{mutex_};
+    return latest_;
+}
+
+std::uint64_t hint_assistant::generation() const noexcept
+{
+    return generation_.load();
+}
+
+void hint_assistant::run(const std::stop_token& stop)
+{
+    board_analyzer analyzer{dimensions_, row_hints_, col_hints_};
+    std::vector<board_cell> board;
+    for (;;) {
+        std::uint64_t generation{0};
+        {
+            std::unique_lock lock{mutex_};
+            if (!wake_.wait(lock, stop, [this] { return has_pending_; })) {
+                return;
+            }
+            board.swap(pending_);
+            has_pending_ = false;
+            generation = generation_.load();
+        }
+
+        auto result{analyzer.analyze(board, [&] {
+            return stop.stop_requested() ||
+                   generation_.load(std::memory_order_relaxed) != generation;
+        })};
+        if (!result) {
+            continue;
+        }
+        result->generation = generation;
+        {
+            const std::lock_guard lock{mutex_};
+            latest_ = std::make_shared<const assist_result>(std::move(*result));
+        }
+        on_result_();
+    }
+}
+
+}  // namespace grandrounds
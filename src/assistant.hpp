@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef ASSISTANT_HPP
+#define ASSISTANT_HPP
+
+#include "nonogram.hpp"
+#include "solver.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace grandrounds {
+
+enum class assist_hint : std::uint8_t {
+    none,
+    filled,   // A clear cell that its row or column shows must be filled
+    empty,    // A clear cell that its row or column shows must be empty
+    conflict  // A cell in a line the board no longer fits, or one that its
+              // row and column disagree about
+};
+
+struct assist_result {
+    std::uint64_t generation{0};  // Of the board that was analysed
+    std::vector<assist_hint> cells;
+};
+
+// Solve each row and column of a board on its own, treating filled cells as
+// filled, marked cells as empty and clear cells as unknown.  These are the
+// deductions a player could make next by looking at a single line.  Returns
+// nullopt if `cancelled` returns true, which is checked between lines.
+std::optional<assist_result> analyze_board(
+    board_coords dimensions,
+    const std::vector<line_hints>& row_hints,
+    const std::vector<line_hints>& col_hints,
+    const std::vector<board_cell>& board,
+    const std::function<bool()>& cancelled = {});
+
+// Runs analyze_board() on a worker thread, re-solving only the lines that
+// changed since the last board it saw.  Each call to analyze() abandons any
+// analysis in progress and starts on the new board; when an analysis
+// finishes, `on_result` is called on the worker thread, and latest() returns
+// the result without waiting for the worker.
+class hint_assistant {
+   public:
+    hint_assistant(board_coords dimensions,
+                   std::vector<line_hints> row_hints,
+                   std::vector<line_hints> col_hints,
+                   std::function<void()> on_result);
+    ~hint_assistant() = default;
+
+    hint_assistant(const hint_assistant&) = delete;
+    hint_assistant& operator=(const hint_assistant&) = delete;
+    hint_assistant(hint_assistant&&) = delete;
+    hint_assistant& operator=(hint_assistant&&) = delete;
+
+    void analyze(const std::vector<board_cell>& board);
+
+    // The most recent finished analysis, or null if there isn't one yet.  It
+    // describes the current board if its generation matches generation().
+    [[nodiscard]] std::shared_ptr<const assist_result> latest() const;
+    [[nodiscard]] std::uint64_t generation() const noexcept;
+
+   private:
+    void run(const std::stop_token& stop);
+
+    board_coords dimensions_;
+    std::vector<line_hints> row_hints_;
+    std::vector<line_hints> col_hints_;
+    std::function<void()> on_result_;
+    mutable std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::vector<board_cell> pending_;  // Guarded by mutex_
+    bool has_pending_{false};          // Guarded by mutex_
+    std::shared_ptr<const assist_result> latest_;  // Guarded by mutex_
+    std::atomic<std::uint64_t> generation_{0};
+    std::jthread worker_;  // Last, so it stops before the rest is destroyed
+};
+
+}  // namespace grandrounds
+
+#endif  // ASSISTANT_HPP
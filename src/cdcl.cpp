@@ -0,0 +1,520 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "cdcl.hpp"
+
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+constexpr auto npos{static_cast<std::size_t>(-1)};
+constexpr double activity_decay{0.95};
+constexpr double activity_limit{1e100};
+constexpr std::uint64_t restart_unit{100};
+constexpr std::uint64_t first_reduction{2000};
+constexpr std::uint64_t reduction_increment{300};
+constexpr std::uint32_t glue_clause{2};  // Block distance always kept
+
+// The Luby sequence (1, 1, 2, 1, 1, 2, 4, 1, ...) gives restart intervals that
+// are provably within a log factor of the best fixed schedule.
+std::uint64_t luby(std::uint64_t i)
+{
+    std::uint64_t size{1};
+    std::uint64_t power{0};
+    while (size < i + 1) {
+        size = 2 * size + 1;
+        power++;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) / 2;
+        power--;
+        i %= size;
+    }
+    return std::uint64_t{1} << power;
+}
+
+}  // namespace
+
+cdcl_solver::cdcl_solver(int variable_count)
+{
+    for (int i{0}; i < variable_count; i++) {
+        new_variable();
+    }
+}
+
+int cdcl_solver::new_variable()
+{
+    const std::size_t v{assigns_.size()};
+    assigns_.push_back(0);
+    level_.push_back(0);
+    reason_.push_back(no_reason);
+    polarity_.push_back(1);
+    seen_.push_back(0);
+    activity_.push_back(0.0);
+    heap_index_.push_back(npos);
+    watches_.emplace_back();
+    watches_.emplace_back();
+    heap_insert(v);
+    return gsl::narrow<int>(v + 1);
+}
+
+int cdcl_solver::variable_count() const noexcept
+{
+    return static_cast<int>(assigns_.size());
+}
+
+cdcl_solver::lit cdcl_solver::from_dimacs(int literal) noexcept
+{
+    const auto v{static_cast<lit>(std::abs(literal) - 1)};
+    return 2 * v + (literal < 0 ? 1U : 0U);
+}
+
+std::int8_t cdcl_solver::value(lit l) const noexcept
+{
+    const std::int8_t v{assigns_[var(l)]};
+    return (l & 1U) != 0 ? static_cast<std::int8_t>(-v) : v;
+}
+
+int cdcl_solver::decision_level() const noexcept
+{
+    return static_cast<int>(trail_limits_.size());
+}
+
+bool cdcl_solver::add_clause(std::span<const int> literals)
+{
+    if (unsatisfiable_) {
+        return false;
+    }
+    backtrack(0);
+
+    std::vector<lit> clause;
+    for (const int literal : literals) {
+        if (literal == 0 || std::abs(literal) > variable_count()) {
+            throw std::invalid_argument{"Literal out of range"};
+        }
+        clause.push_back(from_dimacs(literal));
+    }
+    std::sort(clause.begin(), clause.end());
+    clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+
+    // Drop literals already false at the root, and the whole clause if it is
+    // already satisfied or is a tautology.
+    std::vector<lit> kept;
+    for (std::size_t i{0}; i < clause.size(); i++) {
+        if (value(clause[i]) > 0 ||
+            (i + 1 < clause.size() && clause[i + 1] == (clause[i] ^ 1U))) {
+            return true;
+        }
+        if (value(clause[i]) == 0) {
+            kept.push_back(clause[i]);
+        }
+    }
+
+    if (kept.empty()) {
+        unsatisfiable_ = true;
+        return false;
+    }
+    if (kept.size() == 1) {
+        enqueue(kept[0], no_reason);
+        if (propagate() != no_reason) {
+            unsatisfiable_ = true;
+            return false;
+        }
+        return true;
+    }
+    clauses_.push_back(std::move(kept));
+    deleted_.push_back(0);
+    attach(gsl::narrow<clause_ref>(clauses_.size() - 1));
+    return true;
+}
+
+void cdcl_solver::attach(clause_ref c)
+{
+    const auto& clause{clauses_[c]};
+    watches_[clause[0]].push_back(c);
+    watches_[clause[1]].push_back(c);
+}
+
+void cdcl_solver::enqueue(lit l, clause_ref reason)
+{
+    const std::size_t v{var(l)};
+    assigns_[v] = (l & 1U) != 0 ? -1 : 1;
+    level_[v] = decision_level();
+    reason_[v] = reason;
+    trail_.push_back(l);
+}
+
+// Returns the conflicting clause, or no_reason.
+cdcl_solver::clause_ref cdcl_solver::propagate()
+{
+    while (propagated_ < trail_.size()) {
+        const lit false_lit{trail_[propagated_++] ^ 1U};
+        stats_.propagations++;
+        auto& watchers{watches_[false_lit]};
+        std::size_t kept{0};
+        for (std::size_t i{0}; i < watchers.size(); i++) {
+            const clause_ref c{watchers[i]};
+            if (deleted_[c] != 0) {
+                continue;
+            }
+            auto& clause{clauses_[c]};
+            // Keep the false literal in position 1.
+            if (clause[0] == false_lit) {
+                std::swap(clause[0], clause[1]);
+            }
+            if (value(clause[0]) > 0) {
+                watchers[kept++] = c;
+                continue;
+            }
+            bool moved{false};
+            for (std::size_t k{2}; k < clause.size(); k++) {
+                if (value(clause[k]) >= 0) {
+                    std::swap(clause[1], clause[k]);
+                    watches_[clause[1]].push_back(c);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) {
+                continue;
+            }
+            watchers[kept++] = c;
+            if (value(clause[0]) < 0) {
+                while (++i < watchers.size()) {
+                    watchers[kept++] = watchers[i];
+                }
+                watchers.resize(kept);
+                propagated_ = trail_.size();
+                return c;
+            }
+            enqueue(clause[0], c);
+        }
+        watchers.resize(kept);
+    }
+    return no_reason;
+}
+
+// First-UIP conflict analysis.  On return learned[0] is the asserting literal
+// and learned[1] (if any) is a literal from the backjump level.
+void cdcl_solver::analyze(clause_ref conflict,
+                          std::vector<lit>& learned,
+                          int& backjump_level)
+{
+    learned.assign(1, 0);
+    int open{0};
+    std::size_t index{trail_.size()};
+    lit uip{0};
+    bool first{true};
+    clause_ref c{conflict};
+    do {
+        const auto& clause{clauses_[c]};
+        // A reason clause's first literal is the one it implied.
+        for (std::size_t i{first ? 0U : 1U}; i < clause.size(); i++) {
+            const std::size_t v{var(clause[i])};
+            if (seen_[v] != 0 || level_[v] == 0) {
+                continue;
+            }
+            seen_[v] = 1;
+            bump(v);
+            if (level_[v] == decision_level()) {
+                open++;
+            }
+            else {
+                learned.push_back(clause[i]);
+            }
+        }
+        first = false;
+        do {
+            index--;
+        } while (seen_[var(trail_[index])] == 0);
+        uip = trail_[index];
+        c = reason_[var(uip)];
+        seen_[var(uip)] = 0;
+        open--;
+    } while (open > 0);
+    learned[0] = uip ^ 1U;
+
+    // Drop literals implied by the others: a literal whose reason clause
+    // contains only literals already in the learned clause adds nothing.
+    removed_.clear();
+    std::size_t kept{1};
+    for (std::size_t i{1}; i < learned.size(); i++) {
+        if (redundant(learned[i])) {
+            removed_.push_back(learned[i]);
+        }
+        else {
+            learned[kept++] = learned[i];
+        }
+    }
+    learned.resize(kept);
+    for (const lit l : removed_) {
+        seen_[var(l)] = 0;
+    }
+
+    backjump_level = 0;
+    std::size_t max_i{1};
+    for (std::size_t i{1}; i < learned.size(); i++) {
+        seen_[var(learned[i])] = 0;
+        if (level_[var(learned[i])] > backjump_level) {
+            backjump_level = level_[var(learned[i])];
+            max_i = i;
+        }
+    }
+    if (learned.size() > 1) {
+        std::swap(learned[1], learned[max_i]);
+    }
+}
+
+bool cdcl_solver::redundant(lit l) const
+{
+    const clause_ref reason{reason_[var(l)]};
+    if (reason == no_reason) {
+        return false;
+    }
+    const auto& clause{clauses_[reason]};
+    return std::all_of(clause.begin() + 1, clause.end(), [&](lit other) {
+        return seen_[var(other)] != 0 || level_[var(other)] == 0;
+    });
+}
+
+// The number of distinct decision levels in a clause.  Clauses spanning few
+// levels ("glue" clauses) tend to keep being useful.
+std::uint32_t cdcl_solver::block_distance(const std::vector<lit>& c)
+{
+    stamp_++;
+    std::uint32_t distance{0};
+    for (const lit l : c) {
+        const auto level{gsl::narrow<std::size_t>(level_[var(l)])};
+        if (level >= level_stamp_.size()) {
+            level_stamp_.resize(level + 1, 0);
+        }
+        if (level_stamp_[level] != stamp_) {
+            level_stamp_[level] = stamp_;
+            distance++;
+        }
+    }
+    return distance;
+}
+
+// Delete the worse half of the learned clauses, sparing glue clauses and any
+// clause that is currently the reason for an assignment.
+void cdcl_solver::reduce_learned()
+{
+    std::sort(learned_.begin(), learned_.end(),
+              [](const auto& a, const auto& b) {
+                  return a.block_distance > b.block_distance;
+              });
+    const std::size_t target{learned_.size() / 2};
+    std::vector<learned_clause> kept;
+    std::size_t removed{0};
+    for (const auto& entry : learned_) {
+        const auto& clause{clauses_[entry.ref]};
+        const bool locked{value(clause[0]) > 0 &&
+                          reason_[var(clause[0])] == entry.ref};
+        if (removed < target && !locked &&
+            entry.block_distance > glue_clause) {
+            deleted_[entry.ref] = 1;
+            clauses_[entry.ref] = {};
+            removed++;
+        }
+        else {
+            kept.push_back(entry);
+        }
+    }
+    learned_ = std::move(kept);
+    stats_.deleted_clauses += removed;
+}
+
+void cdcl_solver::backtrack(int level)
+{
+    if (decision_level() <= level) {
+        return;
+    }
+    const std::size_t keep{trail_limits_[gsl::narrow<std::size_t>(level)]};
+    for (std::size_t i{trail_.size()}; i-- > keep;) {
+        const std::size_t v{var(trail_[i])};
+        polarity_[v] = static_cast<std::uint8_t>(trail_[i] & 1U);
+        assigns_[v] = 0;
+        reason_[v] = no_reason;
+        heap_insert(v);
+    }
+    trail_.resize(keep);
+    trail_limits_.resize(gsl::narrow<std::size_t>(level));
+    propagated_ = keep;
+}
+
+bool cdcl_solver::pick_branch(lit& out)
+{
+    while (!heap_.empty()) {
+        const std::size_t v{heap_pop()};
+        if (assigns_[v] == 0) {
+            out = gsl::narrow<lit>(2 * v + polarity_[v]);
+            return true;
+        }
+    }
+    return false;
+}
+
+void cdcl_solver::bump(std::size_t v)
+{
+    activity_[v] += activity_increment_;
+    if (activity_[v] > activity_limit) {
+        for (auto& a : activity_) {
+            a /= activity_limit;
+        }
+        activity_increment_ /= activity_limit;
+    }
+    if (heap_index_[v] != npos) {
+        heap_sift_up(heap_index_[v]);
+    }
+}
+
+bool cdcl_solver::solve()
+{
+    if (unsatisfiable_) {
+        return false;
+    }
+    backtrack(0);
+    if (propagate() != no_reason) {
+        unsatisfiable_ = true;
+        return false;
+    }
+
+    std::vector<lit> learned;
+    std::uint64_t next_reduction{stats_.conflicts + first_reduction};
+    std::uint64_t reductions{0};
+    std::uint64_t restart{0};
+    std::uint64_t conflicts_until_restart{restart_unit * luby(restart)};
+    while (true) {
+        const clause_ref conflict{propagate()};
+        if (conflict != no_reason) {
+            stats_.conflicts++;
+            if (decision_level() == 0) {
+                unsatisfiable_ = true;
+                return false;
+            }
+            int backjump_level{0};
+            analyze(conflict, learned, backjump_level);
+            backtrack(backjump_level);
+            if (learned.size() == 1) {
+                enqueue(learned[0], no_reason);
+            }
+            else {
+                clauses_.push_back(learned);
+                deleted_.push_back(0);
+                const auto c{gsl::narrow<clause_ref>(clauses_.size() - 1)};
+                attach(c);
+                learned_.push_back({c, block_distance(learned)});
+                enqueue(learned[0], c);
+                stats_.learned_clauses++;
+            }
+            activity_increment_ /= activity_decay;
+            if (conflicts_until_restart > 0) {
+                conflicts_until_restart--;
+            }
+            continue;
+        }
+
+        if (stats_.conflicts >= next_reduction) {
+            reduce_learned();
+            next_reduction = stats_.conflicts + first_reduction +
+                             reduction_increment * ++reductions;
+        }
+
+        if (conflicts_until_restart == 0) {
+            stats_.restarts++;
+            backtrack(0);
+            conflicts_until_restart = restart_unit * luby(++restart);
+            continue;
+        }
+
+        lit decision{0};
+        if (!pick_branch(decision)) {
+            model_ = assigns_;
+            return true;
+        }
+        stats_.decisions++;
+        trail_limits_.push_back(trail_.size());
+        enqueue(decision, no_reason);
+    }
+}
+
+bool cdcl_solver::model_value(int variable) const
+{
+    return model_.at(gsl::narrow<std::size_t>(variable - 1)) > 0;
+}
+
+void cdcl_solver::heap_insert(std::size_t v)
+{
+    if (heap_index_[v] != npos) {
+        return;
+    }
+    heap_index_[v] = heap_.size();
+    heap_.push_back(v);
+    heap_sift_up(heap_.size() - 1);
+}
+
+void cdcl_solver::heap_sift_up(std::size_t pos)
+{
+    const std::size_t v{heap_[pos]};
+    while (pos > 0) {
+        const std::size_t parent{(pos - 1) / 2};
+        if (activity_[heap_[parent]] >= activity_[v]) {
+            break;
+        }
+        heap_[pos] = heap_[parent];
+        heap_index_[heap_[pos]] = pos;
+        pos = parent;
+    }
+    heap_[pos] = v;
+    heap_index_[v] = pos;
+}
+
+void cdcl_solver::heap_sift_down(std::size_t pos)
+{
+    const std::size_t v{heap_[pos]};
+    while (true) {
+        std::size_t child{2 * pos + 1};
+        if (child >= heap_.size()) {
+            break;
+        }
+        if (child + 1 < heap_.size() &&
+            activity_[heap_[child + 1]] > activity_[heap_[child]]) {
+            child++;
+        }
+        if (activity_[heap_[child]] <= activity_[v]) {
+            break;
+        }
+        heap_[pos] = heap_[child];
+        heap_index_[heap_[pos]] = pos;
+        pos = child;
+    }
+    heap_[pos] = v;
+    heap_index_[v] = pos;
+}
+
+std::size_t cdcl_solver::heap_pop()
+{
+    const std::size_t top{heap_.front()};
+    heap_index_[top] = npos;
+    heap_.front() = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+        heap_index_[heap_.front()] = 0;
+        heap_sift_down(0);
+    }
+    return top;
+}
+
+}  // namespace grandrounds
@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef CDCL_HPP
+#define CDCL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace grandrounds {
+
+struct cdcl_stats {
+    std::uint64_t decisions{0};
+    std::uint64_t conflicts{0};
+    std::uint64_t propagations{0};
+    std::uint64_t restarts{0};
+    std::uint64_t learned_clauses{0};
+    std::uint64_t deleted_clauses{0};
+};
+
+// A small conflict-driven clause learning SAT solver: two watched literals,
+// first-UIP learning with clause minimisation, VSIDS branching with phase
+// saving, Luby restarts, and periodic deletion of learned clauses with a poor
+// literal block distance.
+// It is incremental in the sense that clauses may be added between calls to
+// solve(), which is all the uniqueness check needs.
+//
+// Variables and literals use DIMACS conventions: variables are numbered from
+// 1, and a negative literal is the negation of its variable.
+class cdcl_solver {
+   public:
+    explicit cdcl_solver(int variable_count = 0);
+
+    // Returns a new variable's number.
+    int new_variable();
+
+    // Add a clause.  Returns false if the formula is now known to be
+    // unsatisfiable without any search.
+    bool add_clause(std::span<const int> literals);
+
+    // Returns true if the clauses added so far are satisfiable, in which case
+    // model_value() gives the satisfying assignment.
+    bool solve();
+
+    [[nodiscard]] bool model_value(int variable) const;
+    [[nodiscard]] int variable_count() const noexcept;
+    [[nodiscard]] const cdcl_stats& stats() const noexcept { return stats_; }
+
+   private:
+    using lit = std::uint32_t;  // 2 * (variable - 1) + negated
+    using clause_ref = std::uint32_t;
+    static constexpr clause_ref no_reason{
+        std::numeric_limits<clause_ref>::max()};
+
+    [[nodiscard]] static lit from_dimacs(int literal) noexcept;
+    [[nodiscard]] static std::size_t var(lit l) noexcept { return l >> 1U; }
+    [[nodiscard]] std::int8_t value(lit l) const noexcept;
+    [[nodiscard]] int decision_level() const noexcept;
+
+    void enqueue(lit l, clause_ref reason);
+    clause_ref propagate();
+    void analyze(clause_ref conflict,
+                 std::vector<lit>& learned,
+                 int& backjump_level);
+    void backtrack(int level);
+    void attach(clause_ref c);
+    [[nodiscard]] bool redundant(lit l) const;
+    [[nodiscard]] std::uint32_t block_distance(const std::vector<lit>& c);
+    void reduce_learned();
+    [[nodiscard]] bool pick_branch(lit& out);
+    void bump(std::size_t v);
+
+    void heap_insert(std::size_t v);
+    void heap_sift_up(std::size_t pos);
+    void heap_sift_down(std::size_t pos);
+    [[nodiscard]] std::size_t heap_pop();
+
+    std::vector<std::vector<lit>> clauses_;
+    std::vector<std::uint8_t> deleted_;  // Per clause; watchers drop lazily
+    struct learned_clause {
+        clause_ref ref;
+        std::uint32_t block_distance;
+    };
+    std::vector<learned_clause> learned_;
+    std::vector<std::uint32_t> level_stamp_;
+    std::uint32_t stamp_{0};
+    std::vector<std::vector<clause_ref>> watches_;  // Indexed by literal
+
+    std::vector<std::int8_t> assigns_;  // Per variable: 0 unset, 1, -1
+    std::vector<int> level_;
+    std::vector<clause_ref> reason_;
+    std::vector<std::uint8_t> polarity_;  // Saved phase, 1 for negated
+    std::vector<std::uint8_t> seen_;
+    std::vector<lit> removed_;  // Scratch for clause minimisation
+    std::vector<lit> trail_;
+    std::vector<std::size_t> trail_limits_;
+    std::size_t propagated_{0};
+
+    std::vector<double> activity_;
+    double activity_increment_{1.0};
+    std::vector<std::size_t> heap_;
+    std::vector<std::size_t> heap_index_;  // Position in heap_, or npos
+
+    std::vector<std::int8_t> model_;
+    bool unsatisfiable_{false};
+    cdcl_stats stats_;
+};
+
+}  // namespace grandrounds
+
+#endif  // CDCL_HPP
@@ -0,0 +1,295 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "cnf.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+#include <gsl/narrow>
+
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+
+namespace grandrounds {
+
+std::size_t cnf_formula::literal_count() const noexcept
+{
+    return std::accumulate(clauses.begin(), clauses.end(), std::size_t{0},
+                           [](std::size_t sum, const auto& clause) {
+                               return sum + clause.size();
+                           });
+}
+
+namespace {
+
+constexpr int always_true{0};  // Stands in for a state variable known true
+
+// The automaton for one line's hints.  State q means the first q symbols of
+// the pattern 1^h1 0 1^h2 0 ... 1^hk have been read; leading, trailing and
+// extra gap zeros loop on the state before them.
+class line_automaton {
+   public:
+    explicit line_automaton(const line_hints& hints)
+    {
+        for (std::size_t i{0}; i < hints.size(); i++) {
+            if (i > 0) {
+                pattern_.push_back(false);
+            }
+            pattern_.insert(pattern_.end(), hints[i], true);
+        }
+    }
+
+    [[nodiscard]] std::size_t length() const noexcept
+    {
+        return pattern_.size();
+    }
+
+    // The state after reading `filled` in state `q`, or nullopt if the
+    // pattern cannot continue that way.
+    [[nodiscard]] std::optional<std::size_t> next(std::size_t q,
+                                                  bool filled) const noexcept
+    {
+        const std::size_t end{pattern_.size()};
+        if (filled) {
+            return q < end && pattern_[q] ? std::optional{q + 1} : std::nullopt;
+        }
+        if (q < end && !pattern_[q]) {
+            return q + 1;
+        }
+        if (q == 0 || q == end || !pattern_[q - 1]) {
+            return q;
+        }
+        return std::nullopt;
+    }
+
+   private:
+    std::vector<bool> pattern_;
+};
+
+class line_encoder {
+   public:
+    line_encoder(cnf_formula& formula,
+                 const std::vector<int>& cells,
+                 const line_hints& hints)
+        : formula_{formula},
+          cells_{cells},
+          automaton_{hints},
+          n_{cells.size()},
+          length_{automaton_.length()}
+    {
+    }
+
+    void encode()
+    {
+        if (length_ > n_) {
+            formula_.clauses.emplace_back();  // Can never be satisfied
+            return;
+        }
+        allocate_states();
+        for (std::size_t t{0}; t < n_; t++) {
+            encode_step(t);
+        }
+    }
+
+   private:
+    // State q is only worth a variable at time t if at least q cells have
+    // been read and the remaining cells can still finish the pattern.
+    [[nodiscard]] std::size_t min_state(std::size_t t) const noexcept
+    {
+        return t > n_ - length_ ? t - (n_ - length_) : 0;
+    }
+    [[nodiscard]] std::size_t max_state(std::size_t t) const noexcept
+    {
+        return std::min(t, length_);
+    }
+    [[nodiscard]] bool valid(std::size_t t, std::size_t q) const noexcept
+    {
+        return q >= min_state(t) && q <= max_state(t);
+    }
+
+    void allocate_states()
+    {
+        states_.resize(n_ + 1);
+        for (std::size_t t{0}; t <= n_; t++) {
+            for (std::size_t q{min_state(t)}; q <= max_state(t); q++) {
+                // At the start and end exactly one state is possible.
+                states_[t].push_back(t == 0 || t == n_
+                                         ? always_true
+                                         : ++formula_.variable_count);
+            }
+        }
+    }
+
+    [[nodiscard]] int state(std::size_t t, std::size_t q) const
+    {
+        return states_[t][q - min_state(t)];
+    }
+
+    // The literal meaning "cell t is filled" (or empty).
+    [[nodiscard]] int cell(std::size_t t, bool filled) const
+    {
+        return filled ? cells_[t] : -cells_[t];
+    }
+
+    void add(std::vector<int> clause)
+    {
+        formula_.clauses.push_back(std::move(clause));
+    }
+
+    void encode_step(std::size_t t)
+    {
+        // Forward: a state and a cell value imply the next state, or are
+        // incompatible if the automaton has no such transition.
+        for (std::size_t q{min_state(t)}; q <= max_state(t); q++) {
+            const int from{state(t, q)};
+            for (const bool filled : {false, true}) {
+                std::vector<int> clause;
+                if (from != always_true) {
+                    clause.push_back(-from);
+                }
+                clause.push_back(-cell(t, filled));
+                const auto to{automaton_.next(q, filled)};
+                if (to && valid(t + 1, *to)) {
+                    const int to_var{state(t + 1, *to)};
+                    if (to_var == always_true) {
+                        continue;
+                    }
+                    clause.push_back(to_var);
+                }
+                add(std::move(clause));
+            }
+        }
+
+        // Backward: a state needs a predecessor, and the predecessor fixes the
+        // cell value that was read.  These aren't needed for correctness but
+        // let unit propagation work in both directions along the line.
+        if (t + 1 == n_) {
+            return;
+        }
+        for (std::size_t q{min_state(t + 1)}; q <= max_state(t + 1); q++) {
+            const int to{state(t + 1, q)};
+            std::vector<int> support{-to};
+            bool supported_by_constant{false};
+            for (std::size_t p{min_state(t)}; p <= max_state(t); p++) {
+                for (const bool filled : {false, true}) {
+                    if (automaton_.next(p, filled) != q) {
+                        continue;
+                    }
+                    const int from{state(t, p)};
+                    if (from == always_true) {
+                        supported_by_constant = true;
+                        add({-to, cell(t, filled)});
+                    }
+                    else {
+                        support.push_back(from);
+                        add({-from, -to, cell(t, filled)});
+                    }
+                }
+            }
+            if (!supported_by_constant) {
+                add(std::move(support));
+            }
+        }
+    }
+
+    cnf_formula& formula_;
+    const std::vector<int>& cells_;
+    line_automaton automaton_;
+    std::size_t n_;
+    std::size_t length_;
+    std::vector<std::vector<int>> states_;  // [t][q - min_state(t)]
+};
+
+}  // namespace
+
+nonogram_cnf encode_nonogram(board_coords dimensions,
+                             const std::vector<line_hints>& row_hints,
+                             const std::vector<line_hints>& col_hints)
+{
+    if (dimensions.x <= 0 || dimensions.y <= 0 ||
+        row_hints.size() != gsl::narrow<std::size_t>(dimensions.y) ||
+        col_hints.size() != gsl::narrow<std::size_t>(dimensions.x)) {
+        throw std::invalid_argument{"Hints do not match puzzle dimensions"};
+    }
+
+    nonogram_cnf out;
+    out.dimensions = dimensions;
+    out.formula.variable_count = dimensions.x * dimensions.y;
+
+    std::vector<int> cells;
+    for (int y{0}; y < dimensions.y; y++) {
+        cells.clear();
+        for (int x{0}; x < dimensions.x; x++) {
+            cells.push_back(out.cell_variable(x, y));
+        }
+        line_encoder{out.formula, cells,
+                     row_hints[gsl::narrow<std::size_t>(y)]}
+            .encode();
+    }
+    for (int x{0}; x < dimensions.x; x++) {
+        cells.clear();
+        for (int y{0}; y < dimensions.y; y++) {
+            cells.push_back(out.cell_variable(x, y));
+        }
+        line_encoder{out.formula, cells,
+                     col_hints[gsl::narrow<std::size_t>(x)]}
+            .encode();
+    }
+    return out;
+}
+
+void write_dimacs(std::ostream& out, const cnf_formula& formula)
+{
+    fmt::print(out, "p cnf {} {}\n", formula.variable_count,
+               formula.clauses.size());
+    for (const auto& clause : formula.clauses) {
+        fmt::print(out, "{} 0\n", fmt::join(clause, " "));
+    }
+}
+
+cnf_result solve_nonogram_cnf(board_coords dimensions,
+                              const std::vector<line_hints>& row_hints,
+                              const std::vector<line_hints>& col_hints)
+{
+    const auto encoded{encode_nonogram(dimensions, row_hints, col_hints)};
+
+    cnf_result out;
+    out.variables = gsl::narrow<std::size_t>(encoded.formula.variable_count);
+    out.clauses = encoded.formula.clauses.size();
+    out.literals = encoded.formula.literal_count();
+
+    cdcl_solver solver{encoded.formula.variable_count};
+    for (const auto& clause : encoded.formula.clauses) {
+        solver.add_clause(clause);
+    }
+
+    const int cell_count{dimensions.x * dimensions.y};
+    while (out.solutions.size() < 2 && solver.solve()) {
+        std::vector<board_cell> solution;
+        std::vector<int> blocking;
+        for (int v{1}; v <= cell_count; v++) {
+            const bool filled{solver.model_value(v)};
+            solution.push_back(filled ? board_cell::filled : board_cell::clear);
+            blocking.push_back(filled ? -v : v);
+        }
+        out.solutions.push_back(std::move(solution));
+        solver.add_clause(blocking);
+    }
+    out.stats = solver.stats();
+
+    if (out.solutions.empty()) {
+        out.status = solve_status::contradiction;
+    }
+    else {
+        out.status = out.solutions.size() == 1 ? solve_status::unique
+                                               : solve_status::multiple;
+    }
+    return out;
+}
+
+}  // namespace grandrounds
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef CNF_HPP
+#define CNF_HPP
+
+#include "cdcl.hpp"
+#include "nonogram.hpp"
+#include "solver.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace grandrounds {
+
+// A formula in conjunctive normal form, with DIMACS-style literals.
+struct cnf_formula {
+    int variable_count{0};
+    std::vector<std::vector<int>> clauses;
+
+    [[nodiscard]] std::size_t literal_count() const noexcept;
+};
+
+// A nonogram encoded as CNF.  Variables 1 through width * height are the
+// cells in row-major order (true meaning filled); the rest are automaton
+// states private to the encoding.
+struct nonogram_cnf {
+    board_coords dimensions;
+    cnf_formula formula;
+
+    [[nodiscard]] int cell_variable(int x, int y) const noexcept
+    {
+        return y * dimensions.x + x + 1;
+    }
+};
+
+// Encode each row and column as a run of the finite automaton accepting its
+// hint pattern (0* 1^h1 0+ 1^h2 ... 0*), unrolled over the cells of the line.
+// Only automaton states that can be reached from the start and can still reach
+// the end get variables, so a line of n cells whose hints need L cells costs
+// at most n * (n - L + 1) extra variables.
+nonogram_cnf encode_nonogram(board_coords dimensions,
+                             const std::vector<line_hints>& row_hints,
+                             const std::vector<line_hints>& col_hints);
+
+void write_dimacs(std::ostream& out, const cnf_formula& formula);
+
+struct cnf_result {
+    solve_status status{solve_status::contradiction};
+    std::vector<std::vector<board_cell>> solutions;  // Up to two
+    std::size_t variables{0};
+    std::size_t clauses{0};
+    std::size_t literals{0};
+    cdcl_stats stats;
+};
+
+// Solve with the CDCL solver, then add a clause forbidding the first solution
+// and solve again to check that it is the only one.
+cnf_result solve_nonogram_cnf(board_coords dimensions,
+                              const std::vector<line_hints>& row_hints,
+                              const std::vector<line_hints>& col_hints);
+
+}  // namespace grandrounds
+
+#endif  // CNF_HPP
@@ -0,0 +1,380 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "color_solver.hpp"
+
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace grandrounds {
+
+bool colored_line_solver::solve(std::span<const std::uint8_t> hints,
+                                std::span<const std::uint8_t> colors,
+                                std::span<color_mask> line)
+{
+    const std::size_t n{line.size()};
+    const std::size_t k{hints.size()};
+    const std::size_t stride{n + 1};
+    const auto can_be_empty{
+        [&](std::size_t i) { return (line[i] & empty_mask) != 0; }};
+    // Runs of the same colour need a gap between them; others may touch.
+    const auto gap_after{[&](std::size_t j) {
+        return j + 1 < k && colors[j] == colors[j + 1];
+    }};
+
+    // fits_[j * stride + s]: run j can start at cell s, every cell it would
+    // cover allowing its colour.
+    fits_.assign(k * stride, 0);
+    for (std::size_t j{0}; j < k; j++) {
+        const std::size_t length{hints[j]};
+        const auto bit{color_bit(colors[j])};
+        std::size_t allowed{0};  // Cells up to i in a row that allow the colour
+        for (std::size_t i{0}; i < n; i++) {
+            allowed = (line[i] & bit) != 0 ? allowed + 1 : 0;
+            if (length > 0 && allowed >= length) {
+                fits_[j * stride + i + 1 - length] = 1;
+            }
+        }
+    }
+
+    // prefix_[j * stride + p]: cells [0, p) can hold exactly runs 0..j-1.
+    // prefix_gap_ also needs cell p - 1 to be empty, so that a run of the
+    // same colour as run j - 1 can start at p.
+    prefix_.assign((k + 1) * stride, 0);
+    prefix_gap_.assign((k + 1) * stride, 0);
+    for (std::size_t j{0}; j <= k; j++) {
+        for (std::size_t p{0}; p <= n; p++) {
+            const bool gap{p == 0 ? j == 0
+                                  : can_be_empty(p - 1) &&
+                                        prefix_[j * stride + p - 1] != 0};
+            bool ends_run{false};
+            if (j > 0 && p >= hints[j - 1] &&
+                fits_[(j - 1) * stride + p - hints[j - 1]] != 0) {
+                const std::size_t start{p - hints[j - 1]};
+                const bool needs_gap{j >= 2 && colors[j - 2] == colors[j - 1]};
+                const auto& before{needs_gap ? prefix_gap_ : prefix_};
+                ends_run = before[(j - 1) * stride + start] != 0;
+            }
+            prefix_gap_[j * stride + p] = gap ? 1 : 0;
+            prefix_[j * stride + p] = gap || ends_run ? 1 : 0;
+        }
+    }
+
+    // suffix_[j * stride + p]: cells [p, n) can hold exactly runs j..k-1.
+    // suffix_gap_ also needs cell p to be empty.
+    suffix_.assign((k + 1) * stride, 0);
+    suffix_gap_.assign((k + 1) * stride, 0);
+    for (std::size_t j{k + 1}; j-- > 0;) {
+        for (std::size_t p{n + 1}; p-- > 0;) {
+            const bool gap{p == n ? j == k
+                                  : can_be_empty(p) &&
+                                        suffix_[j * stride + p + 1] != 0};
+            bool starts_run{false};
+            if (j < k && p + hints[j] <= n && fits_[j * stride + p] != 0) {
+                const std::size_t end{p + hints[j]};
+                const auto& after{gap_after(j) ? suffix_gap_ : suffix_};
+                starts_run = after[(j + 1) * stride + end] != 0;
+            }
+            suffix_gap_[j * stride + p] = gap ? 1 : 0;
+            suffix_[j * stride + p] = gap || starts_run ? 1 : 0;
+        }
+    }
+    if (suffix_[0] == 0) {
+        return false;
+    }
+
+    // A cell can be empty if the runs before it fit to its left and the rest
+    // to its right.
+    possible_.assign(n, 0);
+    for (std::size_t i{0}; i < n; i++) {
+        if (!can_be_empty(i)) {
+            continue;
+        }
+        for (std::size_t j{0}; j <= k; j++) {
+            if (prefix_[j * stride + i] != 0 &&
+                suffix_[j * stride + i + 1] != 0) {
+                possible_[i] |= empty_mask;
+                break;
+            }
+        }
+    }
+
+    // Every valid placement of a run covers its cells with its colour; count
+    // coverage with a difference array so each placement costs O(1).
+    cover_.resize(n + 1);
+    for (std::size_t j{0}; j < k; j++) {
+        const std::size_t length{hints[j]};
+        const bool gap_before{j > 0 && colors[j - 1] == colors[j]};
+        std::fill(cover_.begin(), cover_.end(), 0);
+        for (std::size_t start{0}; start + length <= n; start++) {
+            if (fits_[j * stride + start] == 0) {
+                continue;
+            }
+            const std::size_t end{start + length};
+            const auto& before{gap_before ? prefix_gap_ : prefix_};
+            const auto& after{gap_after(j) ? suffix_gap_ : suffix_};
+            const bool left_ok{before[j * stride + start] != 0};
+            const bool right_ok{after[(j + 1) * stride + end] != 0};
+            if (left_ok && right_ok) {
+                cover_[start]++;
+                cover_[end]--;
+            }
+        }
+        const auto bit{color_bit(colors[j])};
+        int covered{0};
+        for (std::size_t i{0}; i < n; i++) {
+            covered += cover_[i];
+            if (covered > 0) {
+                possible_[i] |= bit;
+            }
+        }
+    }
+
+    if (std::find(possible_.begin(), possible_.end(), color_mask{0}) !=
+        possible_.end()) {
+        return false;
+    }
+    std::copy(possible_.begin(), possible_.end(), line.begin());
+    return true;
+}
+
+int colored_line_slack(std::span<const std::uint8_t> hints,
+                       std::span<const std::uint8_t> colors,
+                       int length) noexcept
+{
+    int needed{0};
+    for (std::size_t j{0}; j < hints.size(); j++) {
+        needed += hints[j];
+        if (j > 0 && colors[j - 1] == colors[j]) {
+            needed++;
+        }
+    }
+    return length - needed;
+}
+
+namespace {
+
+using masks_t = std::vector<color_mask>;
+
+// Propagation and search for one puzzle, much as solver.cpp does for
+// black-and-white puzzles, on a single thread.
+class colored_search {
+   public:
+    colored_search(const nonogram_puzzle& puzzle, const solver_options& options)
+        : puzzle_{puzzle},
+          width_{gsl::narrow<std::size_t>(puzzle.dimensions.x)},
+          height_{gsl::narrow<std::size_t>(puzzle.dimensions.y)},
+          solution_limit_{options.check_uniqueness ? 2U : 1U},
+          row_dirty_(height_, 0),
+          col_dirty_(width_, 0)
+    {
+        // A black-and-white puzzle is a colour puzzle of one colour.
+        const auto longest{std::max(puzzle.dimensions.x, puzzle.dimensions.y)};
+        zeros_.resize(gsl::narrow<std::size_t>(longest));
+        // A line with no hints is all empty however long it is, so it
+        // doesn't count as a loose line.
+        for (std::size_t y{0}; y < height_; y++) {
+            const auto& hints{puzzle.row_hints[y]};
+            row_slack_.push_back(
+                hints.empty() ? 0
+                              : colored_line_slack(hints, row_colors(y),
+                                                   puzzle.dimensions.x));
+        }
+        for (std::size_t x{0}; x < width_; x++) {
+            const auto& hints{puzzle.col_hints[x]};
+            col_slack_.push_back(
+                hints.empty() ? 0
+                              : colored_line_slack(hints, col_colors(x),
+                                                   puzzle.dimensions.y));
+        }
+    }
+
+    solve_result run()
+    {
+        masks_t cells(width_ * height_,
+                      all_colors_mask(std::max<std::size_t>(
+                          puzzle_.palette.size(), 1)));
+        std::fill(row_dirty_.begin(), row_dirty_.end(), 1);
+        std::fill(col_dirty_.begin(), col_dirty_.end(), 1);
+        const bool consistent{propagate(cells)};
+        out_.stats.root_propagation_rounds = out_.stats.propagation_rounds;
+        out_.stats.hardest_line_slack = hardest_slack_;
+        if (consistent) {
+            search(cells, 0);
+        }
+
+        if (out_.solutions.empty()) {
+            out_.status = solve_status::contradiction;
+        }
+        else if (out_.solutions.size() > 1) {
+            out_.status = solve_status::multiple;
+        }
+        else {
+            out_.status = solution_limit_ > 1 ? solve_status::unique
+                                              : solve_status::solved;
+        }
+        return std::move(out_);
+    }
+
+   private:
+    [[nodiscard]] std::span<const std::uint8_t> row_colors(
+        std::size_t y) const noexcept
+    {
+        return puzzle_.is_colored()
+                   ? std::span<const std::uint8_t>{puzzle_.row_hint_colors[y]}
+                   : std::span{zeros_}.first(puzzle_.row_hints[y].size());
+    }
+
+    [[nodiscard]] std::span<const std::uint8_t> col_colors(
+        std::size_t x) const noexcept
+    {
+        return puzzle_.is_colored()
+                   ? std::span<const std::uint8_t>{puzzle_.col_hint_colors[x]}
+                   : std::span{zeros_}.first(puzzle_.col_hints[x].size());
+    }
+
+    // Solve rows and columns until nothing more can be deduced, revisiting
+    // only the lines that crossed a newly-narrowed cell.  Returns false on a
+    // contradiction.
+    bool propagate(masks_t& cells)
+    {
+        while (std::find(row_dirty_.begin(), row_dirty_.end(), 1) !=
+                   row_dirty_.end() ||
+               std::find(col_dirty_.begin(), col_dirty_.end(), 1) !=
+                   col_dirty_.end()) {
+            out_.stats.propagation_rounds++;
+            for (std::size_t y{0}; y < height_; y++) {
+                if (row_dirty_[y] == 0) {
+                    continue;
+                }
+                row_dirty_[y] = 0;
+                line_.assign(
+                    cells.begin() + gsl::narrow<long>(y * width_),
+                    cells.begin() + gsl::narrow<long>((y + 1) * width_));
+                if (!solve_line(puzzle_.row_hints[y], row_colors(y))) {
+                    return false;
+                }
+                bool deduced{false};
+                for (std::size_t x{0}; x < width_; x++) {
+                    if (cells[y * width_ + x] != line_[x]) {
+                        cells[y * width_ + x] = line_[x];
+                        col_dirty_[x] = 1;
+                        deduced = true;
+                    }
+                }
+                if (deduced) {
+                    hardest_slack_ = std::max(hardest_slack_, row_slack_[y]);
+                }
+            }
+            for (std::size_t x{0}; x < width_; x++) {
+                if (col_dirty_[x] == 0) {
+                    continue;
+                }
+                col_dirty_[x] = 0;
+                line_.resize(height_);
+                for (std::size_t y{0}; y < height_; y++) {
+                    line_[y] = cells[y * width_ + x];
+                }
+                if (!solve_line(puzzle_.col_hints[x], col_colors(x))) {
+                    return false;
+                }
+                bool deduced{false};
+                for (std::size_t y{0}; y < height_; y++) {
+                    if (cells[y * width_ + x] != line_[y]) {
+                        cells[y * width_ + x] = line_[y];
+                        row_dirty_[y] = 1;
+                        deduced = true;
+                    }
+                }
+                if (deduced) {
+                    hardest_slack_ = std::max(hardest_slack_, col_slack_[x]);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool solve_line(const line_hints& hints,
+                    std::span<const std::uint8_t> colors)
+    {
+        out_.stats.line_solves++;
+        if (line_solver_.solve(hints, colors, line_)) {
+            return true;
+        }
+        std::fill(row_dirty_.begin(), row_dirty_.end(), 0);
+        std::fill(col_dirty_.begin(), col_dirty_.end(), 0);
+        return false;
+    }
+
+    // Branch on the first cell that is still open, trying each thing it
+    // could be in turn.
+    void search(const masks_t& cells, int depth)
+    {
+        out_.stats.nodes++;
+        out_.stats.max_depth = std::max(out_.stats.max_depth, depth);
+        const auto open{std::find_if(cells.begin(), cells.end(), [](auto mask) {
+            return !std::has_single_bit(mask);
+        })};
+        if (open == cells.end()) {
+            record_solution(cells);
+            return;
+        }
+        const auto index{gsl::narrow<std::size_t>(open - cells.begin())};
+        for (auto options{*open};
+             options != 0 && out_.solutions.size() < solution_limit_;
+             options &= options - 1) {
+            auto branch{cells};
+            branch[index] = options & (~options + 1);
+            row_dirty_[index / width_] = 1;
+            col_dirty_[index % width_] = 1;
+            if (propagate(branch)) {
+                search(branch, depth + 1);
+            }
+        }
+    }
+
+    void record_solution(const masks_t& cells)
+    {
+        std::vector<board_cell> solution;
+        solution.reserve(cells.size());
+        for (const auto mask : cells) {
+            solution.push_back(
+                mask == empty_mask
+                    ? board_cell::clear
+                    : filled_cell(gsl::narrow<std::uint8_t>(
+                          std::countr_zero(mask) - 1)));
+        }
+        out_.solutions.push_back(std::move(solution));
+    }
+
+    const nonogram_puzzle& puzzle_;
+    std::size_t width_;
+    std::size_t height_;
+    std::size_t solution_limit_;
+    colored_line_solver line_solver_;
+    masks_t line_;
+    std::vector<std::uint8_t> row_dirty_;
+    std::vector<std::uint8_t> col_dirty_;
+    std::vector<std::uint8_t> zeros_;
+    std::vector<int> row_slack_;
+    std::vector<int> col_slack_;
+    int hardest_slack_{0};  // Of any line that yielded a deduction
+    solve_result out_;
+};
+
+}  // namespace
+
+solve_result solve_colored_nonogram(const nonogram_puzzle& puzzle,
+                                    const solver_options& options)
+{
+    return colored_search{puzzle, options}.run();
+}
+
+}  // namespace grandrounds
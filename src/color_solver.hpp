@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef COLOR_SOLVER_HPP
+#define COLOR_SOLVER_HPP
+
+#include "nonogram.hpp"
+#include "solver.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Solving colour nonograms.  Runs of the same colour need a gap between them,
+// as in a black-and-white puzzle, but runs of different colours may touch, so
+// a cell can be empty or any of several colours rather than just empty or
+// filled.
+namespace grandrounds {
+
+// What the solver knows about a cell: a bit for everything it could still
+// be.  Bit 0 is empty, and bit k + 1 is palette colour k.
+using color_mask = std::uint32_t;
+
+inline constexpr color_mask empty_mask{1};
+
+[[nodiscard]] constexpr color_mask color_bit(std::uint8_t color) noexcept
+{
+    return color_mask{2} << color;
+}
+
+// Every colour of a palette of `colors`, and empty.
+[[nodiscard]] constexpr color_mask all_colors_mask(std::size_t colors) noexcept
+{
+    return (color_mask{2} << colors) - 1;
+}
+
+// The colour version of line_solver.  The scratch buffers are kept between
+// calls so that solving many lines doesn't allocate.
+class colored_line_solver {
+   public:
+    // Narrow each cell of `line` to what some placement of the hints, in
+    // their colours, allows.  Returns false if no placement is consistent
+    // with the line, in which case `line` is left unmodified.
+    bool solve(std::span<const std::uint8_t> hints,
+               std::span<const std::uint8_t> colors,
+               std::span<color_mask> line);
+
+   private:
+    std::vector<std::uint8_t> fits_;
+    std::vector<std::uint8_t> prefix_;
+    std::vector<std::uint8_t> prefix_gap_;
+    std::vector<std::uint8_t> suffix_;
+    std::vector<std::uint8_t> suffix_gap_;
+    std::vector<int> cover_;
+    std::vector<color_mask> possible_;
+};
+
+// A line's length minus the fewest cells its hints can occupy, counting a
+// gap only between runs of the same colour.
+[[nodiscard]] int colored_line_slack(std::span<const std::uint8_t> hints,
+                                     std::span<const std::uint8_t> colors,
+                                     int length) noexcept;
+
+// Solve a colour puzzle from its hints by line propagation, branching when
+// that stalls.  It runs on the calling thread and doesn't probe, so those
+// options are ignored.  Solutions hold filled_cell() of each colour.
+solve_result solve_colored_nonogram(const nonogram_puzzle& puzzle,
+                                    const solver_options& options = {});
+
+}  // namespace grandrounds
+
+#endif  // COLOR_SOLVER_HPP
@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "compact_image.hpp"
+#include "file.hpp"
+
+#include <fmt/format.h>
+#include <lodepng.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <unordered_map>
+
+namespace grandrounds {
+
+namespace {
+
+std::atomic<pixel_format> current_photo_format{pixel_format::rgb};
+
+constexpr std::size_t max_palette_size{256};
+
+std::uint32_t pack(color c) noexcept
+{
+    return (std::uint32_t{c.r} << 16U) | (std::uint32_t{c.g} << 8U) | c.b;
+}
+
+// The part of the xterm palette that every terminal agrees on: a 6x6x6 colour
+// cube from index 16 and a 24-step grey ramp from index 232.  The first 16
+// colours vary with the terminal's theme, so they are never picked.
+constexpr std::array<std::uint8_t, 6> cube_levels{0, 95, 135, 175, 215, 255};
+constexpr std::uint8_t cube_start{16};
+constexpr std::uint8_t grey_start{232};
+
+std::uint8_t nearest_level(std::uint8_t value) noexcept
+{
+    std::uint8_t best{0};
+    for (std::uint8_t i{1}; i < cube_levels.size(); i++) {
+        if (std::abs(int{cube_levels[i]} - int{value}) <
+            std::abs(int{cube_levels[best]} - int{value})) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+std::uint8_t nearest_xterm_index(color c) noexcept
+{
+    const auto r{nearest_level(c.r)};
+    const auto g{nearest_level(c.g)};
+    const auto b{nearest_level(c.b)};
+    const auto cube{static_cast<std::uint8_t>(cube_start + r * 36 + g * 6 + b)};
+    // Greys run from 8 to 238 in steps of 10.
+    const int average{(int{c.r} + int{c.g} + int{c.b}) / 3};
+    const auto grey{static_cast<std::uint8_t>(
+        grey_start + std::clamp((average - 8 + 5) / 10, 0, 23))};
+    return color_distance(c, xterm_color(grey)) <
+                   color_distance(c, xterm_color(cube))
+               ? grey
+               : cube;
+}
+
+color xterm_color(std::uint8_t index) noexcept
+{
+    if (index >= grey_start) {
+        const auto level{
+            static_cast<std::uint8_t>(8 + (index - grey_start) * 10)};
+        return {level, level, level};
+    }
+    const int cube{std::max(int{index} - cube_start, 0)};
+    return {cube_levels[static_cast<std::size_t>(cube / 36)],
+            cube_levels[static_cast<std::size_t>(cube / 6 % 6)],
+            cube_levels[static_cast<std::size_t>(cube % 6)]};
+}
+
+namespace {
+
+color nearest_xterm_color(color c) noexcept
+{
+    return xterm_color(nearest_xterm_index(c));
+}
+
+}  // namespace
+
+compact_image compact_image::from_pixels(std::span<const std::uint8_t> pixels,
+                                         std::size_t channels,
+                                         unsigned int width,
+                                         unsigned int height,
+                                         pixel_format format)
+{
+    const std::size_t count{std::size_t{width} * height};
+    if (pixels.size() < count * channels) {
+        throw file_error{"Image data is smaller than its dimensions"};
+    }
+    const auto pixel_at{[&](std::size_t i) {
+        return color{pixels[i * channels], pixels[i * channels + 1],
+                     pixels[i * channels + 2]};
+    }};
+
+    compact_image out;
+    out.width_ = width;
+    out.height_ = height;
+
+    // Index the image exactly if it has few enough colours, and otherwise
+    // either keep RGB or index it by the nearest xterm colours, of which
+    // there are fewer than 256.
+    std::unordered_map<std::uint32_t, std::uint8_t> indices;
+    const auto index_of{[&](color c) {
+        const auto [found, added]{indices.try_emplace(
+            pack(c), static_cast<std::uint8_t>(out.palette_.size()))};
+        if (added) {
+            out.palette_.push_back(c);
+        }
+        return found->second;
+    }};
+    out.format_ = pixel_format::indexed;
+    out.data_.reserve(count);
+    for (std::size_t i{0}; i < count; i++) {
+        const auto c{pixel_at(i)};
+        if (indices.size() == max_palette_size && !indices.contains(pack(c))) {
+            out.data_.clear();
+            out.palette_.clear();
+            indices.clear();
+            break;
+        }
+        out.data_.push_back(index_of(c));
+    }
+    if (out.data_.size() == count) {
+        out.palette_.shrink_to_fit();
+        return out;
+    }
+
+    if (format == pixel_format::indexed) {
+        for (std::size_t i{0}; i < count; i++) {
+            out.data_.push_back(index_of(nearest_xterm_color(pixel_at(i))));
+        }
+        out.palette_.shrink_to_fit();
+        return out;
+    }
+
+    out.format_ = pixel_format::rgb;
+    out.data_.resize(count * 3);
+    for (std::size_t i{0}; i < count; i++) {
+        for (std::size_t c{0}; c < 3; c++) {
+            out.data_[i * 3 + c] = pixels[i * channels + c];
+        }
+    }
+    return out;
+}
+
+compact_image load_compact_image(const std::filesystem::path& png_path,
+                                 pixel_format format)
+{
+    // Decoded without alpha, which is never drawn.
+    std::vector<std::uint8_t> rgb;
+    unsigned int width{0};
+    unsigned int height{0};
+    const auto error{
+        lodepng::decode(rgb, width, height, png_path.string(), LCT_RGB, 8)};
+    if (error != 0) {
+        throw file_error{fmt::format("Could not load {}: {} {}",
+                                     png_path.string(), error,
+                                     lodepng_error_text(error))};
+    }
+    return compact_image::from_pixels(rgb, 3, width, height, format);
+}
+
+pixel_format photo_format() noexcept
+{
+    return current_photo_format.load(std::memory_order_relaxed);
+}
+
+void set_photo_format(pixel_format format) noexcept
+{
+    current_photo_format.store(format, std::memory_order_relaxed);
+}
+
+}  // namespace grandrounds
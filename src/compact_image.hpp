@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef COMPACT_IMAGE_HPP
+#define COMPACT_IMAGE_HPP
+
+#include "puzzle_colors.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace grandrounds {
+
+enum class pixel_format : std::uint8_t {
+    rgb,      // Three bytes per pixel
+    indexed,  // One byte per pixel into a palette of up to 256 colours
+};
+
+// An image kept for display, without the alpha channel nothing draws with.
+// Loaded puzzles hold their photos this way: RGB, a quarter smaller than
+// RGBA, or indexed, a quarter the size of RGB and plenty for a terminal that
+// can't show more than 256 colours anyway.
+class compact_image {
+   public:
+    compact_image() = default;
+
+    // Takes pixels of `channels` bytes each, red, green and blue first, in
+    // row-major order.  An image with no more than 256 colours is indexed
+    // whatever the format asked for, since that loses nothing.  Otherwise an
+    // indexed image maps each pixel to the nearest colour of the xterm
+    // 256-colour palette.  Throws file_error if there are too few pixels.
+    static compact_image from_pixels(std::span<const std::uint8_t> pixels,
+                                     std::size_t channels,
+                                     unsigned int width,
+                                     unsigned int height,
+                                     pixel_format format);
+
+    static compact_image from_rgba(std::span<const std::uint8_t> rgba,
+                                   unsigned int width,
+                                   unsigned int height,
+                                   pixel_format format)
+    {
+        return from_pixels(rgba, 4, width, height, format);
+    }
+
+    [[nodiscard]] unsigned int width() const noexcept { return width_; }
+    [[nodiscard]] unsigned int height() const noexcept { return height_; }
+    [[nodiscard]] pixel_format format() const noexcept { return format_; }
+
+    [[nodiscard]] color pixel(std::size_t x, std::size_t y) const noexcept
+    {
+        const auto i{y * width_ + x};
+        if (format_ == pixel_format::indexed) {
+            return palette_[data_[i]];
+        }
+        return {data_[i * 3], data_[i * 3 + 1], data_[i * 3 + 2]};
+    }
+
+    // Empty unless indexed.
+    [[nodiscard]] std::span<const color> palette() const noexcept
+    {
+        return palette_;
+    }
+    // Palette indices, one per pixel, for an indexed image.
+    [[nodiscard]] std::span<const std::uint8_t> indices() const noexcept
+    {
+        return data_;
+    }
+
+    // Heap memory held.
+    [[nodiscard]] std::size_t bytes() const noexcept
+    {
+        return data_.capacity() + palette_.capacity() * sizeof(color);
+    }
+
+   private:
+    unsigned int width_{0};
+    unsigned int height_{0};
+    pixel_format format_{pixel_format::rgb};
+    std::vector<std::uint8_t> data_;
+    std::vector<color> palette_;
+};
+
+// The xterm 256-colour palette's fixed part: the colour cube and grey ramp at
+// indices 16 to 255.  Indices below 16 vary with the terminal's theme, so
+// nearest_xterm_index() never returns one, and xterm_color() treats them as
+// black.
+[[nodiscard]] std::uint8_t nearest_xterm_index(color c) noexcept;
+[[nodiscard]] color xterm_color(std::uint8_t index) noexcept;
+
+// Load a PNG file straight to a compact image.
+compact_image load_compact_image(const std::filesystem::path& png_path,
+                                 pixel_format format);
+
+// The format loaded puzzle photos are stored in.  Defaults to RGB; the game
+// picks indexed at startup when the terminal has no more than 256 colours.
+[[nodiscard]] pixel_format photo_format() noexcept;
+void set_photo_format(pixel_format format) noexcept;
+
+}  // namespace grandrounds
+
+#endif  // COMPACT_IMAGE_HPP
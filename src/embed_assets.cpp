@@ -0,0 +1,314 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Build-time tool that decodes the puzzle assets and writes them out as a C++
+// source file defining the data declared in embedded_assets.hpp.
+//
+// Usage: embed_assets <PUZZLE_DIR> <OUTPUT_CPP>
+
+#include "puzzle_colors.hpp"
+
+#include <fmt/format.h>
+#include <lodepng.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct decoded_image {
+    std::vector<std::uint8_t> rgba;
+    unsigned int width{};
+    unsigned int height{};
+};
+
+decoded_image decode(const fs::path& path)
+{
+    decoded_image out;
+    const auto error{
+        lodepng::decode(out.rgba, out.width, out.height, path.string())};
+    if (error != 0) {
+        throw std::runtime_error{fmt::format("Could not load {}: {}",
+                                             path.string(),
+                                             lodepng_error_text(error))};
+    }
+    return out;
+}
+
+std::string slurp(const fs::path& path)
+{
+    std::ifstream stream{path, std::ios::binary};
+    if (!stream) {
+        throw std::runtime_error{"Could not read " + path.string()};
+    }
+    return {std::istreambuf_iterator<char>{stream},
+            std::istreambuf_iterator<char>{}};
+}
+
+// A string literal.  Anything outside printable ASCII is written as an octal
+// escape, which (unlike a hex escape) can't run on into the next character.
+std::string quote(std::string_view text)
+{
+    std::string out{"\""};
+    for (const char c : text) {
+        const auto byte{static_cast<unsigned char>(c)};
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if (byte < 0x20 || byte >= 0x7F) {
+            out += fmt::format("\\{:03o}", byte);
+        }
+        else {
+            out += c;
+        }
+    }
+    return out + '"';
+}
+
+// The hint tables, from the same pass over each line as the game's
+// calculate_row_hints() and calculate_col_hints().  With `colors` each run's
+// palette index is kept alongside.
+struct hint_table {
+    std::vector<std::uint8_t> data;
+    std::vector<std::uint16_t> offsets{0};
+    std::vector<std::uint8_t> colors;
+};
+
+hint_table line_hints(std::span<const grandrounds::board_cell> cells,
+                      std::size_t lines,
+                      std::size_t length,
+                      std::size_t line_step,
+                      std::size_t cell_step,
+                      bool colors)
+{
+    hint_table out;
+    for (std::size_t line{0}; line < lines; line++) {
+        const auto line_cells{
+            std::views::iota(std::size_t{0}, length) |
+            std::views::transform([&](std::size_t i) {
+                return cells[line * line_step + i * cell_step];
+            })};
+        grandrounds::calculate_hints(line_cells, out.data,
+                                     colors ? &out.colors : nullptr);
+        out.offsets.push_back(static_cast<std::uint16_t>(out.data.size()));
+    }
+    return out;
+}
+
+class source_writer {
+   public:
+    template <typename T>
+    void array(std::string_view type,
+               std::string_view name,
+               std::span<const T> values)
+    {
+        out_ << fmt::format("constexpr std::array<{}, {}> {}{{", type,
+                            values.size(), name);
+        constexpr std::size_t per_line{16};
+        for (std::size_t i{0}; i < values.size(); i++) {
+            out_ << (i % per_line == 0 ? "\n    " : " ")
+                 << static_cast<unsigned int>(values[i]) << ',';
+        }
+        out_ << "};\n";
+    }
+
+    void image(std::string_view name, const decoded_image& image)
+    {
+        array<std::uint8_t>("std::uint8_t", name, image.rgba);
+    }
+
+    std::ostringstream& stream() { return out_; }
+
+   private:
+    std::ostringstream out_;
+};
+
+std::string image_ref(std::string_view name, const decoded_image& image)
+{
+    return fmt::format("{{{}, {}, {}}}", image.width, image.height, name);
+}
+
+// `id` names the puzzle's arrays, since a file name needn't be an identifier.
+std::string embed_puzzle(source_writer& writer,
+                         const fs::path& dir,
+                         const std::string& name,
+                         const std::string& id)
+{
+    const auto nonogram{decode(dir / (name + "_nonogram.png"))};
+    const auto photo{decode(dir / (name + "_photo.png"))};
+    const auto small{decode(dir / (name + "_small.png"))};
+    const auto json = nlohmann::json::parse(slurp(dir / (name + "_data.json")));
+
+    const std::size_t width{nonogram.width};
+    const std::size_t height{nonogram.height};
+    const bool colored{json.contains("colors")};
+    std::vector<grandrounds::color> palette;
+    std::vector<grandrounds::board_cell> cells(width * height);
+    if (colored) {
+        cells = grandrounds::quantize_solution(
+            nonogram.rgba, 4, json["colors"].get<int>(), palette);
+    }
+    else {
+        for (std::size_t i{0}; i < cells.size(); i++) {
+            const auto* pixel{&nonogram.rgba[i * 4]};
+            if (pixel[0] == 0 && pixel[1] == 0 && pixel[2] == 0) {
+                cells[i] = grandrounds::board_cell::filled;
+            }
+        }
+    }
+    std::vector<std::uint8_t> bits((cells.size() + 7) / 8);
+    std::vector<std::uint8_t> cell_colors(cells.size());
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        if (grandrounds::is_filled(cells[i])) {
+            bits[i / 8] =
+                static_cast<std::uint8_t>(bits[i / 8] | 1U << (i % 8));
+            cell_colors[i] = static_cast<std::uint8_t>(
+                grandrounds::cell_color(cells[i]) + 1);
+        }
+    }
+    std::vector<std::uint8_t> palette_bytes;
+    for (const auto& c : palette) {
+        palette_bytes.insert(palette_bytes.end(), {c.r, c.g, c.b});
+    }
+    const auto rows{line_hints(cells, height, width, width, 1, colored)};
+    const auto cols{line_hints(cells, width, height, 1, width, colored)};
+
+    writer.array<std::uint8_t>("std::uint8_t", id + "_solution", bits);
+    writer.array<std::uint8_t>("std::uint8_t", id + "_row_hints", rows.data);
+    writer.array<std::uint16_t>("std::uint16_t", id + "_row_offsets",
+                                rows.offsets);
+    writer.array<std::uint8_t>("std::uint8_t", id + "_col_hints", cols.data);
+    writer.array<std::uint16_t>("std::uint16_t", id + "_col_offsets",
+                                cols.offsets);
+    // Colour puzzles' extra arrays; black-and-white puzzles leave the spans
+    // empty.
+    const auto colored_array{[&](const std::string& suffix,
+                                 const std::vector<std::uint8_t>& values) {
+        if (!colored) {
+            return std::string{"{}"};
+        }
+        writer.array<std::uint8_t>("std::uint8_t", id + suffix, values);
+        return id + suffix;
+    }};
+    const auto solution_colors{colored_array("_cells", cell_colors)};
+    const auto palette_rgb{colored_array("_palette", palette_bytes)};
+    const auto row_colors{colored_array("_row_colors", rows.colors)};
+    const auto col_colors{colored_array("_col_colors", cols.colors)};
+    writer.image(id + "_photo", photo);
+    writer.image(id + "_small", small);
+    writer.stream() << '\n';
+
+    const auto text{[&](const char* key) {
+        return quote(json.value(key, std::string{}));
+    }};
+    const auto optional_int{[&](const char* key) {
+        return json.contains(key) ? std::to_string(json[key].get<int>())
+                                  : std::string{"std::nullopt"};
+    }};
+    return fmt::format(
+        "    {{{}, {{{}, {}}}, {}_solution, {}, {},\n"
+        "     {{{}_row_hints, {}_row_offsets, {}}},\n"
+        "     {{{}_col_hints, {}_col_offsets, {}}},\n"
+        "     {}, {},\n"
+        "     {},\n     {},\n     {},\n     {},\n     {},\n     {},\n     {}, "
+        "{}}},\n",
+        quote(name), width, height, id, solution_colors, palette_rgb, id, id,
+        row_colors, id, id, col_colors, image_ref(id + "_photo", photo),
+        image_ref(id + "_small", small), text("title"), text("description"),
+        text("author"), text("date"), text("license"), text("wikipedia"),
+        optional_int("difficulty"), optional_int("colors"));
+}
+
+std::string generate(const fs::path& dir)
+{
+    std::vector<std::string> names;
+    constexpr std::string_view suffix{"_data.json"};
+    for (const auto& entry : fs::directory_iterator{dir}) {
+        const auto filename{entry.path().filename().string()};
+        if (filename.size() > suffix.size() && filename.ends_with(suffix)) {
+            names.push_back(
+                filename.substr(0, filename.size() - suffix.size()));
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    source_writer writer;
+    auto& out{writer.stream()};
+    out << "// Generated by embed_assets.  Do not edit.\n\n"
+           "#include \"embedded_assets.hpp\"\n\n"
+           "#include <array>\n#include <cstdint>\n#include <optional>\n\n"
+           "namespace grandrounds::embedded {\n\nnamespace {\n\n";
+    const auto title{decode(dir / "title.png")};
+    writer.image("title_rgba", title);
+    out << '\n';
+
+    std::string table;
+    for (std::size_t i{0}; i < names.size(); i++) {
+        table +=
+            embed_puzzle(writer, dir, names[i], fmt::format("puzzle{}", i));
+    }
+    if (names.empty()) {
+        out << "constexpr std::array<puzzle, 0> all_puzzles{};\n";
+    }
+    else {
+        out << fmt::format("constexpr std::array<puzzle, {}> all_puzzles{{{{\n",
+                           names.size())
+            << table << "}};\n";
+    }
+    out << "\n}  // namespace\n\n"
+           "std::span<const puzzle> puzzles() noexcept\n{\n"
+           "    return all_puzzles;\n}\n\n"
+           "image title_image() noexcept\n{\n"
+        << fmt::format("    return {};\n", image_ref("title_rgba", title))
+        << "}\n\n}  // namespace grandrounds::embedded\n";
+    return out.str();
+}
+
+}  // namespace
+
+int main(int argc, const char** argv)
+{
+    try {
+        const std::span args{argv, static_cast<std::size_t>(argc)};
+        if (args.size() != 3) {
+            std::cerr << "Usage: embed_assets <PUZZLE_DIR> <OUTPUT_CPP>\n";
+            return 2;
+        }
+        const fs::path output{args[2]};
+        const auto source{generate(args[1])};
+        // Leave an unchanged file alone so that it isn't compiled again.
+        if (fs::exists(output) && slurp(output) == source) {
+            return 0;
+        }
+        std::ofstream stream{output, std::ios::binary};
+        stream << source;
+        if (!stream) {
+            throw std::runtime_error{"Could not write " + output.string()};
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "embed_assets: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef EMBEDDED_ASSETS_HPP
+#define EMBEDDED_ASSETS_HPP
+
+#include "nonogram.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// The puzzles and title image from share/grandrounds/puzzles, decoded at build
+// time by the embed_assets tool and compiled into the game so that it can
+// start without touching the filesystem.
+namespace grandrounds::embedded {
+
+struct image {
+    unsigned int width{};
+    unsigned int height{};
+    std::span<const std::uint8_t> rgba_pixel_data;
+};
+
+// The hints for every row (or column) stored end to end: line i's hints are
+// data[offsets[i]] up to data[offsets[i + 1]].  A colour puzzle's hints have
+// their palette indices in `colors`, at the same offsets.
+struct hint_table {
+    std::span<const std::uint8_t> data;
+    std::span<const std::uint16_t> offsets;
+    std::span<const std::uint8_t> colors;
+};
+
+struct puzzle {
+    std::string_view name;
+    board_coords dimensions;
+    // One bit per cell in row-major order, least significant bit first.
+    std::span<const std::uint8_t> solution_bits;
+    // For a colour puzzle, a byte per cell in the same order: zero for a
+    // clear cell, and otherwise its palette index plus one.  The palette is
+    // red, green and blue bytes.  Both are empty for a black-and-white
+    // puzzle.
+    std::span<const std::uint8_t> solution_colors;
+    std::span<const std::uint8_t> palette_rgb;
+    hint_table row_hints;
+    hint_table col_hints;
+    image photo;
+    image small_photo;
+    std::string_view title;
+    std::string_view description;
+    std::string_view author;
+    std::string_view date;
+    std::string_view license;
+    std::string_view wikipedia;
+    std::optional<int> difficulty;
+    std::optional<int> colors;
+};
+
+// In name order.  Puzzles without a data file aren't embedded.
+std::span<const puzzle> puzzles() noexcept;
+
+image title_image() noexcept;
+
+}  // namespace grandrounds::embedded
+
+#endif  // EMBEDDED_ASSETS_HPP
@@ -10,11 +10,14 @@
 #include <fmt/format.h>
 #include <lodepng.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
 namespace grandrounds {
@@ -63,6 +66,31 @@ std::filesystem::path find_puzzles_dir()
     return fs::canonical(path / "share" / "grandrounds" / "puzzles");
 }
 
+std::optional<std::filesystem::path> puzzle_override_dir()
+{
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    const char* dir{std::getenv("GRANDROUNDS_PUZZLES")};
+    if (dir == nullptr || *dir == '\0') {
+        return std::nullopt;
+    }
+    return std::filesystem::path{dir};
+}
+
+std::vector<std::string> find_puzzle_names(
+    const std::filesystem::path& puzzle_dir)
+{
+    static constexpr std::string_view suffix{"_data.json"};
+    std::vector<std::string> out;
+    for (const auto& entry : std::filesystem::directory_iterator{puzzle_dir}) {
+        const auto filename{entry.path().filename().string()};
+        if (filename.size() > suffix.size() && filename.ends_with(suffix)) {
+            out.push_back(filename.substr(0, filename.size() - suffix.size()));
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
 loaded_image load_image(const std::filesystem::path& nonogram_png_path)
 {
     loaded_image out;
@@ -76,4 +104,16 @@ loaded_image load_image(const std::filesystem::path& nonogram_png_path)
     return out;
 }
 
+void save_image(const std::filesystem::path& png_path,
+                const loaded_image& image)
+{
+    const auto error{lodepng::encode(png_path.string(), image.rgba_pixel_data,
+                                     image.width, image.height)};
+    if (error != 0) {
+        throw file_error{fmt::format("Could not save {}: {} {}",
+                                     png_path.string(), error,
+                                     lodepng_error_text(error))};
+    }
+}
+
 }  // namespace grandrounds
@@ -10,7 +10,9 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace grandrounds {
@@ -37,9 +39,22 @@ std::string slurp(const std::filesystem::path& path);
 // Auto-detect the directory containing puzzle files.
 std::filesystem::path find_puzzles_dir();
 
+// The directory named by the GRANDROUNDS_PUZZLES environment variable, if it
+// is set.  Puzzles there take precedence over the ones built into the game.
+std::optional<std::filesystem::path> puzzle_override_dir();
+
+// The names of the puzzles in a puzzle directory, in alphabetical order.  A
+// puzzle named "foo" has a data file named "foo_data.json".
+std::vector<std::string> find_puzzle_names(
+    const std::filesystem::path& puzzle_dir);
+
 // Load a PNG file and decode it to RGBA pixel data.
 loaded_image load_image(const std::filesystem::path& nonogram_png_path);
 
+// Encode RGBA pixel data as a PNG file.
+void save_image(const std::filesystem::path& png_path,
+                const loaded_image& image);
+
 }  // namespace grandrounds
 
 #endif  // FILE_HPP
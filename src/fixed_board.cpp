@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "fixed_board.hpp"
+
+#include <gsl/narrow>
+
+#include <optional>
+#include <tuple>
+
+namespace grandrounds {
+
+namespace {
+
+template <std::size_t W, std::size_t H>
+struct board_size {
+    static constexpr std::size_t width{W};
+    static constexpr std::size_t height{H};
+};
+
+// The sizes with a specialised code path: squares, and the landscape shapes
+// that photos crop to, 25x20 being the generator's default.
+using fixed_sizes = std::tuple<board_size<5, 5>,
+                               board_size<10, 10>,
+                               board_size<15, 10>,
+                               board_size<15, 15>,
+                               board_size<20, 15>,
+                               board_size<20, 20>,
+                               board_size<25, 20>,
+                               board_size<25, 25>,
+                               board_size<30, 20>,
+                               board_size<30, 30>>;
+
+// Copy runtime hints into fixed storage.  More hints than fit can't be placed
+// in the line at all, so that's reported as a contradiction.
+template <std::size_t N>
+bool to_fixed_hints(const line_hints& hints, fixed_hints<N>& out) noexcept
+{
+    if (hints.size() > out.runs.size()) {
+        return false;
+    }
+    out.count = 0;
+    for (const auto hint : hints) {
+        out.runs[out.count++] = hint;
+    }
+    return true;
+}
+
+template <std::size_t W, std::size_t H>
+bool propagate_fixed_size(const std::vector<line_hints>& row_hints,
+                          const std::vector<line_hints>& col_hints,
+                          std::span<solver_cell> cells,
+                          propagation_trace& trace)
+{
+    fixed_row_hints<W, H> fixed_rows;
+    fixed_col_hints<W, H> fixed_cols;
+    for (std::size_t y{0}; y < H; y++) {
+        if (!to_fixed_hints(row_hints[y], fixed_rows[y])) {
+            return false;
+        }
+    }
+    for (std::size_t x{0}; x < W; x++) {
+        if (!to_fixed_hints(col_hints[x], fixed_cols[x])) {
+            return false;
+        }
+    }
+
+    fixed_board<W, H> board;
+    for (std::size_t y{0}; y < H; y++) {
+        for (std::size_t x{0}; x < W; x++) {
+            board.set(x, y, cells[y * W + x]);
+        }
+    }
+    const bool consistent{
+        propagate_fixed_lines(board, fixed_rows, fixed_cols, &trace)};
+    for (std::size_t y{0}; y < H; y++) {
+        for (std::size_t x{0}; x < W; x++) {
+            cells[y * W + x] = board.cell(x, y);
+        }
+    }
+    return consistent;
+}
+
+template <typename... Sizes>
+std::optional<bool> dispatch_fixed_size(
+    board_coords dimensions,
+    const std::vector<line_hints>& row_hints,
+    const std::vector<line_hints>& col_hints,
+    std::span<solver_cell> cells,
+    propagation_trace& trace,
+    std::tuple<Sizes...> /*sizes*/)
+{
+    std::optional<bool> out;
+    const auto matches{[&](std::size_t width, std::size_t height) {
+        return gsl::narrow<std::size_t>(dimensions.x) == width &&
+               gsl::narrow<std::size_t>(dimensions.y) == height;
+    }};
+    static_cast<void>(
+        ((matches(Sizes::width, Sizes::height) &&
+          (out = propagate_fixed_size<Sizes::width, Sizes::height>(
+               row_hints, col_hints, cells, trace),
+           true)) ||
+         ...));
+    return out;
+}
+
+}  // namespace
+
+bool propagate_lines(board_coords dimensions,
+                     const std::vector<line_hints>& row_hints,
+                     const std::vector<line_hints>& col_hints,
+                     std::span<solver_cell> cells)
+{
+    propagation_trace trace;
+    if (const auto result{propagate_fixed_size_lines(
+            dimensions, row_hints, col_hints, cells, trace)}) {
+        return *result;
+    }
+    return propagate_lines_dynamic(dimensions, row_hints, col_hints, cells);
+}
+
+std::optional<bool> propagate_fixed_size_lines(
+    board_coords dimensions,
+    const std::vector<line_hints>& row_hints,
+    const std::vector<line_hints>& col_hints,
+    std::span<solver_cell> cells,
+    propagation_trace& trace)
+{
+    return dispatch_fixed_size(dimensions, row_hints, col_hints, cells, trace,
+                               fixed_sizes{});
+}
+
+bool propagate_lines_dynamic(board_coords dimensions,
+                             const std::vector<line_hints>& row_hints,
+                             const std::vector<line_hints>& col_hints,
+                             std::span<solver_cell> cells)
+{
+    const auto width{gsl::narrow<std::size_t>(dimensions.x)};
+    const auto height{gsl::narrow<std::size_t>(dimensions.y)};
+    line_solver solver;
+    std::vector<solver_cell> line;
+    bool changed{true};
+    while (changed) {
+        changed = false;
+        const auto solve{[&](const line_hints& hints, std::size_t start,
+                             std::size_t step, std::size_t count) {
+            line.clear();
+            for (std::size_t i{0}; i < count; i++) {
+                line.push_back(cells[start + i * step]);
+            }
+            if (!solver.solve(hints, line)) {
+                return false;
+            }
+            for (std::size_t i{0}; i < count; i++) {
+                auto& cell{cells[start + i * step]};
+                changed = changed || cell != line[i];
+                cell = line[i];
+            }
+            return true;
+        }};
+        for (std::size_t y{0}; y < height; y++) {
+            if (!solve(row_hints[y], y * width, 1, width)) {
+                return false;
+            }
+        }
+        for (std::size_t x{0}; x < width; x++) {
+            if (!solve(col_hints[x], x, width, height)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace grandrounds
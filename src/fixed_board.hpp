@@ -0,0 +1,411 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef FIXED_BOARD_HPP
+#define FIXED_BOARD_HPP
+
+#include "solver.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Boards whose dimensions are template parameters.  Each line is a pair of bit
+// masks, so hints, solution checks and line solving need no allocation and can
+// run at compile time, and the compiler can unroll loops over the cells.
+namespace grandrounds {
+
+template <std::size_t N>
+concept fixed_line_length = N > 0 && N <= 64;
+
+template <std::size_t N>
+    requires fixed_line_length<N>
+constexpr std::uint64_t fixed_line_mask{N == 64 ? ~std::uint64_t{0}
+                                                : (std::uint64_t{1} << N) - 1};
+
+// A row or column.  A cell in neither mask is unknown.
+template <std::size_t N>
+    requires fixed_line_length<N>
+struct fixed_line {
+    std::uint64_t filled{0};  // Bit i is cell i
+    std::uint64_t empty{0};
+
+    [[nodiscard]] constexpr bool complete() const noexcept
+    {
+        return (filled | empty) == fixed_line_mask<N>;
+    }
+
+    constexpr bool operator==(const fixed_line&) const = default;
+};
+
+// The hints for a line of length N, which has room for at most (N + 1) / 2.
+template <std::size_t N>
+    requires fixed_line_length<N>
+struct fixed_hints {
+    std::array<std::uint8_t, (N + 1) / 2> runs{};
+    std::size_t count{0};
+
+    constexpr fixed_hints() = default;
+    constexpr fixed_hints(std::initializer_list<std::uint8_t> hints) noexcept
+    {
+        for (const auto hint : hints) {
+            runs[count++] = hint;
+        }
+    }
+
+    [[nodiscard]] constexpr std::span<const std::uint8_t> view() const noexcept
+    {
+        return {runs.data(), count};
+    }
+
+    constexpr bool operator==(const fixed_hints&) const = default;
+};
+
+template <std::size_t N>
+[[nodiscard]] constexpr fixed_hints<N> fixed_line_hints(
+    std::uint64_t filled) noexcept
+{
+    fixed_hints<N> out;
+    std::uint8_t run{0};
+    for (std::size_t i{0}; i < N; i++) {
+        if (((filled >> i) & 1U) != 0) {
+            run++;
+        }
+        else if (run > 0) {
+            out.runs[out.count++] = run;
+            run = 0;
+        }
+    }
+    if (run > 0) {
+        out.runs[out.count++] = run;
+    }
+    return out;
+}
+
+// The same deductions as line_solver::solve(), with the dynamic programming
+// tables held as one bit per hint instead of one byte.  Returns false, leaving
+// `line` unmodified, if no placement of the hints fits the known cells.
+template <std::size_t N>
+constexpr bool solve_fixed_line(const fixed_hints<N>& hints,
+                                fixed_line<N>& line) noexcept
+{
+    const std::size_t k{hints.count};
+    const auto bit{[](std::size_t i) { return std::uint64_t{1} << i; }};
+    const auto filled{
+        [&](std::size_t i) { return (line.filled & bit(i)) != 0; }};
+
+    std::array<std::size_t, N + 1> empty_prefix{};
+    for (std::size_t i{0}; i < N; i++) {
+        empty_prefix[i + 1] =
+            empty_prefix[i] + ((line.empty & bit(i)) != 0 ? 1 : 0);
+    }
+    const auto fits{[&](std::size_t start, std::size_t length) {
+        return start + length <= N &&
+               empty_prefix[start + length] == empty_prefix[start];
+    }};
+
+    // Bit j of suffix[i]: cells [i, N) can hold exactly blocks j..k-1.
+    std::array<std::uint64_t, N + 1> suffix{};
+    suffix[N] = bit(k);
+    for (std::size_t i{N}; i-- > 0;) {
+        std::uint64_t ok{filled(i) ? 0 : suffix[i + 1]};
+        for (std::size_t j{0}; j < k; j++) {
+            const std::size_t end{i + hints.runs[j]};
+            if ((ok & bit(j)) == 0 && fits(i, hints.runs[j]) &&
+                (end == N ? j + 1 == k
+                          : !filled(end) &&
+                                (suffix[end + 1] & bit(j + 1)) != 0)) {
+                ok |= bit(j);
+            }
+        }
+        suffix[i] = ok;
+    }
+    if ((suffix[0] & 1U) == 0) {
+        return false;
+    }
+
+    // Bit j of prefix[i]: cells [0, i) can hold exactly blocks 0..j-1.
+    std::array<std::uint64_t, N + 1> prefix{};
+    prefix[0] = 1;
+    for (std::size_t i{0}; i < N; i++) {
+        std::uint64_t ok{filled(i) ? 0 : prefix[i]};
+        for (std::size_t j{1}; j <= k; j++) {
+            const std::size_t length{hints.runs[j - 1]};
+            if (i + 1 < length) {
+                continue;
+            }
+            const std::size_t start{i + 1 - length};
+            if (fits(start, length) &&
+                (start == 0 ? j == 1
+                            : !filled(start - 1) &&
+                                  (prefix[start - 1] & bit(j - 1)) != 0)) {
+                ok |= bit(j);
+            }
+        }
+        prefix[i + 1] = ok;
+    }
+
+    std::uint64_t can_fill{0};
+    for (std::size_t j{0}; j < k; j++) {
+        const std::size_t length{hints.runs[j]};
+        for (std::size_t start{0}; start + length <= N; start++) {
+            const std::size_t end{start + length};
+            if (fits(start, length) &&
+                (start == 0 ? j == 0
+                            : !filled(start - 1) &&
+                                  (prefix[start - 1] & bit(j)) != 0) &&
+                (end == N ? j + 1 == k
+                          : !filled(end) &&
+                                (suffix[end + 1] & bit(j + 1)) != 0)) {
+                can_fill |= fixed_line_mask<N> >> (N - length) << start;
+            }
+        }
+    }
+    std::uint64_t can_empty{0};
+    for (std::size_t c{0}; c < N; c++) {
+        if ((prefix[c] & suffix[c + 1]) != 0) {
+            can_empty |= bit(c);
+        }
+    }
+
+    const std::uint64_t unknown{~(line.filled | line.empty) &
+                                fixed_line_mask<N>};
+    line.filled |= unknown & can_fill & ~can_empty;
+    line.empty |= unknown & can_empty & ~can_fill;
+    return true;
+}
+
+template <std::size_t W, std::size_t H>
+    requires fixed_line_length<W> && fixed_line_length<H>
+class fixed_board {
+   public:
+    static constexpr std::size_t width{W};
+    static constexpr std::size_t height{H};
+
+    constexpr fixed_board() = default;
+
+    // A picture of the board in row-major order: '#' is filled, '.' is empty
+    // and anything else is unknown.
+    explicit constexpr fixed_board(const char (&picture)[W * H + 1]) noexcept
+    {
+        for (std::size_t y{0}; y < H; y++) {
+            for (std::size_t x{0}; x < W; x++) {
+                const char c{picture[y * W + x]};
+                set(x, y,
+                    c == '#'   ? solver_cell::filled
+                    : c == '.' ? solver_cell::empty
+                               : solver_cell::unknown);
+            }
+        }
+    }
+
+    [[nodiscard]] constexpr solver_cell cell(std::size_t x,
+                                             std::size_t y) const noexcept
+    {
+        const std::uint64_t bit{std::uint64_t{1} << x};
+        if ((rows_[y].filled & bit) != 0) {
+            return solver_cell::filled;
+        }
+        return (rows_[y].empty & bit) != 0 ? solver_cell::empty
+                                           : solver_cell::unknown;
+    }
+
+    constexpr void set(std::size_t x, std::size_t y, solver_cell value) noexcept
+    {
+        const std::uint64_t bit{std::uint64_t{1} << x};
+        rows_[y].filled &= ~bit;
+        rows_[y].empty &= ~bit;
+        if (value == solver_cell::filled) {
+            rows_[y].filled |= bit;
+        }
+        else if (value == solver_cell::empty) {
+            rows_[y].empty |= bit;
+        }
+    }
+
+    [[nodiscard]] constexpr fixed_line<W> row(std::size_t y) const noexcept
+    {
+        return rows_[y];
+    }
+
+    constexpr void set_row(std::size_t y, fixed_line<W> line) noexcept
+    {
+        rows_[y] = line;
+    }
+
+    [[nodiscard]] constexpr fixed_line<H> col(std::size_t x) const noexcept
+    {
+        fixed_line<H> out;
+        for (std::size_t y{0}; y < H; y++) {
+            out.filled |= ((rows_[y].filled >> x) & 1U) << y;
+            out.empty |= ((rows_[y].empty >> x) & 1U) << y;
+        }
+        return out;
+    }
+
+    constexpr void set_col(std::size_t x, fixed_line<H> line) noexcept
+    {
+        for (std::size_t y{0}; y < H; y++) {
+            rows_[y].filled = (rows_[y].filled & ~(std::uint64_t{1} << x)) |
+                              ((line.filled >> y) & 1U) << x;
+            rows_[y].empty = (rows_[y].empty & ~(std::uint64_t{1} << x)) |
+                             ((line.empty >> y) & 1U) << x;
+        }
+    }
+
+    [[nodiscard]] constexpr bool complete() const noexcept
+    {
+        for (const auto& line : rows_) {
+            if (!line.complete()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool operator==(const fixed_board&) const = default;
+
+   private:
+    std::array<fixed_line<W>, H> rows_{};
+};
+
+template <std::size_t W, std::size_t H>
+using fixed_row_hints = std::array<fixed_hints<W>, H>;
+template <std::size_t W, std::size_t H>
+using fixed_col_hints = std::array<fixed_hints<H>, W>;
+
+template <std::size_t W, std::size_t H>
+[[nodiscard]] constexpr fixed_row_hints<W, H> calculate_fixed_row_hints(
+    const fixed_board<W, H>& board) noexcept
+{
+    fixed_row_hints<W, H> out;
+    for (std::size_t y{0}; y < H; y++) {
+        out[y] = fixed_line_hints<W>(board.row(y).filled);
+    }
+    return out;
+}
+
+template <std::size_t W, std::size_t H>
+[[nodiscard]] constexpr fixed_col_hints<W, H> calculate_fixed_col_hints(
+    const fixed_board<W, H>& board) noexcept
+{
+    fixed_col_hints<W, H> out;
+    for (std::size_t x{0}; x < W; x++) {
+        out[x] = fixed_line_hints<H>(board.col(x).filled);
+    }
+    return out;
+}
+
+// Whether a board's filled cells match the hints.  Unknown cells count as
+// empty, so a player's board can be checked as it is.
+template <std::size_t W, std::size_t H>
+[[nodiscard]] constexpr bool check_fixed_solution(
+    const fixed_board<W, H>& board,
+    const fixed_row_hints<W, H>& row_hints,
+    const fixed_col_hints<W, H>& col_hints) noexcept
+{
+    return calculate_fixed_row_hints(board) == row_hints &&
+           calculate_fixed_col_hints(board) == col_hints;
+}
+
+// What propagate_fixed_lines() did, for the solver's statistics.
+struct propagation_trace {
+    std::uint64_t rounds{0};
+    std::uint64_t line_solves{0};
+    std::uint64_t deduced_rows{0};  // Bit y: row y yielded a deduction
+    std::uint64_t deduced_cols{0};  // Bit x: column x yielded a deduction
+};
+
+// Solve rows and columns in turn until nothing changes, only re-solving lines
+// that cross a cell learned since they were last solved.  Returns false if a
+// line has no consistent placement, leaving the board partly narrowed.
+template <std::size_t W, std::size_t H>
+constexpr bool propagate_fixed_lines(
+    fixed_board<W, H>& board,
+    const fixed_row_hints<W, H>& row_hints,
+    const fixed_col_hints<W, H>& col_hints,
+    propagation_trace* trace = nullptr) noexcept
+{
+    propagation_trace local;
+    auto& out{trace != nullptr ? *trace : local};
+    // Bit y of dirty_rows is row y; bit x of dirty_cols is column x.
+    std::uint64_t dirty_rows{fixed_line_mask<H>};
+    std::uint64_t dirty_cols{fixed_line_mask<W>};
+    while (dirty_rows != 0 || dirty_cols != 0) {
+        out.rounds++;
+        for (std::size_t y{0}; y < H; y++) {
+            if ((dirty_rows & (std::uint64_t{1} << y)) == 0) {
+                continue;
+            }
+            const auto before{board.row(y)};
+            auto line{before};
+            out.line_solves++;
+            if (!solve_fixed_line(row_hints[y], line)) {
+                return false;
+            }
+            board.set_row(y, line);
+            const std::uint64_t learned{(line.filled | line.empty) ^
+                                        (before.filled | before.empty)};
+            dirty_cols |= learned;
+            if (learned != 0) {
+                out.deduced_rows |= std::uint64_t{1} << y;
+            }
+        }
+        dirty_rows = 0;
+        for (std::size_t x{0}; x < W; x++) {
+            if ((dirty_cols & (std::uint64_t{1} << x)) == 0) {
+                continue;
+            }
+            const auto before{board.col(x)};
+            auto line{before};
+            out.line_solves++;
+            if (!solve_fixed_line(col_hints[x], line)) {
+                return false;
+            }
+            board.set_col(x, line);
+            const std::uint64_t learned{(line.filled | line.empty) ^
+                                        (before.filled | before.empty)};
+            dirty_rows |= learned;
+            if (learned != 0) {
+                out.deduced_cols |= std::uint64_t{1} << x;
+            }
+        }
+        dirty_cols = 0;
+    }
+    return true;
+}
+
+// Line propagation on a row-major board of any size.  Common puzzle sizes use
+// a fixed_board; others fall back to line_solver.  Returns false if the hints
+// contradict the board.
+bool propagate_lines(board_coords dimensions,
+                     const std::vector<line_hints>& row_hints,
+                     const std::vector<line_hints>& col_hints,
+                     std::span<solver_cell> cells);
+
+// propagate_lines() for the sizes that use a fixed_board, recording what it did
+// in `trace`.  Returns nothing, leaving `cells` alone, for other sizes.
+std::optional<bool> propagate_fixed_size_lines(
+    board_coords dimensions,
+    const std::vector<line_hints>& row_hints,
+    const std::vector<line_hints>& col_hints,
+    std::span<solver_cell> cells,
+    propagation_trace& trace);
+
+// The dynamic version of propagate_lines(), for comparison.
+bool propagate_lines_dynamic(board_coords dimensions,
+                             const std::vector<line_hints>& row_hints,
+                             const std::vector<line_hints>& col_hints,
+                             std::span<solver_cell> cells);
+
+}  // namespace grandrounds
+
+#endif  // FIXED_BOARD_HPP
@@ -5,23 +5,46 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 
+#include "compact_image.hpp"
+#include "embedded_assets.hpp"
 #include "file.hpp"
+#include "game.hpp"
 #include "grid.hpp"
 #include "nonogram.hpp"
 #include "nonogram_ftxui.hpp"
+#include "puzzle_cache.hpp"
 #include "range.hpp"
+#include "recording.hpp"
+#include "terminal_output.hpp"
 
 #include <fmt/format.h>
 #include <ftxui/component/captured_mouse.hpp>      // for ftxui
 #include <ftxui/component/component.hpp>           // for Slider
 #include <ftxui/component/screen_interactive.hpp>  // for ScreenInteractive
+#include <ftxui/screen/terminal.hpp>                // for Terminal
 
 #include <gsl/narrow>
+#include <gsl/util>
 
 #include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <stop_token>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 // This file will be generated automatically when you run the CMake
@@ -33,11 +56,134 @@ namespace grandrounds {
 
 namespace {
 
+// Comfortably more than every built-in puzzle together, so that going back to
+// a puzzle never reloads it, while bounding what a large override directory
+// can use.
+constexpr std::size_t puzzle_cache_bytes{64UL * 1024 * 1024};
+
+// Photos in more colours than the terminal can show, or than the render
+// options draw with, would only be reduced when drawn, so they may as well be
+// stored reduced.
+void match_photo_format_to_terminal()
+{
+    set_photo_format(ftxui::Terminal::ColorSupport() ==
+                                 ftxui::Terminal::Color::TrueColor &&
+                             current_render_options().colors ==
+                                 palette::true_color
+                         ? pixel_format::rgb
+                         : pixel_format::indexed);
+}
+
+// Run `play`, and if the render options save any output, meter what it
+// writes to the terminal and report that once its screen has closed.
+template <typename Play>
+void play_metered(Play play)
+{
+    const auto options{current_render_options()};
+    if (options == render_options{}) {
+        play();
+        return;
+    }
+    frame_stats stats;
+    {
+        const frame_meter meter{std::cout, options.skip_unchanged_frames};
+        play();
+        stats = meter.stats();
+    }
+    fmt::print("Terminal output: {}\n", describe_frames(stats));
+}
+
+puzzle_cache& loaded_puzzles()
+{
+    static puzzle_cache cache{puzzle_cache_bytes};
+    return cache;
+}
+
+// The loading screen's spinner: ftxui's braille charset, turning at 10 Hz.
+constexpr int spinner_charset{15};
+constexpr std::chrono::milliseconds spinner_period{100};
+
+// Show `message` beside a spinner until `ready` returns true.  A ticker
+// thread wakes the screen each spinner period, both to turn the spinner and
+// so that the screen notices `ready` even if nothing else happens.
+void show_loading(ftxui::ScreenInteractive& screen,
+                  const std::string& message,
+                  const std::function<bool()>& ready)
+{
+    const auto start{std::chrono::steady_clock::now()};
+    auto renderer{ftxui::Renderer([&] {
+        if (ready()) {
+            screen.ExitLoopClosure()();
+        }
+        const auto frame{(std::chrono::steady_clock::now() - start) /
+                         spinner_period};
+        return ftxui::center(ftxui::hbox(
+            {ftxui::spinner(spinner_charset, gsl::narrow<std::size_t>(frame)),
+             ftxui::text(" " + message)}));
+    })};
+
+    std::mutex ticker_mutex;
+    std::condition_variable_any ticker_wake;
+    const std::jthread ticker{[&](const std::stop_token& stop) {
+        std::unique_lock lock{ticker_mutex};
+        while (!ticker_wake.wait_for(lock, stop, spinner_period,
+                                     [] { return false; })) {
+            if (stop.stop_requested()) {
+                return;
+            }
+            screen.PostEvent(ftxui::Event::Custom);
+        }
+    }};
+
+    screen.Loop(renderer);
+}
+
+// Loading happens on other threads so that the screen never waits on storage
+// or decoding.  start_loading() runs `work` on a new thread, which wakes the
+// screen when it's done; finish_loading() shows a loading screen until then
+// if it isn't done already, and returns what the work returned or rethrows
+// what it threw.
+template <typename Work>
+auto start_loading(ftxui::ScreenInteractive& screen, Work work)
+{
+    return std::async(std::launch::async,
+                      [&screen, work = std::move(work)] {
+                          const auto wake{gsl::finally([&screen] {
+                              screen.PostEvent(ftxui::Event::Custom);
+                          })};
+                          return work();
+                      });
+}
+
+template <typename T>
+T finish_loading(ftxui::ScreenInteractive& screen,
+                 const std::string& message,
+                 std::future<T> loading)
+{
+    const auto ready{[&loading] {
+        return loading.wait_for(std::chrono::seconds{0}) ==
+               std::future_status::ready;
+    }};
+    if (!ready()) {
+        show_loading(screen, message, ready);
+    }
+    return loading.get();
+}
+
+std::future<std::shared_ptr<const nonogram_puzzle>> start_loading_puzzle(
+    ftxui::ScreenInteractive& screen,
+    std::string name)
+{
+    return start_loading(screen, [name = std::move(name)] {
+        return loaded_puzzles().get(name);
+    });
+}
+
 void show_info(ftxui::ScreenInteractive& screen, nonogram_game& game)
 {
     auto& photo{game.puzzle->photo};
-    int width{gsl::narrow<int>(photo.width)};
-    int height{gsl::narrow<int>(photo.height)};
+    int width{gsl::narrow<int>(photo.width())};
+    int height{gsl::narrow<int>(photo.height())};
     ftxui::Canvas canvas{width * 2, height * 2};
     draw_photo_on_canvas(canvas, photo, {0, 0});
 
@@ -58,75 +204,193 @@ void show_info(ftxui::ScreenInteractive& screen, nonogram_game& game)
     screen.Loop(button_with_info);
 }
 
-void play_puzzle(ftxui::ScreenInteractive& screen, std::string_view name)
+void play_puzzle(ftxui::ScreenInteractive& screen,
+                 std::string_view name,
+                 std::shared_ptr<const nonogram_puzzle> loaded,
+                 const std::optional<std::filesystem::path>& record_path)
 {
-    auto game{std::make_shared<nonogram_game>()};
-    game->puzzle = std::make_shared<nonogram_puzzle>(name);
-    game->board.resize(game->puzzle->solution.size());
+    auto puzzle{make_puzzle_screen(
+        std::move(loaded), screen.ExitLoopClosure(),
+        [&screen] { screen.PostEvent(ftxui::Event::Custom); })};
+
+    if (record_path) {
+        const auto size{ftxui::Terminal::Size()};
+        event_recorder recorder{std::string{name}, {size.dimx, size.dimy}};
+        screen.Loop(recorder.wrap(puzzle.root));
+        save_recording(*record_path, recorder.recording());
+    }
+    else {
+        screen.Loop(puzzle.root);
+    }
+
+    if (puzzle.board->IsSolved()) {
+        show_info(screen, *puzzle.game);
+    }
+}
 
-    const std::string solve_text{"Solve"};
-    const std::string reset_text{"Reset"};
-    std::string quit_continue_text{"Quit"};
+}  // namespace
+
+puzzle_screen make_puzzle_screen(std::string_view name,
+                                 std::function<void()> exit,
+                                 std::function<void()> request_redraw)
+{
+    return make_puzzle_screen(loaded_puzzles().get(name), std::move(exit),
+                              std::move(request_redraw));
+}
 
-    auto puzzle_component{std::make_shared<nonogram_component>(game)};
+puzzle_screen make_puzzle_screen(
+    std::shared_ptr<const nonogram_puzzle> puzzle,
+    std::function<void()> exit,
+    std::function<void()> request_redraw)
+{
+    struct button_labels {
+        std::string solve{"Solve"};
+        std::string reset{"Reset"};
+        std::string assist{"Assist: off"};
+        std::string quit{"Quit"};
+    };
+
+    puzzle_screen out;
+    out.game = std::make_shared<nonogram_game>();
+    out.game->puzzle = std::move(puzzle);
+    out.game->board.resize(out.game->puzzle->solution.size());
+    out.board = std::make_shared<nonogram_component>(out.game);
+
+    // The buttons hold pointers to their labels, so the labels live as long
+    // as the buttons' callbacks, which share them.
+    const auto labels{std::make_shared<button_labels>()};
+    const auto board{out.board};
     auto solve_button{
-        ftxui::Button(&solve_text, [&] { puzzle_component->Solve(); })};
+        ftxui::Button(&labels->solve, [labels, board] { board->Solve(); })};
     auto reset_button{
-        ftxui::Button(&reset_text, [&] { puzzle_component->Reset(); })};
-
-    auto quit_button{
-        ftxui::Button(&quit_continue_text, screen.ExitLoopClosure())};
-    auto right_container{
-        ftxui::Container::Vertical({solve_button, reset_button, quit_button})};
+        ftxui::Button(&labels->reset, [labels, board] { board->Reset(); })};
+    auto assist_button{ftxui::Button(
+        &labels->assist,
+        [labels, board, request_redraw = std::move(request_redraw)] {
+            if (board->IsAssisting()) {
+                board->DisableAssist();
+                labels->assist = "Assist: off";
+            }
+            else {
+                board->EnableAssist(request_redraw);
+                labels->assist = "Assist: on";
+            }
+        })};
+    auto quit_button{ftxui::Button(
+        &labels->quit, [labels, exit = std::move(exit)] { exit(); })};
+    // The assistant only reasons about black-and-white puzzles.
+    const bool can_assist{!out.game->puzzle->is_colored()};
+    auto right_container{ftxui::Container::Vertical(
+        can_assist ? ftxui::Components{solve_button, reset_button,
+                                       assist_button, quit_button}
+                   : ftxui::Components{solve_button, reset_button,
+                                       quit_button})};
 
     std::vector<ftxui::Component> all_components;
-    all_components.push_back(puzzle_component);
-
-    auto right_panel{ftxui::Renderer(right_container, [&] {
-        return ftxui::vbox(
-            {{ftxui::text(fmt::format("Width: {}", game->puzzle->dimensions.x)),
-              ftxui::text(
-                  fmt::format("Height: {}", game->puzzle->dimensions.y)),
-              solve_button->Render(), reset_button->Render(),
-              quit_button->Render()}});
+    all_components.push_back(out.board);
+
+    auto right_panel{ftxui::Renderer(right_container, [=, game = out.game] {
+        ftxui::Elements lines{
+            ftxui::text(fmt::format("Width: {}", game->puzzle->dimensions.x)),
+            ftxui::text(fmt::format("Height: {}", game->puzzle->dimensions.y)),
+            solve_button->Render(), reset_button->Render()};
+        if (can_assist) {
+            lines.push_back(assist_button->Render());
+        }
+        lines.push_back(quit_button->Render());
+        return ftxui::vbox(std::move(lines));
     })};
     all_components.push_back(right_panel);
 
-    auto container = ftxui::Container::Horizontal(all_components);
-
-    screen.Loop(container);
-
-    if (puzzle_component->IsSolved()) {
-        show_info(screen, *game);
-    }
+    out.root = ftxui::Container::Horizontal(all_components);
+    return out;
 }
 
-}  // namespace
-
 // Suppress cppcheck because passing string_view by value is correct.
 // cppcheck-suppress passedByValue
-void play_puzzle(std::string_view name)
+void play_puzzle(std::string_view name,
+                 const std::optional<std::filesystem::path>& record_path)
 {
-    auto screen{ftxui::ScreenInteractive::Fullscreen()};
-    play_puzzle(screen, name);
+    match_photo_format_to_terminal();
+    play_metered([&] {
+        auto screen{ftxui::ScreenInteractive::Fullscreen()};
+        auto puzzle{
+            finish_loading(screen, fmt::format("Loading {}", name),
+                           start_loading_puzzle(screen, std::string{name}))};
+        play_puzzle(screen, name, std::move(puzzle), record_path);
+    });
+}
+
+// Puzzle names from easiest to hardest, using the difficulty cached in each
+// puzzle's data file by "grandrounds rate".  Unrated puzzles come last.  The
+// built-in puzzles are listed along with any in GRANDROUNDS_PUZZLES, which
+// replace built-in puzzles of the same name.
+std::vector<std::string> puzzles_by_difficulty()
+{
+    std::map<std::string, std::optional<int>> difficulties;
+    for (const auto& puzzle : embedded::puzzles()) {
+        difficulties[std::string{puzzle.name}] = puzzle.difficulty;
+    }
+    if (const auto puzzle_dir{puzzle_override_dir()}) {
+        for (const auto& name : find_puzzle_names(*puzzle_dir)) {
+            difficulties[name] =
+                load_puzzle_data(*puzzle_dir /
+                                 fmt::format("{}_data.json", name))
+                    .difficulty;
+        }
+    }
+
+    std::vector<std::pair<int, std::string>> rated;
+    for (const auto& [name, difficulty] : difficulties) {
+        rated.emplace_back(difficulty.value_or(INT_MAX), name);
+    }
+    r::stable_sort(rated, std::less{}, [](const auto& p) { return p.first; });
+    return rated | rv::values | r::to<std::vector>;
 }
 
 void play_puzzles(ftxui::ScreenInteractive& screen)
 {
-    play_puzzle(screen, "cottontail");
-    play_puzzle(screen, "lake_mendoza");
+    const auto names{finish_loading(screen, "Finding puzzles",
+                                    start_loading(screen, [] {
+                                        return puzzles_by_difficulty();
+                                    }))};
+    if (names.empty()) {
+        return;
+    }
+    // Each puzzle loads while the one before it is played, so the loading
+    // screen only shows if a puzzle is solved faster than the next one loads.
+    auto next{start_loading_puzzle(screen, names.front())};
+    for (std::size_t i{0}; i < names.size(); i++) {
+        auto puzzle{finish_loading(
+            screen,
+            fmt::format("Loading puzzle {} of {}", i + 1, names.size()),
+            std::move(next))};
+        if (i + 1 < names.size()) {
+            next = start_loading_puzzle(screen, names[i + 1]);
+        }
+        play_puzzle(screen, names[i], std::move(puzzle), std::nullopt);
+    }
 }
 
-loaded_image load_title_image()
+compact_image load_title_image()
 {
-    return load_image(find_puzzles_dir() / "title.png");
+    if (const auto puzzle_dir{puzzle_override_dir()}) {
+        const auto title_path{*puzzle_dir / "title.png"};
+        if (std::filesystem::exists(title_path)) {
+            return load_compact_image(title_path, photo_format());
+        }
+    }
+    const auto title{embedded::title_image()};
+    return compact_image::from_rgba(title.rgba_pixel_data, title.width,
+                                    title.height, photo_format());
 }
 
-void play_game()
+void play_title()
 {
     auto screen{ftxui::ScreenInteractive::Fullscreen()};
     ftxui::Canvas canvas{160, 96};  // NOLINT magic number to fit terminal
-    auto title_image{load_title_image()};
+    const auto title_image{finish_loading(
+        screen, "Loading", start_loading(screen, load_title_image))};
     draw_photo_on_canvas(canvas, title_image, {0, 0});
 
     bool start_clicked{false};
@@ -165,4 +429,10 @@ void play_game()
     }
 }
 
+void play_game()
+{
+    match_photo_format_to_terminal();
+    play_metered(play_title);
+}
+
 }  // namespace grandrounds
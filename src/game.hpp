@@ -8,11 +8,45 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
+#include "nonogram.hpp"
+#include "nonogram_ftxui.hpp"
+
+#include <ftxui/component/component.hpp>
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string_view>
 
 namespace grandrounds {
 
-void play_puzzle(std::string_view name);
+// The components of the screen a puzzle is played on: the board and the
+// buttons beside it.  Nothing here needs a terminal, so the same screen can
+// be driven headlessly.
+struct puzzle_screen {
+    std::shared_ptr<nonogram_game> game;
+    std::shared_ptr<nonogram_component> board;
+    ftxui::Component root;
+};
+
+// `exit` is called by the Quit button, and `request_redraw` by the assistant
+// when it has new results.  Given a name, the puzzle is loaded, or taken from
+// the puzzle cache, on the calling thread.
+puzzle_screen make_puzzle_screen(std::string_view name,
+                                 std::function<void()> exit,
+                                 std::function<void()> request_redraw);
+puzzle_screen make_puzzle_screen(
+    std::shared_ptr<const nonogram_puzzle> puzzle,
+    std::function<void()> exit,
+    std::function<void()> request_redraw);
+
+// Puzzles load on other threads, behind a loading screen if they take long
+// enough to see.  With a record path, the events handled while playing are
+// saved there for replay_recording().
+void play_puzzle(std::string_view name,
+                 const std::optional<std::filesystem::path>& record_path =
+                     std::nullopt);
 void play_game();
 
 }  // namespace grandrounds
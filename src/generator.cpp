@@ -0,0 +1,446 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "generator.hpp"
+#include "rating.hpp"
+#include "solver.hpp"
+#include "task_pool.hpp"
+
+#include <fmt/format.h>
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <stdexcept>
+
+namespace grandrounds {
+
+namespace {
+
+constexpr std::size_t channels{4};  // RGBA
+constexpr double lanczos_lobes{3.0};
+
+double sinc(double x) noexcept
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    const double pi_x{std::numbers::pi * x};
+    return std::sin(pi_x) / pi_x;
+}
+
+double lanczos(double x) noexcept
+{
+    return std::abs(x) < lanczos_lobes ? sinc(x) * sinc(x / lanczos_lobes)
+                                       : 0.0;
+}
+
+// The input samples read for each output sample along one axis.  Every output
+// reads the same number of inputs so that the inner loops have a fixed trip
+// count; windows that would run off an edge are slid back inside it.
+struct filter_taps {
+    std::size_t count{0};            // Per output sample
+    std::vector<std::size_t> first;  // Per output sample
+    std::vector<float> weights;      // `count` per output sample, summing to 1
+};
+
+filter_taps lanczos_taps(std::size_t in_size, std::size_t out_size)
+{
+    const double scale{static_cast<double>(in_size) /
+                       static_cast<double>(out_size)};
+    // When shrinking, stretch the kernel across the input so that it also
+    // removes detail too fine for the output to hold.
+    const double stretch{std::max(1.0, scale)};
+    const double support{lanczos_lobes * stretch};
+
+    filter_taps out;
+    out.count = std::min(
+        in_size, static_cast<std::size_t>(std::ceil(support * 2.0)) + 1);
+    out.first.resize(out_size);
+    out.weights.resize(out_size * out.count);
+    const auto last_first{static_cast<double>(in_size - out.count)};
+    for (std::size_t o{0}; o < out_size; o++) {
+        const double center{(static_cast<double>(o) + 0.5) * scale - 0.5};
+        const double first{
+            std::clamp(std::ceil(center - support), 0.0, last_first)};
+        out.first[o] = static_cast<std::size_t>(first);
+        const auto weights{
+            std::span{out.weights}.subspan(o * out.count, out.count)};
+        double sum{0.0};
+        for (std::size_t t{0}; t < out.count; t++) {
+            const double weight{
+                lanczos((first + static_cast<double>(t) - center) / stretch)};
+            weights[t] = static_cast<float>(weight);
+            sum += weight;
+        }
+        for (auto& weight : weights) {
+            weight = static_cast<float>(static_cast<double>(weight) / sum);
+        }
+    }
+    return out;
+}
+
+struct float_image {
+    std::vector<float> data;  // RGBA
+    std::size_t width{0};
+    std::size_t height{0};
+};
+
+// The image averaged over blocks of factor_x by factor_y pixels.  A partial
+// block at the right or bottom edge is dropped.
+float_image box_reduce(const loaded_image& image,
+                       std::size_t factor_x,
+                       std::size_t factor_y)
+{
+    float_image out;
+    out.width = image.width / factor_x;
+    out.height = image.height / factor_y;
+    const std::size_t in_row{std::size_t{image.width} * channels};
+    const std::size_t out_row{out.width * channels};
+    out.data.resize(out_row * out.height);
+    const std::span in{image.rgba_pixel_data};
+    const float scale{1.0F / static_cast<float>(factor_x * factor_y)};
+    for (std::size_t y{0}; y < out.height; y++) {
+        const auto dst{std::span{out.data}.subspan(y * out_row, out_row)};
+        for (std::size_t dy{0}; dy < factor_y; dy++) {
+            const auto src{in.subspan((y * factor_y + dy) * in_row, in_row)};
+            for (std::size_t x{0}; x < out.width; x++) {
+                for (std::size_t dx{0}; dx < factor_x; dx++) {
+                    const std::size_t from{(x * factor_x + dx) * channels};
+                    for (std::size_t c{0}; c < channels; c++) {
+                        dst[x * channels + c] += src[from + c];
+                    }
+                }
+            }
+        }
+        for (auto& value : dst) {
+            value *= scale;
+        }
+    }
+    return out;
+}
+
+loaded_image image_from_solution(const std::vector<board_cell>& solution,
+                                 board_coords size)
+{
+    loaded_image out;
+    out.width = gsl::narrow<unsigned int>(size.x);
+    out.height = gsl::narrow<unsigned int>(size.y);
+    out.rgba_pixel_data.reserve(solution.size() * channels);
+    for (const auto cell : solution) {
+        const std::uint8_t value{
+            cell == board_cell::filled ? std::uint8_t{0} : std::uint8_t{255}};
+        out.rgba_pixel_data.insert(out.rgba_pixel_data.end(),
+                                   {value, value, value, 255});
+    }
+    return out;
+}
+
+}  // namespace
+
+loaded_image resize_image(const loaded_image& image,
+                          unsigned int width,
+                          unsigned int height)
+{
+    if (width == 0 || height == 0 || image.width == 0 || image.height == 0) {
+        throw std::invalid_argument{"Cannot resize to or from an empty image"};
+    }
+
+    // Leave the Lanczos filter at least twice the output size to work with.
+    const auto reduced{box_reduce(
+        image, std::max(1U, image.width / (2 * width)),
+        std::max(1U, image.height / (2 * height)))};
+
+    // Vertical pass first: each output row is a weighted sum of whole input
+    // rows, which is a loop compilers vectorise well, and it leaves the
+    // horizontal pass far fewer rows to do.
+    const auto rows{lanczos_taps(reduced.height, height)};
+    const std::size_t row_size{reduced.width * channels};
+    std::vector<float> vertical(row_size * height);
+    const std::span reduced_data{reduced.data};
+    for (std::size_t y{0}; y < height; y++) {
+        const auto dst{std::span{vertical}.subspan(y * row_size, row_size)};
+        for (std::size_t t{0}; t < rows.count; t++) {
+            const float weight{rows.weights[y * rows.count + t]};
+            const auto src{
+                reduced_data.subspan((rows.first[y] + t) * row_size, row_size)};
+            for (std::size_t i{0}; i < row_size; i++) {
+                dst[i] += weight * src[i];
+            }
+        }
+    }
+
+    const auto cols{lanczos_taps(reduced.width, width)};
+    loaded_image out;
+    out.width = width;
+    out.height = height;
+    out.rgba_pixel_data.resize(std::size_t{width} * height * channels);
+    for (std::size_t y{0}; y < height; y++) {
+        const auto src_row{std::span{vertical}.subspan(y * row_size, row_size)};
+        for (std::size_t x{0}; x < width; x++) {
+            std::array<float, channels> sum{};
+            for (std::size_t t{0}; t < cols.count; t++) {
+                const float weight{cols.weights[x * cols.count + t]};
+                const auto src{
+                    src_row.subspan((cols.first[x] + t) * channels, channels)};
+                for (std::size_t c{0}; c < channels; c++) {
+                    sum[c] += weight * src[c];
+                }
+            }
+            for (std::size_t c{0}; c < channels; c++) {
+                out.rgba_pixel_data[(y * width + x) * channels + c] =
+                    static_cast<std::uint8_t>(
+                        std::clamp(std::lround(sum[c]), 0L, 255L));
+            }
+        }
+    }
+    return out;
+}
+
+loaded_image crop_to_aspect(const loaded_image& image, int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument{"Aspect ratio must be positive"};
+    }
+    const std::uint64_t aspect_x{gsl::narrow<std::uint64_t>(width)};
+    const std::uint64_t aspect_y{gsl::narrow<std::uint64_t>(height)};
+    std::uint64_t crop_width{image.width};
+    std::uint64_t crop_height{image.height};
+    if (crop_width * aspect_y > crop_height * aspect_x) {
+        crop_width =
+            std::max<std::uint64_t>(1, crop_height * aspect_x / aspect_y);
+    }
+    else {
+        crop_height =
+            std::max<std::uint64_t>(1, crop_width * aspect_y / aspect_x);
+    }
+
+    loaded_image out;
+    out.width = gsl::narrow<unsigned int>(crop_width);
+    out.height = gsl::narrow<unsigned int>(crop_height);
+    const std::size_t left{(image.width - out.width) / 2};
+    const std::size_t top{(image.height - out.height) / 2};
+    const std::size_t in_row{std::size_t{image.width} * channels};
+    const std::size_t out_row{std::size_t{out.width} * channels};
+    out.rgba_pixel_data.reserve(out_row * out.height);
+    for (std::size_t y{top}; y < top + out.height; y++) {
+        const auto row{image.rgba_pixel_data.begin() +
+                       gsl::narrow<long>(y * in_row + left * channels)};
+        out.rgba_pixel_data.insert(out.rgba_pixel_data.end(), row,
+                                   row + gsl::narrow<long>(out_row));
+    }
+    return out;
+}
+
+thresholded_image adaptive_threshold(const loaded_image& image,
+                                     int radius,
+                                     int offset)
+{
+    const std::size_t width{image.width};
+    const std::size_t height{image.height};
+    const auto reach{gsl::narrow<std::size_t>(radius)};
+
+    std::vector<int> luma(width * height);
+    for (std::size_t i{0}; i < luma.size(); i++) {
+        const auto pixel{std::span{image.rgba_pixel_data}.subspan(i * channels,
+                                                                  channels)};
+        // ITU-R BT.601 weights, in thousandths.
+        constexpr int red{299};
+        constexpr int green{587};
+        constexpr int blue{114};
+        constexpr int total{1000};
+        luma[i] = (red * pixel[0] + green * pixel[1] + blue * pixel[2] +
+                   total / 2) /
+                  total;
+    }
+
+    // A summed-area table with an extra row and column of zeros, so that the
+    // sum over any window is four lookups.
+    const std::size_t stride{width + 1};
+    std::vector<std::int64_t> sums(stride * (height + 1));
+    for (std::size_t y{0}; y < height; y++) {
+        std::int64_t row_sum{0};
+        for (std::size_t x{0}; x < width; x++) {
+            row_sum += luma[y * width + x];
+            sums[(y + 1) * stride + x + 1] = sums[y * stride + x + 1] + row_sum;
+        }
+    }
+    const double global_mean{static_cast<double>(sums.back()) /
+                             static_cast<double>(luma.size())};
+
+    thresholded_image out;
+    out.cells.resize(luma.size());
+    out.margins.resize(luma.size());
+    for (std::size_t y{0}; y < height; y++) {
+        const std::size_t top{y > reach ? y - reach : 0};
+        const std::size_t bottom{std::min(height, y + reach + 1)};
+        for (std::size_t x{0}; x < width; x++) {
+            const std::size_t left{x > reach ? x - reach : 0};
+            const std::size_t right{std::min(width, x + reach + 1)};
+            const std::int64_t window{
+                sums[bottom * stride + right] - sums[top * stride + right] -
+                sums[bottom * stride + left] + sums[top * stride + left]};
+            const double local_mean{
+                static_cast<double>(window) /
+                static_cast<double>((right - left) * (bottom - top))};
+            const double threshold{(local_mean + global_mean) / 2.0 - offset};
+            const std::size_t i{y * width + x};
+            out.cells[i] =
+                luma[i] < threshold ? board_cell::filled : board_cell::clear;
+            out.margins[i] = std::abs(luma[i] - threshold);
+        }
+    }
+    return out;
+}
+
+generated_puzzle generate_puzzle(const loaded_image& source,
+                                 const generator_options& options)
+{
+    const auto [width, height]{options.size};
+    if (width <= 0 || height <= 0 || options.photo_height <= 0) {
+        throw std::invalid_argument{"Puzzle and photo sizes must be positive"};
+    }
+    // Hints are bytes, so a longer line could overflow them.
+    if (width > max_puzzle_side || height > max_puzzle_side) {
+        throw std::invalid_argument{
+            fmt::format("Puzzles can be at most {0}x{0}", max_puzzle_side)};
+    }
+    const auto cropped{crop_to_aspect(source, width, height)};
+
+    generated_puzzle out;
+    // Photos are drawn two pixels to a character, one above the other, so
+    // their heights must be even.
+    const int photo_height{(options.photo_height + 1) / 2 * 2};
+    const int photo_width{
+        std::max(1, (photo_height * width + height / 2) / height)};
+    out.photo = resize_image(cropped, gsl::narrow<unsigned int>(photo_width),
+                             gsl::narrow<unsigned int>(photo_height));
+    out.small_photo =
+        resize_image(cropped, gsl::narrow<unsigned int>(width * 2),
+                     gsl::narrow<unsigned int>(height * 2));
+
+    const auto cells{resize_image(cropped, gsl::narrow<unsigned int>(width),
+                                  gsl::narrow<unsigned int>(height))};
+    auto [solution, margins]{adaptive_threshold(
+        cells,
+        options.threshold_radius > 0 ? options.threshold_radius
+                                     : std::max(1, width / 4),
+        options.threshold_offset)};
+
+    solver_options solver;
+    solver.threads = 1;  // Batches run a puzzle per thread instead
+    std::vector<std::uint8_t> locked(solution.size());
+    for (;;) {
+        const auto result{solve_nonogram(
+            options.size, calculate_row_hints(solution, width),
+            calculate_col_hints(solution, width), solver)};
+        if (result.status != solve_status::multiple) {
+            out.unique = result.status == solve_status::unique;
+            break;
+        }
+        if (out.repairs >= options.max_repairs) {
+            break;
+        }
+        const auto& first{result.solutions[0]};
+        const auto& second{result.solutions[1]};
+        std::optional<std::size_t> flip;
+        for (std::size_t i{0}; i < solution.size(); i++) {
+            if (first[i] != second[i] && locked[i] == 0 &&
+                (!flip || margins[i] < margins[*flip])) {
+                flip = i;
+            }
+        }
+        if (!flip) {
+            break;
+        }
+        solution[*flip] = solution[*flip] == board_cell::filled
+                              ? board_cell::clear
+                              : board_cell::filled;
+        locked[*flip] = 1;
+        out.repairs++;
+    }
+
+    out.nonogram = image_from_solution(solution, options.size);
+    out.solution = std::move(solution);
+    return out;
+}
+
+std::vector<generation_report> generate_puzzle_files(
+    const std::filesystem::path& output_dir,
+    const std::vector<std::filesystem::path>& photos,
+    const generator_options& options,
+    unsigned int threads)
+{
+    std::filesystem::create_directories(output_dir);
+    std::vector<generation_report> out(photos.size());
+    task_pool pool{threads};
+    for (std::size_t i{0}; i < photos.size(); i++) {
+        pool.submit([&, i] {
+            auto& report{out[i]};
+            report.name = photos[i].stem().string();
+            try {
+                const auto puzzle{
+                    generate_puzzle(load_image(photos[i]), options)};
+                const auto path{[&](std::string_view suffix) {
+                    return output_dir /
+                           fmt::format("{}_{}", report.name, suffix);
+                }};
+                save_image(path("nonogram.png"), puzzle.nonogram);
+                save_image(path("photo.png"), puzzle.photo);
+                save_image(path("small.png"), puzzle.small_photo);
+
+                const auto json_path{path("data.json")};
+                if (!std::filesystem::exists(json_path)) {
+                    puzzle_data data;
+                    data.title = report.name;
+                    save_puzzle_data(json_path, data);
+                }
+                const auto width{options.size.x};
+                report.difficulty =
+                    rate_puzzle(options.size,
+                                calculate_row_hints(puzzle.solution, width),
+                                calculate_col_hints(puzzle.solution, width))
+                        .score;
+                save_puzzle_difficulty(json_path, report.difficulty);
+                report.unique = puzzle.unique;
+                report.repairs = puzzle.repairs;
+            }
+            catch (const std::exception& e) {
+                report.error = e.what();
+            }
+        });
+    }
+    pool.wait();
+    return out;
+}
+
+void generate_puzzles(const std::filesystem::path& output_dir,
+                      const std::vector<std::filesystem::path>& photos,
+                      const generator_options& options)
+{
+    const auto reports{generate_puzzle_files(output_dir, photos, options)};
+    fmt::print("{:<24} {:>6} {:>7} {:>5}\n", "puzzle", "unique", "repairs",
+               "score");
+    for (const auto& report : reports) {
+        if (!report.error.empty()) {
+            fmt::print("{:<24} error: {}\n", report.name, report.error);
+            continue;
+        }
+        fmt::print("{:<24} {:>6} {:>7} {:>5}\n", report.name,
+                   report.unique ? "yes" : "no", report.repairs,
+                   report.difficulty);
+    }
+}
+
+}  // namespace grandrounds
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include "file.hpp"
+#include "nonogram.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace grandrounds {
+
+// Resample an RGBA image to a new size.  Large reductions are first box
+// filtered by a whole factor, which is cheap and loses nothing a Lanczos
+// filter would keep, and then a separable Lanczos-3 filter does the rest.
+loaded_image resize_image(const loaded_image& image,
+                          unsigned int width,
+                          unsigned int height);
+
+// The largest centred region of an image with the given aspect ratio.
+loaded_image crop_to_aspect(const loaded_image& image, int width, int height);
+
+struct thresholded_image {
+    std::vector<board_cell> cells;
+    // How far each pixel's luma is from its threshold.  Pixels close to their
+    // threshold are the cheapest to change.
+    std::vector<double> margins;
+};
+
+// Fill pixels that are darker than the average of their neighbourhood and the
+// whole image, less `offset`.  The local average follows shading across a
+// photo; the global one keeps large dark or light areas solid.
+thresholded_image adaptive_threshold(const loaded_image& image,
+                                     int radius,
+                                     int offset);
+
+struct generator_options {
+    board_coords size{25, 20};  // Of the puzzle, in cells
+    int photo_height{40};       // Of the info screen photo, in pixels
+    int threshold_radius{0};    // In cells; zero means a quarter of the width
+    int threshold_offset{8};    // Luma units, out of 255
+    int max_repairs{64};        // Cells flipped to make the solution unique
+};
+
+struct generated_puzzle {
+    loaded_image nonogram;
+    loaded_image photo;
+    loaded_image small_photo;  // Two pixels per cell each way
+    std::vector<board_cell> solution;
+    bool unique{false};
+    int repairs{0};
+};
+
+// Make a puzzle from a photo.  While the solver finds a second solution, the
+// cell where the two differ that was closest to its threshold is flipped and
+// locked, up to options.max_repairs times.  Throws std::invalid_argument if
+// a side isn't positive or exceeds max_puzzle_side.
+generated_puzzle generate_puzzle(const loaded_image& source,
+                                 const generator_options& options = {});
+
+struct generation_report {
+    std::string name;
+    bool unique{false};
+    int repairs{0};
+    int difficulty{0};
+    std::string error;  // Empty if the puzzle was written
+};
+
+// Generate a puzzle from each PNG photo, one per thread, and write its three
+// images to `output_dir` with the photo's name.  A data file is written too
+// unless one already exists, and its difficulty is updated either way.
+std::vector<generation_report> generate_puzzle_files(
+    const std::filesystem::path& output_dir,
+    const std::vector<std::filesystem::path>& photos,
+    const generator_options& options = {},
+    unsigned int threads = 0);
+
+// As generate_puzzle_files(), printing a line per puzzle.
+void generate_puzzles(const std::filesystem::path& output_dir,
+                      const std::vector<std::filesystem::path>& photos,
+                      const generator_options& options = {});
+
+}  // namespace grandrounds
+
+#endif  // GENERATOR_HPP
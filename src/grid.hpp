@@ -8,34 +8,148 @@
 #ifndef GRID_HPP
 #define GRID_HPP
 
-#include "range.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace grandrounds {
 
-template <typename Range>
-auto grid_rows(Range& r, int width) noexcept
-{
-    return r | rv::chunk(width);
-}
-
-template <typename Range>
-auto grid_row(Range& r, int width, int row) noexcept
-{
-    return grid_rows(r, width)[row];
-}
-
-template <typename Range>
-auto grid_col(Range& r, int width, int col) noexcept
-{
-    return r | rv::drop(col) | rv::stride(width);
-}
-
-template <typename Range>
-auto grid_cols(Range& r, int width) noexcept
-{
-    return rv::ints(0, width) |
-           rv::transform([&r, width](int i) { return grid_col(r, width, i); });
-}
+// A width x height array of cells stored contiguously in row-major order.
+// Rows are spans into that storage.  Columns are spans into a transposed copy
+// that is rebuilt, a tile at a time, the first time a column is read after
+// the grid has been modified, so sweeping every column costs one transpose
+// and then reads contiguous memory like the rows do.
+//
+// Any non-const access counts as a modification.  Reading a column from a
+// const grid can rebuild the copy, so a grid shared between threads must not
+// have its columns read concurrently unless transpose() was called first.
+template <typename T>
+class grid {
+   public:
+    // Cells are copied into the mirror in square tiles of this size, which
+    // keeps both the rows being read and the columns being written in cache.
+    static constexpr std::size_t tile_size{32};
+
+    grid() = default;
+
+    grid(std::size_t width, std::size_t height, const T& value = {})
+        : width_{width}, height_{height}, cells_(width * height, value)
+    {
+    }
+
+    // Takes cells in row-major order; their number must be a multiple of
+    // the width.
+    grid(std::size_t width, std::vector<T> cells)
+        : width_{width},
+          height_{width == 0 ? 0 : cells.size() / width},
+          cells_{std::move(cells)}
+    {
+        if (width_ * height_ != cells_.size()) {
+            throw std::invalid_argument{"Grid cells do not fill whole rows"};
+        }
+    }
+
+    [[nodiscard]] std::size_t width() const noexcept { return width_; }
+    [[nodiscard]] std::size_t height() const noexcept { return height_; }
+
+    [[nodiscard]] T& operator()(std::size_t x, std::size_t y) noexcept
+    {
+        mirror_stale_ = true;
+        return cells_[y * width_ + x];
+    }
+
+    [[nodiscard]] const T& operator()(std::size_t x,
+                                      std::size_t y) const noexcept
+    {
+        return cells_[y * width_ + x];
+    }
+
+    [[nodiscard]] std::span<T> cells() noexcept
+    {
+        mirror_stale_ = true;
+        return cells_;
+    }
+
+    [[nodiscard]] std::span<const T> cells() const noexcept { return cells_; }
+
+    [[nodiscard]] std::span<T> row(std::size_t y) noexcept
+    {
+        mirror_stale_ = true;
+        return {cells_.data() + y * width_, width_};
+    }
+
+    [[nodiscard]] std::span<const T> row(std::size_t y) const noexcept
+    {
+        return {cells_.data() + y * width_, width_};
+    }
+
+    // Column x, top to bottom.  The span is invalidated by the next
+    // modification.
+    [[nodiscard]] std::span<const T> col(std::size_t x) const
+    {
+        transpose();
+        return {mirror_.data() + x * height_, height_};
+    }
+
+    // Bring the column copy up to date now rather than on the next col().
+    void transpose() const
+    {
+        if (!mirror_stale_) {
+            return;
+        }
+        mirror_.resize(cells_.size());
+        for_each_tile(width_, height_,
+                      [this](std::size_t x0, std::size_t y0, std::size_t x1,
+                             std::size_t y1) {
+                          for (std::size_t y{y0}; y < y1; y++) {
+                              for (std::size_t x{x0}; x < x1; x++) {
+                                  mirror_[x * height_ + y] =
+                                      cells_[y * width_ + x];
+                              }
+                          }
+                      });
+        mirror_stale_ = false;
+    }
+
+    // Call f(x0, y0, x1, y1) for each tile_size square covering a width x
+    // height area, in row-major order of tiles; the last tiles in each
+    // direction may be smaller.
+    template <typename F>
+    static void for_each_tile(std::size_t width, std::size_t height, F&& f)
+    {
+        for (std::size_t y0{0}; y0 < height; y0 += tile_size) {
+            const std::size_t y1{std::min(y0 + tile_size, height)};
+            for (std::size_t x0{0}; x0 < width; x0 += tile_size) {
+                f(x0, y0, std::min(x0 + tile_size, width), y1);
+            }
+        }
+    }
+
+    // Call f(x, y, cell) for every cell, a tile at a time.
+    template <typename F>
+    void for_each_tiled(F&& f) const
+    {
+        for_each_tile(width_, height_,
+                      [&](std::size_t x0, std::size_t y0, std::size_t x1,
+                          std::size_t y1) {
+                          for (std::size_t y{y0}; y < y1; y++) {
+                              for (std::size_t x{x0}; x < x1; x++) {
+                                  f(x, y, cells_[y * width_ + x]);
+                              }
+                          }
+                      });
+    }
+
+   private:
+    std::size_t width_{0};
+    std::size_t height_{0};
+    std::vector<T> cells_;
+    mutable std::vector<T> mirror_;  // Column-major copy of cells_
+    mutable bool mirror_stale_{true};
+};
 
 }  // namespace grandrounds
 
@@ -6,40 +6,170 @@
 //
 
 #include "game.hpp"
+#include "generator.hpp"
+#include "rating.hpp"
+#include "recording.hpp"
+#include "server.hpp"
+#include "terminal_output.hpp"
 
 #include <fmt/format.h>
 #include <gsl/narrow>
 
+#include <charconv>
+#include <filesystem>
 #include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 // This file will be generated automatically when you run the CMake
 // configuration step. It creates a namespace called `grandrounds`. You can
 // modify the source template at `configured_files/config.hpp.in`.
 #include <internal_use_only/config.hpp>
 
+namespace {
+
+// Parse "--size=<W>x<H>".  Returns false if `arg` isn't a size option.
+bool parse_size_option(std::string_view arg, grandrounds::board_coords& size)
+{
+    static constexpr std::string_view prefix{"--size="};
+    if (!arg.starts_with(prefix)) {
+        return false;
+    }
+    arg.remove_prefix(prefix.size());
+    const auto* const end{arg.data() + arg.size()};
+    const auto [x_end, x_error]{std::from_chars(arg.data(), end, size.x)};
+    if (x_error != std::errc{} || x_end == end || *x_end != 'x' ||
+        std::from_chars(x_end + 1, end, size.y).ec != std::errc{}) {
+        throw std::invalid_argument{"Size must be given as <W>x<H>"};
+    }
+    return true;
+}
+
+// Parse "--threads=<N>".  Returns false if `arg` isn't a threads option.
+bool parse_threads_option(std::string_view arg, unsigned int& threads)
+{
+    static constexpr std::string_view prefix{"--threads="};
+    if (!arg.starts_with(prefix)) {
+        return false;
+    }
+    arg.remove_prefix(prefix.size());
+    const auto* const end{arg.data() + arg.size()};
+    const auto [ptr, error]{std::from_chars(arg.data(), end, threads)};
+    if (error != std::errc{} || ptr != end) {
+        throw std::invalid_argument{"Threads must be given as a number"};
+    }
+    return true;
+}
+
+// Parse the global options "--low-bandwidth" and "--colors=<C>".  Returns
+// false if `arg` is neither.
+bool parse_render_option(std::string_view arg,
+                         grandrounds::render_options& options)
+{
+    static constexpr std::string_view colors_prefix{"--colors="};
+    if (arg == "--low-bandwidth") {
+        options = grandrounds::low_bandwidth;
+        return true;
+    }
+    if (arg.starts_with(colors_prefix)) {
+        arg.remove_prefix(colors_prefix.size());
+        options.colors = grandrounds::parse_palette(arg);
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
 int main(int argc, const char** argv)
 {
     try {
-        const std::span args{argv, gsl::narrow<std::size_t>(argc)};
+        const std::span all_args{argv, gsl::narrow<std::size_t>(argc)};
         static constexpr auto USAGE =
             R"(grandrounds
 
     Usage:
-          grandrounds
-          grandrounds puzzle <NAME>
+          grandrounds [<RENDER>...]
+          grandrounds [<RENDER>...] puzzle [--record=<FILE>] <NAME>
+          grandrounds rate [<NAME>...]
+          grandrounds generate [--size=<W>x<H>] <OUTPUT_DIR> <PHOTO>...
+          grandrounds serve [--threads=<N>] <SOCKET>
+          grandrounds [<RENDER>...] replay [--real-time] <FILE>
  Options:
-          -h --help     Show this screen.
-          --version     Show version.
+          -h --help          Show this screen.
+          --version          Show version.
+ Render options:
+          --low-bandwidth    Draw for a slow link: 256 colours, cells as
+                             characters, unchanged frames not sent.
+          --colors=<C>       Colours to draw with: true, 256 or 16.
 )";
+        // Render options come before any command, and are dropped from the
+        // arguments so that the commands see the same positions either way.
+        grandrounds::render_options render{};
+        std::vector<const char*> args{all_args.front()};
+        std::size_t next{1};
+        while (next < all_args.size() &&
+               parse_render_option(all_args[next], render)) {
+            next++;
+        }
+        args.insert(args.end(), all_args.begin() + gsl::narrow<long>(next),
+                    all_args.end());
+        grandrounds::set_render_options(render);
+
         // XXX I removed docopt because the the current Conan+CMake build
         // intermittently fails to find it.  This is a workaround.
-        if (argc == 1) {
+        if (args.size() == 1) {
             grandrounds::play_game();
         }
-        else if (argc == 3 && args[1] == std::string_view{"puzzle"}) {
+        else if (args.size() == 3 && args[1] == std::string_view{"puzzle"}) {
             grandrounds::play_puzzle(args[2]);
         }
+        else if (args.size() == 4 && args[1] == std::string_view{"puzzle"} &&
+                 std::string_view{args[2]}.starts_with("--record=")) {
+            grandrounds::play_puzzle(
+                args[3], std::string_view{args[2]}.substr(
+                             std::string_view{"--record="}.size()));
+        }
+        else if (args[1] == std::string_view{"rate"}) {
+            const std::vector<std::string> names(args.begin() + 2, args.end());
+            grandrounds::rate_puzzles(names);
+        }
+        else if (args[1] == std::string_view{"generate"}) {
+            grandrounds::generator_options options;
+            const std::size_t first{
+                args.size() > 2 && parse_size_option(args[2], options.size)
+                    ? 3U
+                    : 2U};
+            if (args.size() < first + 2) {
+                throw std::invalid_argument{
+                    "generate needs an output directory and a photo"};
+            }
+            const std::vector<std::filesystem::path> photos(
+                args.begin() + gsl::narrow<long>(first) + 1, args.end());
+            grandrounds::generate_puzzles(args[first], photos, options);
+        }
+        else if (args[1] == std::string_view{"serve"}) {
+            grandrounds::server_options options;
+            const std::size_t first{
+                args.size() > 2 &&
+                        parse_threads_option(args[2], options.threads)
+                    ? 3U
+                    : 2U};
+            if (args.size() != first + 1) {
+                throw std::invalid_argument{"serve needs a socket path"};
+            }
+            options.socket_path = args[first];
+            grandrounds::serve_puzzles(options);
+        }
+        else if (args[1] == std::string_view{"replay"} && args.size() > 2) {
+            const bool real_time{args[2] == std::string_view{"--real-time"}};
+            if (args.size() != (real_time ? 4U : 3U)) {
+                throw std::invalid_argument{"replay needs a recording"};
+            }
+            grandrounds::report_replay(args.back(), real_time);
+        }
         else if (args[1] == std::string_view{"--version"}) {
             fmt::print("{} {}", grandrounds::cmake::project_name,
                        grandrounds::cmake::project_version);
@@ -6,6 +6,8 @@
 //
 
 #include "nonogram.hpp"
+#include "alloc_tracker.hpp"
+#include "embedded_assets.hpp"
 #include "file.hpp"
 #include "grid.hpp"
 #include "range.hpp"
@@ -15,115 +17,471 @@
 #include <gsl/narrow>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <system_error>
+#include <utility>
 
 namespace grandrounds {
 
 namespace {
 
-std::vector<std::uint8_t> calculate_hints(const auto& row_or_column)
+// Hints for every row, or with `by_column` every column, and their colours
+// unless `colors` is null.
+std::vector<std::vector<std::uint8_t>> calculate_line_hints(
+    const std::vector<board_cell>& cells,
+    int width,
+    bool by_column,
+    std::vector<std::vector<std::uint8_t>>* colors)
 {
-    auto iter{row_or_column.begin()};
-    const auto end{row_or_column.end()};
-    std::vector<std::uint8_t> out;
-    while (iter != end) {
-        while (iter != end && *iter == board_cell::clear) {
-            ++iter;
-        }
-        std::uint8_t count{0};
-        while (iter != end && *iter == board_cell::filled) {
-            ++count;
-            ++iter;
+    const allocation_scope scope{allocation_tag::hints};
+    const grid board{gsl::narrow<std::size_t>(width), cells};
+    const auto lines{by_column ? board.width() : board.height()};
+    std::vector<std::vector<std::uint8_t>> out(lines);
+    if (colors != nullptr) {
+        colors->assign(lines, {});
+    }
+    for (std::size_t i{0}; i < lines; i++) {
+        auto* const line_colors{colors != nullptr ? &(*colors)[i] : nullptr};
+        if (by_column) {
+            calculate_hints(board.col(i), out[i], line_colors);
         }
-        if (count > 0) {
-            out.push_back(count);
+        else {
+            calculate_hints(board.row(i), out[i], line_colors);
         }
     }
-    // TODO there may be some marvelous way to replace all this with ranges,
-    // using group_by or something
     return out;
 }
 
-}  // namespace
+// Whether the runs of filled cells in a line are exactly its hints, in
+// colour too if `colors` isn't empty.  Marked cells count as clear.  Walks
+// the line once without building its runs, so it doesn't allocate.
+bool line_satisfied(const auto& line,
+                    const std::vector<std::uint8_t>& hints,
+                    std::span<const std::uint8_t> colors) noexcept
+{
+    auto hint{hints.begin()};
+    int run{0};
+    board_cell current{board_cell::clear};
+    const auto end_run{[&] {
+        if (run == 0) {
+            return true;
+        }
+        if (hint == hints.end() || *hint != run ||
+            (!colors.empty() &&
+             colors[static_cast<std::size_t>(hint - hints.begin())] !=
+                 cell_color(current))) {
+            return false;
+        }
+        ++hint;
+        run = 0;
+        return true;
+    }};
+    for (const auto cell : line) {
+        const auto this_cell{run_cell(cell)};
+        if (this_cell != current) {
+            if (!end_run()) {
+                return false;
+            }
+            current = this_cell;
+        }
+        if (this_cell != board_cell::clear) {
+            run++;
+        }
+    }
+    return end_run() && hint == hints.end();
+}
 
-nonogram_puzzle::nonogram_puzzle(std::string_view name)
+// A line's hint colours, or none for a black-and-white puzzle.
+std::span<const std::uint8_t> line_colors(
+    const std::vector<std::vector<std::uint8_t>>& colors,
+    std::size_t line) noexcept
+{
+    return colors.empty() ? std::span<const std::uint8_t>{} : colors[line];
+}
+
+void update_row(nonogram_game& game, std::size_t y)
+{
+    const auto width{gsl::narrow<std::size_t>(game.puzzle->dimensions.x)};
+    game.row_satisfied[y] = line_satisfied(
+        std::span{game.board}.subspan(y * width, width),
+        game.puzzle->row_hints[y],
+        line_colors(game.puzzle->row_hint_colors, y));
+}
+
+void update_col(nonogram_game& game, std::size_t x)
+{
+    const auto width{game.puzzle->dimensions.x};
+    game.col_satisfied[x] = line_satisfied(
+        game.board | rv::drop(gsl::narrow<std::ptrdiff_t>(x)) |
+            rv::stride(width),
+        game.puzzle->col_hints[x],
+        line_colors(game.puzzle->col_hint_colors, x));
+}
+
+// Decoded without alpha, and checked for size before decoding, so that a
+// corrupt or hostile header can't ask for gigabytes.
+std::vector<std::uint8_t> decode_solution_png(std::span<const std::uint8_t> png,
+                                              board_coords& dimensions)
+{
+    unsigned int width{0};
+    unsigned int height{0};
+    lodepng::State state;
+    auto error{
+        lodepng_inspect(&width, &height, &state, png.data(), png.size())};
+    if (error == 0 && (width > max_puzzle_side || height > max_puzzle_side)) {
+        throw file_error{fmt::format(
+            "A {}x{} puzzle is larger than the {}x{} that hints can describe",
+            width, height, max_puzzle_side, max_puzzle_side)};
+    }
+    std::vector<std::uint8_t> rgb;
+    if (error == 0) {
+        error = lodepng::decode(rgb, width, height, png.data(), png.size(),
+                                LCT_RGB, 8);
+    }
+    if (error != 0) {
+        throw file_error{fmt::format("Could not decode PNG: {} {}", error,
+                                     lodepng_error_text(error))};
+    }
+    dimensions.x = gsl::narrow<int>(width);
+    dimensions.y = gsl::narrow<int>(height);
+    return rgb;
+}
+
+void set_hints(nonogram_puzzle& puzzle)
+{
+    if (puzzle.is_colored()) {
+        puzzle.row_hints = calculate_row_hints(
+            puzzle.solution, puzzle.dimensions.x, puzzle.row_hint_colors);
+        puzzle.col_hints = calculate_col_hints(
+            puzzle.solution, puzzle.dimensions.x, puzzle.col_hint_colors);
+    }
+    else {
+        puzzle.row_hints =
+            calculate_row_hints(puzzle.solution, puzzle.dimensions.x);
+        puzzle.col_hints =
+            calculate_col_hints(puzzle.solution, puzzle.dimensions.x);
+    }
+}
+
+void set_hint_widths(nonogram_puzzle& puzzle)
+{
+    const auto vec_size{[](const std::vector<std::uint8_t>& vec) {
+        return static_cast<int>(vec.size());
+    }};
+    puzzle.row_hints_max = r::max(puzzle.row_hints | rv::transform(vec_size));
+    puzzle.col_hints_max = r::max(puzzle.col_hints | rv::transform(vec_size));
+}
+
+void load_puzzle_files(nonogram_puzzle& out,
+                       const std::filesystem::path& puzzle_dir,
+                       std::string_view name)
 {
-    const auto puzzle_dir{find_puzzles_dir()};
     const auto json_path{puzzle_dir / fmt::format("{}_data.json", name)};
     const auto nonogram_path{puzzle_dir / fmt::format("{}_nonogram.png", name)};
     const auto photo_path{puzzle_dir / fmt::format("{}_photo.png", name)};
     const auto small_path{puzzle_dir / fmt::format("{}_small.png", name)};
-    auto solution_image{load_image(nonogram_path)};
-    auto photo_image{load_image(photo_path)};
-    auto small_image{load_image(small_path)};
-
-    dimensions.x = gsl::narrow<int>(solution_image.width);
-    dimensions.y = gsl::narrow<int>(solution_image.height);
-    photo_dimensions.x = gsl::narrow<int>(photo_image.width);
-    photo_dimensions.y = gsl::narrow<int>(photo_image.height);
+
+    // The data says whether the solution is in colour.
+    out.data = load_puzzle_data(json_path);
+    out.solution = load_solution(nonogram_path, out.data.colors,
+                                 out.dimensions, out.palette);
+    out.photo = load_compact_image(photo_path, photo_format());
+    out.small_photo = load_compact_image(small_path, photo_format());
+    set_hints(out);
+}
+
+compact_image copy_image(const embedded::image& image)
+{
+    return compact_image::from_rgba(image.rgba_pixel_data, image.width,
+                                    image.height, photo_format());
+}
+
+// The table's hints, or with `colors` their colours, which are laid out the
+// same way.
+std::vector<std::vector<std::uint8_t>> copy_hints(
+    const embedded::hint_table& table,
+    bool colors = false)
+{
+    const auto data{colors ? table.colors : table.data};
+    std::vector<std::vector<std::uint8_t>> out;
+    for (std::size_t i{0}; i + 1 < table.offsets.size(); i++) {
+        out.emplace_back(data.begin() + table.offsets[i],
+                         data.begin() + table.offsets[i + 1]);
+    }
+    return out;
+}
+
+void load_embedded_puzzle(nonogram_puzzle& out, const embedded::puzzle& in)
+{
+    out.dimensions = in.dimensions;
+    const auto cell_count{gsl::narrow<std::size_t>(in.dimensions.x) *
+                          gsl::narrow<std::size_t>(in.dimensions.y)};
+    out.solution.reserve(cell_count);
+    if (in.solution_colors.empty()) {
+        for (std::size_t i{0}; i < cell_count; i++) {
+            const bool filled{((in.solution_bits[i / 8] >> (i % 8)) & 1U) !=
+                              0};
+            out.solution.push_back(filled ? board_cell::filled
+                                          : board_cell::clear);
+        }
+    }
+    else {
+        for (const auto c : in.solution_colors) {
+            out.solution.push_back(
+                c == 0 ? board_cell::clear
+                       : filled_cell(static_cast<std::uint8_t>(c - 1)));
+        }
+        for (std::size_t i{0}; i + 2 < in.palette_rgb.size(); i += 3) {
+            out.palette.push_back({in.palette_rgb[i], in.palette_rgb[i + 1],
+                                   in.palette_rgb[i + 2]});
+        }
+        out.row_hint_colors = copy_hints(in.row_hints, true);
+        out.col_hint_colors = copy_hints(in.col_hints, true);
+    }
+    out.photo = copy_image(in.photo);
+    out.small_photo = copy_image(in.small_photo);
+    out.data.title = in.title;
+    out.data.description = in.description;
+    out.data.author = in.author;
+    out.data.date = in.date;
+    out.data.license = in.license;
+    out.data.wikipedia = in.wikipedia;
+    out.data.difficulty = in.difficulty;
+    out.data.colors = in.colors;
+    out.row_hints = copy_hints(in.row_hints);
+    out.col_hints = copy_hints(in.col_hints);
+}
+
+const embedded::puzzle* find_embedded_puzzle(std::string_view name) noexcept
+{
+    const auto puzzles{embedded::puzzles()};
+    const auto found{
+        std::find_if(puzzles.begin(), puzzles.end(),
+                     [&](const auto& p) { return p.name == name; })};
+    return found == puzzles.end() ? nullptr : &*found;
+}
+
+// The directory to load a puzzle's files from, or nullopt to use the built-in
+// copy.  The override directory comes first, then the built-in copies, and
+// last the installed puzzles directory, which has any puzzles made since the
+// game was built.
+std::optional<std::filesystem::path> puzzle_files_dir(std::string_view name)
+{
+    auto override_dir{puzzle_override_dir()};
+    if (override_dir &&
+        std::filesystem::exists(*override_dir /
+                                fmt::format("{}_data.json", name))) {
+        return override_dir;
+    }
+    if (find_embedded_puzzle(name) != nullptr) {
+        return std::nullopt;
+    }
+    return find_puzzles_dir();
+}
+
+}  // namespace
+
+nonogram_puzzle::nonogram_puzzle(std::string_view name)
+{
+    const allocation_scope scope{allocation_tag::load};
+    if (const auto puzzle_dir{puzzle_files_dir(name)}) {
+        load_puzzle_files(*this, *puzzle_dir, name);
+    }
+    else {
+        load_embedded_puzzle(*this, *find_embedded_puzzle(name));
+    }
+
+    photo_dimensions.x = gsl::narrow<int>(photo.width());
+    photo_dimensions.y = gsl::narrow<int>(photo.height());
+    set_hint_widths(*this);
+}
+
+nonogram_puzzle::nonogram_puzzle(board_coords size,
+                                 std::vector<board_cell> cells,
+                                 std::vector<color> colors)
+    : dimensions{size}, solution{std::move(cells)}, palette{std::move(colors)}
+{
+    if (dimensions.x <= 0 || dimensions.y <= 0 ||
+        dimensions.x > max_puzzle_side || dimensions.y > max_puzzle_side ||
+        solution.size() != gsl::narrow<std::size_t>(dimensions.x) *
+                               gsl::narrow<std::size_t>(dimensions.y)) {
+        throw std::invalid_argument{
+            "Puzzle dimensions don't fit its solution or the hints"};
+    }
+    const auto color_count{std::max<std::size_t>(palette.size(), 1)};
+    if (palette.size() > max_puzzle_colors ||
+        r::any_of(solution, [&](board_cell cell) {
+            return cell == board_cell::marked ||
+                   (is_filled(cell) && cell_color(cell) >= color_count);
+        })) {
+        throw std::invalid_argument{
+            "Puzzle solution has cells that aren't clear or its colours"};
+    }
+    set_hints(*this);
+    set_hint_widths(*this);
+}
+
+std::optional<std::filesystem::file_time_type> puzzle_modified_time(
+    std::string_view name)
+{
+    const auto puzzle_dir{puzzle_files_dir(name)};
+    if (!puzzle_dir) {
+        return std::nullopt;
+    }
+    std::optional<std::filesystem::file_time_type> out;
+    for (const auto* suffix : {"data.json", "nonogram.png", "photo.png",
+                               "small.png"}) {
+        std::error_code error;
+        const auto time{std::filesystem::last_write_time(
+            *puzzle_dir / fmt::format("{}_{}", name, suffix), error)};
+        if (!error && (!out || time > *out)) {
+            out = time;
+        }
+    }
+    return out;
+}
+
+std::vector<board_cell> solution_from_png(std::span<const std::uint8_t> png,
+                                          board_coords& dimensions)
+{
+    // Held in a local: range-v3 won't chunk a temporary container.
+    const auto rgb{decode_solution_png(png, dimensions)};
+    return rgb | rv::chunk(3) |
+           rv::transform([](auto&& pixel) {
+               const bool filled{(pixel[0] == 0) && (pixel[1] == 0) &&
+                                 (pixel[2] == 0)};
+               return filled ? board_cell::filled : board_cell::clear;
+           }) |
+           r::to<std::vector>;
+}
+
+std::vector<board_cell> load_solution(const std::filesystem::path& png_path,
+                                      std::optional<int> colors,
+                                      board_coords& dimensions,
+                                      std::vector<color>& palette)
+{
+    // Converted to cells straight away, so the pixels are never held for
+    // long.
+    std::vector<std::uint8_t> png;
+    const auto error{lodepng::load_file(png, png_path.string())};
+    if (error != 0) {
+        throw file_error{fmt::format("Could not load {}: {} {}",
+                                     png_path.string(), error,
+                                     lodepng_error_text(error))};
+    }
+    if (!colors) {
+        palette.clear();
+        return solution_from_png(png, dimensions);
+    }
+    return quantize_solution(decode_solution_png(png, dimensions), 3, *colors,
+                             palette);
+}
+
+std::vector<board_cell> solution_from_image(const loaded_image& image)
+{
     // Split image data into four-byte (RGBA) chunks and convert those to board
     // cells
-    solution = solution_image.rgba_pixel_data | rv::chunk(4) |
-               rv::transform([](auto&& pixel) {
-                   const bool filled{(pixel[0] == 0) && (pixel[1] == 0) &&
-                                     (pixel[2] == 0)};
-                   return filled ? board_cell::filled : board_cell::clear;
-               }) |
-               r::to<std::vector>;
-
-    photo = photo_image;
-    small_photo = small_image;
-
-    data = load_puzzle_data(json_path);
-
-    const auto cols{grid_cols(solution, dimensions.x)};
-    col_hints =
-        cols |
-        rv::transform([&](const auto& col) { return calculate_hints(col); }) |
-        r::to<std::vector>;
-
-    const auto rows{grid_rows(solution, dimensions.x)};
-    row_hints =
-        rows |
-        rv::transform([&](const auto& row) { return calculate_hints(row); }) |
-        r::to<std::vector>;
+    return image.rgba_pixel_data | rv::chunk(4) |
+           rv::transform([](auto&& pixel) {
+               const bool filled{(pixel[0] == 0) && (pixel[1] == 0) &&
+                                 (pixel[2] == 0)};
+               return filled ? board_cell::filled : board_cell::clear;
+           }) |
+           r::to<std::vector>;
+}
 
-    const auto vec_size{[](const std::vector<std::uint8_t>& vec) {
-        return static_cast<int>(vec.size());
-    }};
-    row_hints_max = r::max(row_hints | rv::transform(vec_size));
-    col_hints_max = r::max(col_hints | rv::transform(vec_size));
+std::vector<std::vector<std::uint8_t>> calculate_row_hints(
+    const std::vector<board_cell>& cells,
+    int width)
+{
+    return calculate_line_hints(cells, width, false, nullptr);
+}
+
+std::vector<std::vector<std::uint8_t>> calculate_col_hints(
+    const std::vector<board_cell>& cells,
+    int width)
+{
+    return calculate_line_hints(cells, width, true, nullptr);
+}
+
+std::vector<std::vector<std::uint8_t>> calculate_row_hints(
+    const std::vector<board_cell>& cells,
+    int width,
+    std::vector<std::vector<std::uint8_t>>& colors)
+{
+    return calculate_line_hints(cells, width, false, &colors);
 }
 
-class json_error : public std::runtime_error {
-   public:
-    explicit json_error(const std::string& msg) : std::runtime_error{msg} {}
-};
+std::vector<std::vector<std::uint8_t>> calculate_col_hints(
+    const std::vector<board_cell>& cells,
+    int width,
+    std::vector<std::vector<std::uint8_t>>& colors)
+{
+    return calculate_line_hints(cells, width, true, &colors);
+}
 
 // Suppress cppcheck because passing string_view by value is correct.
 // cppcheck-suppress passedByValue
 puzzle_data parse_puzzle_data(std::string_view json_text)
 {
-    const auto parsed_json = nlohmann::json::parse(json_text);
+    try {
+        const auto parsed_json = nlohmann::json::parse(json_text);
 
-    if (!parsed_json.is_object()) {
-        throw json_error{
-            fmt::format("Parsed JSON is unexpectedly a {} instead of an object",
-                        parsed_json.type_name())};
-    }
+        if (!parsed_json.is_object()) {
+            throw json_error{fmt::format(
+                "Parsed JSON is unexpectedly a {} instead of an object",
+                parsed_json.type_name())};
+        }
 
-    puzzle_data out;
-    out.title = parsed_json["title"];
-    out.description = parsed_json["description"];
-    out.author = parsed_json["author"];
-    out.date = parsed_json["date"];
-    out.license = parsed_json["license"];
-    out.wikipedia = parsed_json["wikipedia"];
+        puzzle_data out;
+        out.title = parsed_json.at("title");
+        out.description = parsed_json.at("description");
+        out.author = parsed_json.at("author");
+        out.date = parsed_json.at("date");
+        out.license = parsed_json.at("license");
+        out.wikipedia = parsed_json.at("wikipedia");
+        if (parsed_json.contains("difficulty")) {
+            // Checked here because converting an out-of-range number to int
+            // is undefined.
+            const auto& difficulty{parsed_json.at("difficulty")};
+            const bool fits{
+                difficulty.is_number_unsigned()
+                    ? difficulty.get<std::uint64_t>() <=
+                          std::uint64_t{std::numeric_limits<int>::max()}
+                    : difficulty.is_number_integer() &&
+                          difficulty.get<std::int64_t>() >=
+                              std::numeric_limits<int>::min() &&
+                          difficulty.get<std::int64_t>() <=
+                              std::numeric_limits<int>::max()};
+            if (!fits) {
+                throw json_error{"Puzzle difficulty is not an int"};
+            }
+            out.difficulty = difficulty.get<int>();
+        }
+        if (parsed_json.contains("colors")) {
+            const auto& colors{parsed_json.at("colors")};
+            if (!colors.is_number_integer() ||
+                colors.get<std::int64_t>() < 1 ||
+                colors.get<std::int64_t>() > max_puzzle_colors) {
+                throw json_error{fmt::format(
+                    "Puzzle colors must be from 1 to {}", max_puzzle_colors)};
+            }
+            out.colors = colors.get<int>();
+        }
 
-    return out;
+        return out;
+    }
+    catch (const nlohmann::json::exception& e) {
+        throw json_error{e.what()};
+    }
 }
 
 puzzle_data load_puzzle_data(const std::filesystem::path& json_path)
@@ -131,15 +489,83 @@ puzzle_data load_puzzle_data(const std::filesystem::path& json_path)
     return parse_puzzle_data(slurp(json_path));
 }
 
+namespace {
+
+void write_json(const std::filesystem::path& json_path,
+                const nlohmann::ordered_json& json)
+{
+    std::ofstream stream{json_path};
+    stream << json.dump(2) << '\n';
+    if (!stream) {
+        throw file_error{"Could not write file: " + json_path.string()};
+    }
+}
+
+}  // namespace
+
+void save_puzzle_data(const std::filesystem::path& json_path,
+                      const puzzle_data& data)
+{
+    nlohmann::ordered_json json;
+    json["title"] = data.title;
+    json["description"] = data.description;
+    json["author"] = data.author;
+    json["date"] = data.date;
+    json["license"] = data.license;
+    json["wikipedia"] = data.wikipedia;
+    if (data.difficulty) {
+        json["difficulty"] = *data.difficulty;
+    }
+    if (data.colors) {
+        json["colors"] = *data.colors;
+    }
+    write_json(json_path, json);
+}
+
+void save_puzzle_difficulty(const std::filesystem::path& json_path,
+                            int difficulty)
+{
+    // ordered_json keeps the fields in the order they were written by hand.
+    auto parsed_json = nlohmann::ordered_json::parse(slurp(json_path));
+    parsed_json["difficulty"] = difficulty;
+    write_json(json_path, parsed_json);
+}
+
+void set_cell(nonogram_game& game, board_coords square, board_cell cell)
+{
+    const auto x{gsl::narrow<std::size_t>(square.x)};
+    const auto y{gsl::narrow<std::size_t>(square.y)};
+    game.board[y * gsl::narrow<std::size_t>(game.puzzle->dimensions.x) + x] =
+        cell;
+    if (game.row_satisfied.empty()) {
+        update_satisfied_hints(game);
+        return;
+    }
+    update_row(game, y);
+    update_col(game, x);
+}
+
+void update_satisfied_hints(nonogram_game& game)
+{
+    const auto& dimensions{game.puzzle->dimensions};
+    game.row_satisfied.resize(gsl::narrow<std::size_t>(dimensions.y));
+    game.col_satisfied.resize(gsl::narrow<std::size_t>(dimensions.x));
+    for (std::size_t y{0}; y < game.row_satisfied.size(); y++) {
+        update_row(game, y);
+    }
+    for (std::size_t x{0}; x < game.col_satisfied.size(); x++) {
+        update_col(game, x);
+    }
+}
+
 bool check_solution(const nonogram_game& game) noexcept
 {
-    // Filter out "marked" cells so we can compare directly with the solution.
-    auto board_filled_cells{game.board | rv::transform([](auto&& cell) {
-                                return cell == board_cell::filled
-                                           ? board_cell::filled
-                                           : board_cell::clear;
-                            })};
-    return r::equal(board_filled_cells, game.puzzle->solution);
+    // Marked cells count as clear; filled cells compare directly with the
+    // solution, so in a colour puzzle they must be the right colour too.
+    return r::equal(game.board, game.puzzle->solution,
+                    [](board_cell cell, board_cell wanted) {
+                        return run_cell(cell) == wanted;
+                    });
 }
 
 }  // namespace grandrounds
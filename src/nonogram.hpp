@@ -8,11 +8,19 @@
 #ifndef NONOGRAM_HPP
 #define NONOGRAM_HPP
 
+#include "compact_image.hpp"
 #include "file.hpp"
+#include "puzzle_colors.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace grandrounds {
@@ -24,16 +32,13 @@ struct puzzle_data {
     std::string date;
     std::string license;
     std::string wikipedia;
+    // Cached result of rate_puzzle(), if the puzzle has been rated.
+    std::optional<int> difficulty;
+    // For a colour puzzle, the most colours its solution image is quantised
+    // to.  A black-and-white puzzle has none.
+    std::optional<int> colors;
 };
 
-struct color {
-    std::uint8_t r{0};
-    std::uint8_t g{0};
-    std::uint8_t b{0};
-};
-
-enum class board_cell : std::uint8_t { clear, filled, marked };
-
 // The terminal uses a coordinate system where the top-left character is (1,1),
 // the next character to the right is (2,1), the next character down is (1,2),
 // and so on.
@@ -61,28 +66,112 @@ struct board_coords {
     int y{0};
 };
 
+// Hints are bytes, so no row or column can be longer than this.
+inline constexpr int max_puzzle_side{255};
+
 struct nonogram_puzzle {
     explicit nonogram_puzzle(std::string_view name);
+    // A puzzle with only a solution and the hints it makes, without photos
+    // or data.  A palette makes it a colour puzzle.  Throws
+    // std::invalid_argument if the solution doesn't have the given
+    // dimensions, they exceed max_puzzle_side, or a cell's colour isn't in
+    // the palette.
+    nonogram_puzzle(board_coords size,
+                    std::vector<board_cell> cells,
+                    std::vector<color> colors = {});
+
+    [[nodiscard]] bool is_colored() const noexcept { return !palette.empty(); }
 
     board_coords dimensions;
     std::vector<board_cell> solution;
+    // The colours of a colour puzzle's filled cells, most common first.
+    // Empty for a black-and-white puzzle.
+    std::vector<color> palette;
     canvas_coords photo_dimensions;
-    loaded_image photo;
-    loaded_image small_photo;
+    compact_image photo;        // In photo_format() when loaded
+    compact_image small_photo;
     puzzle_data data;
     std::vector<std::vector<std::uint8_t>> row_hints;
     std::vector<std::vector<std::uint8_t>> col_hints;
+    // For a colour puzzle, the palette index of each hint, laid out as the
+    // hints are.  Empty for a black-and-white puzzle.
+    std::vector<std::vector<std::uint8_t>> row_hint_colors;
+    std::vector<std::vector<std::uint8_t>> col_hint_colors;
     int row_hints_max{0};
     int col_hints_max{0};
 };
 
 struct nonogram_game {
-    std::shared_ptr<nonogram_puzzle> puzzle;
+    std::shared_ptr<const nonogram_puzzle> puzzle;
     std::vector<board_cell> board;
+    // Whether the filled cells of each row (and column) match its hints.
+    // set_cell() keeps these current; anything else that changes the board
+    // must call update_satisfied_hints() afterwards.
+    std::vector<bool> row_satisfied{};
+    std::vector<bool> col_satisfied{};
+};
+
+// Change one cell, rechecking only its row and column against their hints.
+void set_cell(nonogram_game& game, board_coords square, board_cell cell);
+// Recheck every row and column, after the board was changed wholesale.
+void update_satisfied_hints(nonogram_game& game);
+
+// When the files a puzzle would be loaded from were last changed, or nullopt
+// for a built-in puzzle, which can't change while the game is running.
+std::optional<std::filesystem::file_time_type> puzzle_modified_time(
+    std::string_view name);
+
+// Any pixel that is pure black (ignoring alpha) is a filled cell.
+std::vector<board_cell> solution_from_image(const loaded_image& image);
+// Decode a solution from PNG file contents, setting `dimensions` to the
+// image's.  Throws file_error if the PNG is invalid or larger than
+// max_puzzle_side.
+std::vector<board_cell> solution_from_png(std::span<const std::uint8_t> png,
+                                          board_coords& dimensions);
+
+// Load a solution image, setting `dimensions` to its size.  With `colors` it
+// is quantised, and `palette` set, as for a colour puzzle; without, only pure
+// black pixels are filled.  Throws file_error as solution_from_png() does.
+std::vector<board_cell> load_solution(const std::filesystem::path& png_path,
+                                      std::optional<int> colors,
+                                      board_coords& dimensions,
+                                      std::vector<color>& palette);
+
+// The hints for each row (or column) of a board stored in row-major order.
+std::vector<std::vector<std::uint8_t>> calculate_row_hints(
+    const std::vector<board_cell>& cells,
+    int width);
+std::vector<std::vector<std::uint8_t>> calculate_col_hints(
+    const std::vector<board_cell>& cells,
+    int width);
+// The same, for a colour puzzle, setting `colors` to each hint's palette
+// index.  A run ends where the colour changes as well as at a clear cell, so
+// runs of different colours can touch.  Both come from the same single pass
+// over each line.
+std::vector<std::vector<std::uint8_t>> calculate_row_hints(
+    const std::vector<board_cell>& cells,
+    int width,
+    std::vector<std::vector<std::uint8_t>>& colors);
+std::vector<std::vector<std::uint8_t>> calculate_col_hints(
+    const std::vector<board_cell>& cells,
+    int width,
+    std::vector<std::vector<std::uint8_t>>& colors);
+
+class json_error : public std::runtime_error {
+   public:
+    explicit json_error(const std::string& msg) : std::runtime_error{msg} {}
 };
 
+// Throws json_error if the text isn't a puzzle data object.
 puzzle_data parse_puzzle_data(std::string_view json_text);
 puzzle_data load_puzzle_data(const std::filesystem::path& json_path);
+void save_puzzle_data(const std::filesystem::path& json_path,
+                      const puzzle_data& data);
+// Record a difficulty score in a puzzle's data file, leaving its other fields
+// as they are.
+void save_puzzle_difficulty(const std::filesystem::path& json_path,
+                            int difficulty);
+// Whether the board's filled cells, in their colours, are the solution's.
 bool check_solution(const nonogram_game& game) noexcept;
 
 }  // namespace grandrounds
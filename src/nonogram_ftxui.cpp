@@ -6,17 +6,27 @@
 //
 
 #include "nonogram_ftxui.hpp"
-#include "grid.hpp"
+#include "alloc_tracker.hpp"
+#include "range.hpp"
+#include "terminal_output.hpp"
 
 #include <fmt/format.h>
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/event.hpp>
 #include <gsl/narrow>
 
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 namespace grandrounds {
 
 void draw_photo_on_canvas(ftxui::Canvas& canvas,
-                          const loaded_image& photo,
+                          const compact_image& photo,
                           canvas_coords offset)
 {
     // Offset must be a terminal character; round down to the nearest
@@ -25,21 +35,34 @@ void draw_photo_on_canvas(ftxui::Canvas& canvas,
     offset.y /= 4;
     offset.y *= 4;
 
-    auto pixel_colors{photo.rgba_pixel_data | rv::chunk(4) |
-                      rv::transform([](auto&& pixel) {
-                          return ftxui::Color{pixel[0], pixel[1], pixel[2]};
-                      })};
-    const int width{gsl::narrow<int>(photo.width)};
-    const int height{gsl::narrow<int>(photo.height)};
-    auto color_rows{grid_rows(pixel_colors, width)};
-    for (int y{0}; y < height; y += 2) {
-        for (int x{0}; x < width; x++) {
+    // Pixels are read as they're drawn, so a frame allocates nothing for the
+    // photo.  An indexed photo's palette is converted once rather than once
+    // per pixel.
+    const auto terminal_colors{current_render_options().colors};
+    const bool indexed{photo.format() == pixel_format::indexed};
+    std::array<ftxui::Color, 256> converted{};
+    if (indexed) {
+        r::transform(photo.palette(), converted.begin(), [&](const color& c) {
+            return terminal_color(c, terminal_colors);
+        });
+    }
+    const auto indices{photo.indices()};
+    const auto color_at{[&](std::size_t x, std::size_t y) {
+        return indexed ? converted[indices[y * photo.width() + x]]
+                       : terminal_color(photo.pixel(x, y), terminal_colors);
+    }};
+
+    for (std::size_t y{0}; y + 1 < photo.height(); y += 2) {
+        for (std::size_t x{0}; x < photo.width(); x++) {
             const std::string c{"▄"};
-            const std::function stylizer{[=](ftxui::Pixel& p) {
-                p.background_color = color_rows[y][x];
-                p.foreground_color = color_rows[y + 1LL][x];
-            }};
-            canvas.DrawText(x * 2 + offset.x, y * 2 + offset.y, c, stylizer);
+            const std::function stylizer{
+                [background = color_at(x, y),
+                 foreground = color_at(x, y + 1)](ftxui::Pixel& p) {
+                    p.background_color = background;
+                    p.foreground_color = foreground;
+                }};
+            canvas.DrawText(gsl::narrow<int>(x) * 2 + offset.x,
+                            gsl::narrow<int>(y) * 2 + offset.y, c, stylizer);
         }
     }
 }
@@ -48,18 +71,66 @@ namespace {
 
 // These are functions instead of static constants because somewhat
 // surprisingly, the ftxui::Color constructor makes different colors at
-// runtime based on environment variables, and can throw exceptions.
+// runtime based on environment variables, and can throw exceptions.  They
+// also follow the palette in the current render options.
 // clang-format off
-[[nodiscard]] ftxui::Color black() { return {0, 0, 0}; } // NOLINT magic numbers - these are for all intents and purposes defining constants.
-[[nodiscard]] ftxui::Color almost_black() { return {32, 32, 32}; } // NOLINT magic numbers
-[[nodiscard]] ftxui::Color black_select() { return {32, 32, 64}; } // NOLINT magic numbers
-[[nodiscard]] ftxui::Color white() { return {255, 255, 255}; } // NOLINT magic numbers
-[[nodiscard]] ftxui::Color white_select() { return {223, 223, 255}; } // NOLINT magic numbers
-[[nodiscard]] ftxui::Color gray() { return {128, 128, 128}; } // NOLINT magic numbers
-[[nodiscard]] ftxui::Color gray_select() { return {128, 128, 160}; } // NOLINT magic numbers
-[[nodiscard]] ftxui::Color red() { return {255, 0, 0}; } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color black() { return terminal_color({0, 0, 0}); } // NOLINT magic numbers - these are for all intents and purposes defining constants.
+[[nodiscard]] ftxui::Color almost_black() { return terminal_color({32, 32, 32}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color black_select() { return terminal_color({32, 32, 64}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color white() { return terminal_color({255, 255, 255}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color white_select() { return terminal_color({223, 223, 255}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color gray() { return terminal_color({128, 128, 128}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color gray_select() { return terminal_color({128, 128, 160}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color red() { return terminal_color({255, 0, 0}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color assist_filled() { return terminal_color({160, 224, 160}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color assist_empty() { return terminal_color({176, 208, 240}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color assist_conflict() { return terminal_color({255, 160, 160}); } // NOLINT magic numbers
+[[nodiscard]] ftxui::Color assist_conflict_filled() { return terminal_color({160, 32, 32}); } // NOLINT magic numbers
 // clang-format on
 
+// Black or white, whichever reads better on `c`.
+[[nodiscard]] ftxui::Color text_color_on(color c)
+{
+    constexpr int mid_luma{128 * 1000};                  // NOLINT magic numbers
+    const int luma{c.r * 299 + c.g * 587 + c.b * 114};  // NOLINT magic numbers
+    return luma > mid_luma ? black() : white();
+}
+
+// A colour puzzle's palette in the terminal's colours, converted once a frame
+// rather than once a cell.
+[[nodiscard]] std::vector<ftxui::Color> terminal_palette(
+    const nonogram_puzzle& puzzle)
+{
+    return puzzle.palette |
+           rv::transform([](const color& c) { return terminal_color(c); }) |
+           r::to<std::vector>;
+}
+
+// The two characters a cell is drawn as when cells are glyphs rather than
+// colours.  They're ASCII, at a byte each.  Assist hints show on clear cells,
+// and conflicts on any cell.
+[[nodiscard]] std::string_view cell_glyphs(board_cell cell,
+                                           assist_hint hint) noexcept
+{
+    if (hint == assist_hint::conflict) {
+        return "!!";
+    }
+    if (is_filled(cell)) {
+        return "##";
+    }
+    if (cell == board_cell::marked) {
+        return " x";
+    }
+    switch (hint) {
+        case assist_hint::filled:
+            return " +";
+        case assist_hint::empty:
+            return " -";
+        default:
+            return " .";
+    }
+}
+
 }  // namespace
 
 nonogram_component::nonogram_component(std::shared_ptr<nonogram_game> game)
@@ -67,21 +138,34 @@ nonogram_component::nonogram_component(std::shared_ptr<nonogram_game> game)
       board_position_{game_->puzzle->row_hints_max * 3 + 1,
                       game_->puzzle->col_hints_max + 1}
 {
+    update_satisfied_hints(*game_);
 }
 
 ftxui::Element nonogram_component::Render()
 {
+    const allocation_scope scope{allocation_tag::render};
+    pull_shared_changes();
     return ftxui::canvas(solved_ ? draw_photo() : draw_board());
 }
 
 bool nonogram_component::OnEvent(ftxui::Event event)
 {
+    const allocation_scope scope{allocation_tag::event};
     const auto& puzzle{*game_->puzzle};
     const int width{puzzle.dimensions.x};
     const int height{puzzle.dimensions.y};
     if (event.is_mouse()) {
         const int mouse_x = event.mouse().x;
         const int mouse_y = event.mouse().y;
+        // The palette swatches, a row below the board, pick the colour.
+        if (puzzle.is_colored() && mouse_y - board_position_.y == height + 1 &&
+            mouse_x >= board_position_.x &&
+            event.mouse().motion == ftxui::Mouse::Pressed) {
+            const auto swatch{(mouse_x - board_position_.x) / 2};
+            if (swatch < gsl::narrow<int>(puzzle.palette.size())) {
+                color_ = gsl::narrow<std::uint8_t>(swatch);
+            }
+        }
         selected_ = {(mouse_x - board_position_.x) / 2,
                      mouse_y - board_position_.y};
         bool in_range{selected_.x >= 0 && selected_.x < width &&
@@ -91,16 +175,21 @@ bool nonogram_component::OnEvent(ftxui::Event event)
                 const auto board_idx{static_cast<std::size_t>(
                     selected_.y * width + selected_.x)};
                 if (event.mouse().button == ftxui::Mouse::Left) {
-                    game_->board[board_idx] = board_cell::filled;
+                    set_cell(*game_, selected_, filled_cell(color_));
                 }
                 else if (event.mouse().button == ftxui::Mouse::Right) {
-                    game_->board[board_idx] = board_cell::clear;
+                    set_cell(*game_, selected_, board_cell::clear);
                 }
                 else if (event.mouse().button == ftxui::Mouse::Middle) {
-                    game_->board[board_idx] = board_cell::marked;
+                    set_cell(*game_, selected_, board_cell::marked);
                 }
 
-                solved_ = check_solution(*game_);
+                if (shared_) {
+                    shared_->set(board_idx, game_->board[board_idx]);
+                    pull_shared_changes();
+                }
+                solved_ = shared_ ? shared_->solved() : check_solution(*game_);
+                board_changed();
             }
         }
         else {
@@ -114,12 +203,101 @@ bool nonogram_component::OnEvent(ftxui::Event event)
 void nonogram_component::Solve()
 {
     game_->board = game_->puzzle->solution;
+    update_satisfied_hints(*game_);
+    if (shared_) {
+        shared_->assign(game_->board);
+    }
+    board_changed();
 }
 
 void nonogram_component::Reset()
 {
     r::fill(game_->board, board_cell::clear);
+    update_satisfied_hints(*game_);
+    if (shared_) {
+        shared_->assign(game_->board);
+    }
     solved_ = false;
+    board_changed();
+}
+
+void nonogram_component::Share(std::shared_ptr<shared_board> board)
+{
+    // The viewer reports the board's cells as changes from a clear board.
+    r::fill(game_->board, board_cell::clear);
+    update_satisfied_hints(*game_);
+    viewer_.emplace(board);
+    shared_ = std::move(board);
+    pull_shared_changes();
+    solved_ = shared_->solved();
+}
+
+void nonogram_component::pull_shared_changes()
+{
+    if (!shared_) {
+        return;
+    }
+    const auto changes{viewer_->changes()};
+    if (changes.empty()) {
+        return;
+    }
+    // Rechecking a changed cell's row and column costs about as much as
+    // rechecking the whole board once there are more changes than the board
+    // is wide or high, as when another player solves or resets it.
+    const auto& dimensions{game_->puzzle->dimensions};
+    const auto width{gsl::narrow<std::size_t>(dimensions.x)};
+    if (changes.size() > gsl::narrow<std::size_t>(
+                             std::min(dimensions.x, dimensions.y))) {
+        for (const auto& change : changes) {
+            game_->board[change.index] = change.cell;
+        }
+        update_satisfied_hints(*game_);
+    }
+    else {
+        for (const auto& change : changes) {
+            set_cell(*game_,
+                     {gsl::narrow<int>(change.index % width),
+                      gsl::narrow<int>(change.index / width)},
+                     change.cell);
+        }
+    }
+    solved_ = shared_->solved();
+    board_changed();
+}
+
+void nonogram_component::EnableAssist(std::function<void()> request_redraw)
+{
+    const auto& puzzle{*game_->puzzle};
+    assistant_ = std::make_unique<hint_assistant>(
+        puzzle.dimensions, puzzle.row_hints, puzzle.col_hints,
+        std::move(request_redraw));
+    board_changed();
+}
+
+void nonogram_component::DisableAssist()
+{
+    assistant_.reset();
+}
+
+void nonogram_component::board_changed()
+{
+    if (assistant_) {
+        assistant_->analyze(game_->board);
+    }
+}
+
+std::shared_ptr<const assist_result> nonogram_component::current_assist() const
+{
+    if (!assistant_) {
+        return nullptr;
+    }
+    // Results for an earlier board would highlight the cell just clicked, so
+    // draw nothing until the worker catches up, which is well within a frame.
+    auto result{assistant_->latest()};
+    if (result && result->generation != assistant_->generation()) {
+        return nullptr;
+    }
+    return result;
 }
 
 void nonogram_component::draw_rect(ftxui::Canvas& canvas,
@@ -137,13 +315,33 @@ void nonogram_component::draw_rect(ftxui::Canvas& canvas,
 }
 
 [[nodiscard]] ftxui::Color nonogram_component::square_color(
-    board_coords square) const noexcept
+    board_coords square,
+    assist_hint hint) const noexcept
 {
     const auto& board{game_->board};
     const int width{game_->puzzle->dimensions.x};
     const auto cell{
         board[gsl::narrow<std::size_t>(square.y * width + square.x)]};
+    switch (hint) {
+        case assist_hint::filled:
+            return assist_filled();
+        case assist_hint::empty:
+            return assist_empty();
+        case assist_hint::conflict:
+            return is_filled(cell) ? assist_conflict_filled()
+                                   : assist_conflict();
+        default:
+            break;
+    }
     const bool is_selected{selected_.x == square.x || selected_.y == square.y};
+    if (is_filled(cell) && game_->puzzle->is_colored()) {
+        auto c{game_->puzzle->palette[cell_color(cell)]};
+        if (is_selected) {
+            constexpr int blue_tint{32};  // NOLINT magic numbers
+            c.b = gsl::narrow<std::uint8_t>(std::min(c.b + blue_tint, 255));
+        }
+        return terminal_color(c);
+    }
     switch (cell) {
         case board_cell::clear:
             return is_selected ? white_select() : white();
@@ -156,6 +354,67 @@ void nonogram_component::draw_rect(ftxui::Canvas& canvas,
     }
 }
 
+void nonogram_component::draw_glyph_rows(ftxui::Canvas& canvas,
+                                         const assist_result* assist) const
+{
+    const int width{game_->puzzle->dimensions.x};
+    const int height{game_->puzzle->dimensions.y};
+    const std::function stylizer{[](ftxui::Pixel& p) {
+        p.background_color = black();
+        p.foreground_color = white();
+    }};
+    std::string row;
+    for (int y{0}; y < height; y++) {
+        row.clear();
+        for (int x{0}; x < width; x++) {
+            const auto index{gsl::narrow<std::size_t>(y * width + x)};
+            row += cell_glyphs(
+                game_->board[index],
+                assist ? assist->cells[index] : assist_hint::none);
+        }
+        canvas.DrawText(2 * board_position_.x, 4 * (y + board_position_.y), row,
+                        stylizer);
+    }
+    if (!game_->puzzle->is_colored()) {
+        return;
+    }
+    // Filled cells go over the top in their own colours.
+    const auto colors{terminal_palette(*game_->puzzle)};
+    for (int y{0}; y < height; y++) {
+        for (int x{0}; x < width; x++) {
+            const auto cell{
+                game_->board[gsl::narrow<std::size_t>(y * width + x)]};
+            if (!is_filled(cell)) {
+                continue;
+            }
+            const std::function color_stylizer{
+                [foreground = colors[cell_color(cell)]](ftxui::Pixel& p) {
+                    p.background_color = black();
+                    p.foreground_color = foreground;
+                }};
+            canvas.DrawText(2 * board_position_.x + 4 * x,
+                            4 * (y + board_position_.y), "##", color_stylizer);
+        }
+    }
+}
+
+void nonogram_component::draw_palette(ftxui::Canvas& canvas) const
+{
+    const auto& puzzle{*game_->puzzle};
+    const auto canvas_y{(board_position_.y + puzzle.dimensions.y + 1) * 4};
+    for (std::size_t i{0}; i < puzzle.palette.size(); i++) {
+        const auto c{puzzle.palette[i]};
+        const std::function stylizer{
+            [background = terminal_color(c),
+             foreground = text_color_on(c)](ftxui::Pixel& p) {
+                p.background_color = background;
+                p.foreground_color = foreground;
+            }};
+        canvas.DrawText((board_position_.x + gsl::narrow<int>(i) * 2) * 2,
+                        canvas_y, i == color_ ? "<>" : "  ", stylizer);
+    }
+}
+
 [[nodiscard]] auto all_points(const auto& dimensions)
 {
     return rv::cartesian_product(rv::ints(0, dimensions.y),
@@ -193,15 +452,31 @@ canvas_coords term2canvas(term_coords board_position, term_coords term) noexcept
     const int width{game_->puzzle->dimensions.x};
     const int height{game_->puzzle->dimensions.y};
 
-    ftxui::Canvas out{(width + board_position_.x) * 4,
-                      (height + board_position_.y) * 4};
+    // A colour puzzle has its palette below the board, after a blank row.
+    const auto palette_columns{gsl::narrow<int>(puzzle.palette.size())};
+    const int palette_rows{puzzle.is_colored() ? 2 : 0};
+    ftxui::Canvas out{
+        (std::max(width, palette_columns) + board_position_.x) * 4,
+        (height + board_position_.y + palette_rows) * 4};
+    if (puzzle.is_colored()) {
+        draw_palette(out);
+    }
 
     // Draw board
-    for (const auto [x, y] : all_points(game_->puzzle->dimensions)) {
-        // TODO: extract function to convert coordinates
-        draw_rect(out, 4 * x + 2 * board_position_.x,
-                  4 * (y + board_position_.y), 4, 4, true,
-                  square_color({x, y}));
+    const auto assist{current_assist()};
+    if (current_render_options().glyph_cells) {
+        draw_glyph_rows(out, assist.get());
+    }
+    else {
+        for (const auto [x, y] : all_points(game_->puzzle->dimensions)) {
+            const auto hint{
+                assist ? assist->cells[gsl::narrow<std::size_t>(y * width + x)]
+                       : assist_hint::none};
+            // TODO: extract function to convert coordinates
+            draw_rect(out, 4 * x + 2 * board_position_.x,
+                      4 * (y + board_position_.y), 4, 4, true,
+                      square_color({x, y}, hint));
+        }
     }
 
     const std::function default_stylizer{[=](ftxui::Pixel& p) {
@@ -214,6 +489,42 @@ canvas_coords term2canvas(term_coords board_position, term_coords term) noexcept
         p.foreground_color = black();
     }};
 
+    // Hints already satisfied by the board are dimmed.
+    const std::function satisfied_stylizer{[=](ftxui::Pixel& p) {
+        p.background_color = black();
+        p.foreground_color = gray();
+    }};
+
+    const std::function satisfied_highlight_stylizer{[=](ftxui::Pixel& p) {
+        p.background_color = white_select();
+        p.foreground_color = gray();
+    }};
+
+    const auto hint_stylizer{
+        [&](bool highlighted, bool satisfied) -> const auto& {
+            if (satisfied) {
+                return highlighted ? satisfied_highlight_stylizer
+                                   : satisfied_stylizer;
+            }
+            return highlighted ? highlight_stylizer : default_stylizer;
+        }};
+
+    // A colour puzzle's hints are on their colours, so highlighting makes
+    // them bold rather than changing the background.
+    const auto colors{terminal_palette(puzzle)};
+    const auto color_hint_stylizer{
+        [&](std::uint8_t c, bool highlighted, bool satisfied) {
+            return std::function{
+                [background = colors[c],
+                 foreground = text_color_on(puzzle.palette[c]), highlighted,
+                 satisfied](ftxui::Pixel& p) {
+                    p.background_color = background;
+                    p.foreground_color = foreground;
+                    p.bold = highlighted;
+                    p.dim = satisfied;
+                }};
+        }};
+
     // Draw row hints
     for (int y{0}; y < height; y++) {
         const auto& this_row_hints{
@@ -221,11 +532,24 @@ canvas_coords term2canvas(term_coords board_position, term_coords term) noexcept
         const auto canvas_y{(board_position_.y + y) * 4};
         for (const auto [i, hint] :
              this_row_hints | rv::reverse | rv::enumerate) {
-            const auto str{fmt::format("{:4}", hint)};
             const auto canvas_x{
                 (board_position_.x - (3 * (gsl::narrow<int>(i) + 1)) - 1) * 2};
-            const auto& stylizer{selected_.y == y ? highlight_stylizer
-                                                  : default_stylizer};
+            const bool highlighted{selected_.y == y};
+            const bool satisfied{
+                game_->row_satisfied[gsl::narrow<std::size_t>(y)]};
+            if (puzzle.is_colored()) {
+                // Three characters apiece, so neighbouring colours don't
+                // overlap.
+                const auto& row_colors{
+                    puzzle.row_hint_colors[gsl::narrow<std::size_t>(y)]};
+                const auto c{row_colors[row_colors.size() - 1 -
+                                        gsl::narrow<std::size_t>(i)]};
+                out.DrawText(canvas_x + 2, canvas_y, fmt::format("{:3}", hint),
+                             color_hint_stylizer(c, highlighted, satisfied));
+                continue;
+            }
+            const auto str{fmt::format("{:4}", hint)};
+            const auto& stylizer{hint_stylizer(highlighted, satisfied)};
             out.DrawText(canvas_x, canvas_y, str, stylizer);
         }
     }
@@ -239,8 +563,19 @@ canvas_coords term2canvas(term_coords board_position, term_coords term) noexcept
             const auto str{fmt::format("{:2}", hint)};
             const auto canvas_y{
                 (board_position_.y - (gsl::narrow<int>(i) + 1)) * 4};
-            const auto& stylizer{selected_.x == x ? highlight_stylizer
-                                                  : default_stylizer};
+            const bool highlighted{selected_.x == x};
+            const bool satisfied{
+                game_->col_satisfied[gsl::narrow<std::size_t>(x)]};
+            if (puzzle.is_colored()) {
+                const auto& col_colors{
+                    puzzle.col_hint_colors[gsl::narrow<std::size_t>(x)]};
+                const auto c{col_colors[col_colors.size() - 1 -
+                                        gsl::narrow<std::size_t>(i)]};
+                out.DrawText(canvas_x, canvas_y, str,
+                             color_hint_stylizer(c, highlighted, satisfied));
+                continue;
+            }
+            const auto& stylizer{hint_stylizer(highlighted, satisfied)};
             out.DrawText(canvas_x, canvas_y, str, stylizer);
         }
     }
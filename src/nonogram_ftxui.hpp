@@ -8,16 +8,24 @@
 #ifndef NONOGRAM_FTXUI_HPP
 #define NONOGRAM_FTXUI_HPP
 
+#include "assistant.hpp"
+#include "compact_image.hpp"
 #include "file.hpp"
 #include "nonogram.hpp"
+#include "shared_board.hpp"
 
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/event.hpp>
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+
 namespace grandrounds {
 
 void draw_photo_on_canvas(ftxui::Canvas& canvas,
-                          const loaded_image& photo,
+                          const compact_image& photo,
                           canvas_coords offset);
 
 class nonogram_component : public ftxui::ComponentBase {
@@ -33,6 +41,19 @@ class nonogram_component : public ftxui::ComponentBase {
 	
     bool IsSolved() { return solved_; }
 
+    // Highlight cells that can be deduced from a single row or column, and
+    // cells that conflict with the hints.  The analysis runs on a worker
+    // thread, which calls `request_redraw` whenever it has a new result.
+    void EnableAssist(std::function<void()> request_redraw);
+    void DisableAssist();
+    bool IsAssisting() const { return assistant_ != nullptr; }
+
+    // Play co-operatively on a board that other components, in this thread
+    // or others, are also playing on.  Moves go to the shared board, and each
+    // render picks up the cells the other players have changed since the
+    // last one.
+    void Share(std::shared_ptr<shared_board> board);
+
    private:
     static void draw_rect(ftxui::Canvas& canvas,
                           int x,
@@ -42,16 +63,29 @@ class nonogram_component : public ftxui::ComponentBase {
                           bool value,
                           ftxui::Color color);
 
-    [[nodiscard]] ftxui::Color square_color(board_coords square) const noexcept;
+    void board_changed();
+    void pull_shared_changes();
+    [[nodiscard]] std::shared_ptr<const assist_result> current_assist() const;
+    [[nodiscard]] ftxui::Color square_color(board_coords square,
+                                            assist_hint hint) const noexcept;
 	
     [[nodiscard]] ftxui::Canvas draw_photo() const;
     [[nodiscard]] ftxui::Canvas draw_board() const;
+    // Each row of cells as a single run of text in one style.
+    void draw_glyph_rows(ftxui::Canvas& canvas,
+                         const assist_result* assist) const;
+    // A colour puzzle's colours, under the board, to pick one to fill with.
+    void draw_palette(ftxui::Canvas& canvas) const;
 
     std::shared_ptr<nonogram_game> game_;  // State of the game in progress
     board_coords selected_{-1, -1};  // Currently-selected square on the board
     term_coords board_position_;     // Terminal coordinates where the top-left
                                      // character of the board will be drawn
+    std::uint8_t color_{0};          // Palette index a left click fills with
 	bool solved_{false};
+    std::unique_ptr<hint_assistant> assistant_;  // Null unless assisting
+    std::shared_ptr<shared_board> shared_;       // Null unless co-operating
+    std::optional<shared_board::viewer> viewer_;
 };
 
 }  // namespace grandrounds
@@ -0,0 +1,192 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "puzzle_cache.hpp"
+
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace grandrounds {
+
+namespace {
+
+template <typename T>
+std::size_t vector_bytes(const std::vector<T>& vec) noexcept
+{
+    return vec.capacity() * sizeof(T);
+}
+
+}  // namespace
+
+std::size_t puzzle_bytes(const nonogram_puzzle& puzzle) noexcept
+{
+    std::size_t out{sizeof(nonogram_puzzle)};
+    out += vector_bytes(puzzle.solution);
+    out += vector_bytes(puzzle.palette);
+    out += puzzle.photo.bytes();
+    out += puzzle.small_photo.bytes();
+    for (const auto* hints :
+         {&puzzle.row_hints, &puzzle.col_hints, &puzzle.row_hint_colors,
+          &puzzle.col_hint_colors}) {
+        out += vector_bytes(*hints);
+        for (const auto& line : *hints) {
+            out += vector_bytes(line);
+        }
+    }
+    for (const auto* text :
+         {&puzzle.data.title, &puzzle.data.description, &puzzle.data.author,
+          &puzzle.data.date, &puzzle.data.license, &puzzle.data.wikipedia}) {
+        out += text->capacity();
+    }
+    return out;
+}
+
+puzzle_cache::puzzle_cache(std::size_t byte_budget,
+                           loader load,
+                           time_source modified_time)
+    : load_{std::move(load)},
+      modified_time_{std::move(modified_time)},
+      byte_budget_{byte_budget}
+{
+    if (!load_) {
+        load_ = [](std::string_view name) {
+            return std::make_shared<const nonogram_puzzle>(name);
+        };
+    }
+    if (!modified_time_) {
+        modified_time_ = puzzle_modified_time;
+    }
+}
+
+std::shared_ptr<const nonogram_puzzle> puzzle_cache::get(std::string_view name)
+{
+    // Checked outside the lock, since it touches the filesystem.
+    const auto modified{modified_time_(name)};
+
+    std::promise<shared_puzzle> promise;
+    std::shared_future<shared_puzzle> puzzle;
+    std::uint64_t load_id{0};
+    {
+        const std::lock_guard lock{mutex_};
+        const auto found{entries_.find(name)};
+        if (found != entries_.end() && found->second.modified == modified) {
+            lru_.splice(lru_.begin(), lru_, found->second.lru_position);
+            puzzle = found->second.puzzle;
+        }
+        else {
+            if (found != entries_.end()) {
+                erase(found);
+            }
+            puzzle = promise.get_future().share();
+            load_id = ++last_load_id_;
+            lru_.emplace_front(name);
+            entries_.emplace(
+                name, entry{modified, puzzle, load_id, 0, false, lru_.begin()});
+        }
+    }
+    if (load_id == 0) {
+        return puzzle.get();
+    }
+
+    // Loaded without the lock held, so that other puzzles can be fetched
+    // meanwhile; other requests for this one wait on the future.
+    try {
+        auto loaded{load_(name)};
+        const auto bytes{puzzle_bytes(*loaded)};
+        promise.set_value(std::move(loaded));
+        finish_load(name, load_id, bytes);
+    }
+    catch (...) {
+        promise.set_exception(std::current_exception());
+        abandon_load(name, load_id);
+    }
+    return puzzle.get();
+}
+
+std::size_t puzzle_cache::byte_budget() const
+{
+    const std::lock_guard lock{mutex_};
+    return byte_budget_;
+}
+
+void puzzle_cache::set_byte_budget(std::size_t byte_budget)
+{
+    const std::lock_guard lock{mutex_};
+    byte_budget_ = byte_budget;
+    evict();
+}
+
+std::size_t puzzle_cache::bytes() const
+{
+    const std::lock_guard lock{mutex_};
+    return bytes_;
+}
+
+std::size_t puzzle_cache::size() const
+{
+    const std::lock_guard lock{mutex_};
+    return entries_.size();
+}
+
+void puzzle_cache::clear()
+{
+    const std::lock_guard lock{mutex_};
+    entries_.clear();
+    lru_.clear();
+    bytes_ = 0;
+}
+
+void puzzle_cache::finish_load(std::string_view name,
+                               std::uint64_t load_id,
+                               std::size_t bytes)
+{
+    const std::lock_guard lock{mutex_};
+    // The entry may have been replaced or dropped while loading.
+    const auto found{entries_.find(name)};
+    if (found == entries_.end() || found->second.load_id != load_id) {
+        return;
+    }
+    found->second.bytes = bytes;
+    found->second.loaded = true;
+    bytes_ += bytes;
+    evict();
+}
+
+void puzzle_cache::abandon_load(std::string_view name, std::uint64_t load_id)
+{
+    const std::lock_guard lock{mutex_};
+    const auto found{entries_.find(name)};
+    if (found != entries_.end() && found->second.load_id == load_id) {
+        erase(found);
+    }
+}
+
+void puzzle_cache::erase(
+    std::map<std::string, entry, std::less<>>::iterator position)
+{
+    bytes_ -= position->second.bytes;
+    lru_.erase(position->second.lru_position);
+    entries_.erase(position);
+}
+
+void puzzle_cache::evict()
+{
+    // Walk from the least recently used end.  Entries still loading have no
+    // size yet and are passed over.
+    auto candidate{lru_.end()};
+    while (bytes_ > byte_budget_ && candidate != lru_.begin()) {
+        --candidate;
+        const auto found{entries_.find(*candidate)};
+        if (found->second.loaded) {
+            ++candidate;  // Step off the node that erase() removes
+            erase(found);
+        }
+    }
+}
+
+}  // namespace grandrounds
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef PUZZLE_CACHE_HPP
+#define PUZZLE_CACHE_HPP
+
+#include "nonogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace grandrounds {
+
+// The memory a loaded puzzle holds: its images, solution, palette, hints and
+// their colours, and text.
+[[nodiscard]] std::size_t puzzle_bytes(const nonogram_puzzle& puzzle) noexcept;
+
+// Loaded puzzles, shared between everything that plays or displays them.
+// Entries are keyed by name and by when the puzzle's files were last
+// changed, so an edited puzzle is loaded again.  Concurrent requests for a
+// puzzle that isn't loaded yet wait for a single load.  Once the puzzles held
+// exceed the byte budget, the least recently used ones are dropped; a puzzle
+// still in use elsewhere stays alive until its last user lets it go, but the
+// cache no longer counts or keeps it.
+class puzzle_cache {
+   public:
+    using loader =
+        std::function<std::shared_ptr<const nonogram_puzzle>(std::string_view)>;
+    using time_source =
+        std::function<std::optional<std::filesystem::file_time_type>(
+            std::string_view)>;
+
+    // By default puzzles are loaded with the nonogram_puzzle constructor and
+    // dated with puzzle_modified_time().
+    explicit puzzle_cache(std::size_t byte_budget,
+                          loader load = {},
+                          time_source modified_time = {});
+
+    // Throws whatever loading the puzzle throws; a failed load isn't cached.
+    [[nodiscard]] std::shared_ptr<const nonogram_puzzle> get(
+        std::string_view name);
+
+    [[nodiscard]] std::size_t byte_budget() const;
+    void set_byte_budget(std::size_t byte_budget);
+    [[nodiscard]] std::size_t bytes() const;  // Held by loaded entries
+    [[nodiscard]] std::size_t size() const;   // Entries, including loading ones
+    void clear();
+
+   private:
+    using stamp = std::optional<std::filesystem::file_time_type>;
+    using shared_puzzle = std::shared_ptr<const nonogram_puzzle>;
+
+    struct entry {
+        stamp modified;
+        std::shared_future<shared_puzzle> puzzle;
+        // Tells a load apart from a later one that replaced its entry.
+        std::uint64_t load_id{0};
+        std::size_t bytes{0};  // Zero until loaded
+        bool loaded{false};
+        std::list<std::string>::iterator lru_position;
+    };
+
+    void finish_load(std::string_view name,
+                     std::uint64_t load_id,
+                     std::size_t bytes);
+    void abandon_load(std::string_view name, std::uint64_t load_id);
+    // These require mutex_.
+    void erase(std::map<std::string, entry, std::less<>>::iterator position);
+    void evict();
+
+    loader load_;
+    time_source modified_time_;
+    mutable std::mutex mutex_;
+    std::size_t byte_budget_;                      // Guarded by mutex_
+    std::size_t bytes_{0};                         // Guarded by mutex_
+    std::uint64_t last_load_id_{0};                // Guarded by mutex_
+    std::map<std::string, entry, std::less<>> entries_;  // Guarded by mutex_
+    std::list<std::string> lru_;  // Most recently used first; guarded by mutex_
+};
+
+}  // namespace grandrounds
+
+#endif  // PUZZLE_CACHE_HPP
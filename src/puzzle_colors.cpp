@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "puzzle_colors.hpp"
+
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+// White, the background of a colour puzzle's solution image.
+constexpr color background_color{255, 255, 255};
+
+// Colours closer than this are one colour drawn unevenly: about 40 levels
+// apart in each channel.
+constexpr int same_color_distance{3 * 40 * 40};
+
+constexpr std::uint32_t pack(color c) noexcept
+{
+    return (std::uint32_t{c.r} << 16U) | (std::uint32_t{c.g} << 8U) | c.b;
+}
+
+constexpr color unpack(std::uint32_t packed) noexcept
+{
+    return {static_cast<std::uint8_t>(packed >> 16U),
+            static_cast<std::uint8_t>(packed >> 8U),
+            static_cast<std::uint8_t>(packed)};
+}
+
+}  // namespace
+
+int color_distance(color a, color b) noexcept
+{
+    const int dr{int{a.r} - int{b.r}};
+    const int dg{int{a.g} - int{b.g}};
+    const int db{int{a.b} - int{b.b}};
+    return dr * dr + dg * dg + db * db;
+}
+
+std::vector<board_cell> quantize_solution(std::span<const std::uint8_t> pixels,
+                                          std::size_t channels,
+                                          int max_colors,
+                                          std::vector<color>& palette)
+{
+    if (channels < 3 || max_colors < 1 || max_colors > max_puzzle_colors) {
+        throw std::invalid_argument{
+            "Solutions are quantised from RGB to a few colours"};
+    }
+    const std::size_t count{pixels.size() / channels};
+    const auto pixel_at{[&](std::size_t i) {
+        return color{pixels[i * channels], pixels[i * channels + 1],
+                     pixels[i * channels + 2]};
+    }};
+
+    // The most common colours first, breaking ties by value so that the
+    // palette is the same every time.
+    std::map<std::uint32_t, std::size_t> counts;
+    for (std::size_t i{0}; i < count; i++) {
+        counts[pack(pixel_at(i))]++;
+    }
+    std::vector<std::pair<std::size_t, std::uint32_t>> common;
+    common.reserve(counts.size());
+    for (const auto& [packed, n] : counts) {
+        common.emplace_back(n, packed);
+    }
+    std::ranges::stable_sort(common, std::greater{},
+                             [](const auto& entry) { return entry.first; });
+
+    palette.clear();
+    for (const auto& [n, packed] : common) {
+        if (palette.size() == gsl::narrow<std::size_t>(max_colors)) {
+            break;
+        }
+        const auto candidate{unpack(packed)};
+        const auto near{[&](color c) {
+            return color_distance(candidate, c) < same_color_distance;
+        }};
+        if (!near(background_color) && std::ranges::none_of(palette, near)) {
+            palette.push_back(candidate);
+        }
+    }
+
+    // White comes first so that it wins ties.
+    std::vector<board_cell> out;
+    out.reserve(count);
+    for (std::size_t i{0}; i < count; i++) {
+        const auto c{pixel_at(i)};
+        auto best{color_distance(c, background_color)};
+        auto cell{board_cell::clear};
+        for (std::size_t k{0}; k < palette.size(); k++) {
+            const auto distance{color_distance(c, palette[k])};
+            if (distance < best) {
+                best = distance;
+                cell = filled_cell(static_cast<std::uint8_t>(k));
+            }
+        }
+        out.push_back(cell);
+    }
+    return out;
+}
+
+}  // namespace grandrounds
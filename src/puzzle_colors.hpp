@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef PUZZLE_COLORS_HPP
+#define PUZZLE_COLORS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Board cells and the colours of a colour puzzle: quantising a solution image
+// and reading hints off a line of cells.  Kept apart from the rest of the game
+// so that the embed_assets build tool computes the embedded puzzles exactly as
+// the game computes puzzles loaded from files.
+namespace grandrounds {
+
+struct color {
+    std::uint8_t r{0};
+    std::uint8_t g{0};
+    std::uint8_t b{0};
+
+    friend bool operator==(const color&, const color&) = default;
+};
+
+// Squared distance between two colours in RGB space.
+[[nodiscard]] int color_distance(color a, color b) noexcept;
+
+// Cells are a byte each.  In a colour puzzle a filled cell also holds its
+// colour, as an index into the puzzle's palette: board_cell::filled is the
+// first colour, and the rest follow board_cell::marked.  Use filled_cell(),
+// is_filled() and cell_color() rather than the values.
+enum class board_cell : std::uint8_t { clear, filled, marked };
+
+// Colour puzzles have at most this many colours, which the terminal can tell
+// apart and a player can pick between.
+inline constexpr int max_puzzle_colors{16};
+
+[[nodiscard]] constexpr board_cell filled_cell(std::uint8_t color) noexcept
+{
+    return color == 0 ? board_cell::filled
+                      : static_cast<board_cell>(
+                            static_cast<std::uint8_t>(board_cell::marked) +
+                            color);
+}
+
+[[nodiscard]] constexpr bool is_filled(board_cell cell) noexcept
+{
+    return cell == board_cell::filled || cell > board_cell::marked;
+}
+
+// The palette index of a filled cell.
+[[nodiscard]] constexpr std::uint8_t cell_color(board_cell cell) noexcept
+{
+    return cell == board_cell::filled
+               ? std::uint8_t{0}
+               : static_cast<std::uint8_t>(
+                     static_cast<std::uint8_t>(cell) -
+                     static_cast<std::uint8_t>(board_cell::marked));
+}
+
+// A filled cell as itself, and any other as clear, so that a run is a
+// stretch of equal cells whatever the puzzle's colours.
+[[nodiscard]] constexpr board_cell run_cell(board_cell cell) noexcept
+{
+    return is_filled(cell) ? cell : board_cell::clear;
+}
+
+// The runs of filled cells in a line of board_cell, in a single pass.  A run
+// ends at a clear or marked cell, or where the colour changes, which never
+// happens in a black-and-white puzzle.  Each run's colour goes to `colors`
+// unless it's null.
+void calculate_hints(const auto& line,
+                     std::vector<std::uint8_t>& lengths,
+                     std::vector<std::uint8_t>* colors)
+{
+    std::uint8_t run{0};
+    board_cell current{board_cell::clear};
+    const auto end_run{[&] {
+        if (run > 0) {
+            lengths.push_back(run);
+            if (colors != nullptr) {
+                colors->push_back(cell_color(current));
+            }
+        }
+        run = 0;
+    }};
+    for (const auto cell : line) {
+        const auto this_cell{run_cell(cell)};
+        if (this_cell != current) {
+            end_run();
+            current = this_cell;
+        }
+        if (this_cell != board_cell::clear) {
+            ++run;
+        }
+    }
+    end_run();
+}
+
+// The solution of a colour puzzle from pixels of `channels` bytes each, red,
+// green and blue first.  White is the background, and is clear.  The palette
+// is the most common other colours, skipping any too close to white or to a
+// colour already chosen, up to `max_colors` of them; then each pixel takes
+// the nearest of white and the palette.  So antialiased edges and slightly
+// uneven fills come out as the colours they were meant to be.  Throws
+// std::invalid_argument unless `max_colors` is from 1 to max_puzzle_colors.
+std::vector<board_cell> quantize_solution(std::span<const std::uint8_t> pixels,
+                                          std::size_t channels,
+                                          int max_colors,
+                                          std::vector<color>& palette);
+
+}  // namespace grandrounds
+
+#endif  // PUZZLE_COLORS_HPP
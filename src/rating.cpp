@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "rating.hpp"
+#include "file.hpp"
+#include "task_pool.hpp"
+
+#include <fmt/format.h>
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+constexpr int points_per_round{3};
+constexpr int max_round_points{30};
+constexpr int max_slack_points{20};
+constexpr int probing_points{20};
+constexpr int branching_points{30};
+constexpr int points_per_doubling{5};  // Of the number of search nodes
+
+// Single-threaded: batches parallelise across puzzles instead, and the node
+// counts stay deterministic.
+solver_options rating_options()
+{
+    solver_options options;
+    options.threads = 1;
+    return options;
+}
+
+difficulty_rating rating_from_result(const solve_result& result)
+{
+    const auto& stats{result.stats};
+
+    difficulty_rating out;
+    out.status = result.status;
+    out.propagation_rounds = stats.root_propagation_rounds;
+    out.hardest_line_slack = stats.hardest_line_slack;
+    out.needed_probing = stats.probes > 0;
+    out.needed_branching = stats.max_depth > 0;
+    out.search_nodes = stats.nodes;
+
+    out.score = std::min(max_round_points,
+                         gsl::narrow<int>(out.propagation_rounds) *
+                             points_per_round) +
+                std::min(max_slack_points, out.hardest_line_slack);
+    if (out.needed_probing) {
+        out.score += probing_points;
+    }
+    if (out.needed_branching) {
+        out.score += branching_points +
+                     points_per_doubling *
+                         gsl::narrow<int>(std::bit_width(out.search_nodes));
+    }
+    return out;
+}
+
+}  // namespace
+
+difficulty_rating rate_puzzle(board_coords dimensions,
+                              const std::vector<line_hints>& row_hints,
+                              const std::vector<line_hints>& col_hints)
+{
+    return rating_from_result(
+        solve_nonogram(dimensions, row_hints, col_hints, rating_options()));
+}
+
+difficulty_rating rate_puzzle(const nonogram_puzzle& puzzle)
+{
+    return rating_from_result(solve_nonogram(puzzle, rating_options()));
+}
+
+std::vector<named_rating> rate_puzzle_files(
+    const std::filesystem::path& puzzle_dir,
+    const std::vector<std::string>& names,
+    unsigned int threads)
+{
+    std::vector<named_rating> out(names.size());
+    task_pool pool{threads};
+    for (std::size_t i{0}; i < names.size(); i++) {
+        pool.submit([&, i] {
+            const auto nonogram_path{
+                puzzle_dir / fmt::format("{}_nonogram.png", names[i])};
+            const auto json_path{
+                puzzle_dir / fmt::format("{}_data.json", names[i])};
+            out[i].name = names[i];
+            // A colour puzzle says so in its data, and is rated in colour.
+            const auto colors{std::filesystem::exists(json_path)
+                                  ? load_puzzle_data(json_path).colors
+                                  : std::nullopt};
+            if (colors) {
+                board_coords size;
+                std::vector<color> palette;
+                auto cells{load_solution(nonogram_path, colors, size, palette)};
+                out[i].rating = rate_puzzle(nonogram_puzzle{
+                    size, std::move(cells), std::move(palette)});
+                return;
+            }
+            const auto image{load_image(nonogram_path)};
+            const auto solution{solution_from_image(image)};
+            const auto width{gsl::narrow<int>(image.width)};
+            out[i].rating = rate_puzzle(
+                {width, gsl::narrow<int>(image.height)},
+                calculate_row_hints(solution, width),
+                calculate_col_hints(solution, width));
+        });
+    }
+    pool.wait();
+    return out;
+}
+
+void rate_puzzles(const std::vector<std::string>& names)
+{
+    const auto puzzle_dir{find_puzzles_dir()};
+    const auto ratings{rate_puzzle_files(
+        puzzle_dir, names.empty() ? find_puzzle_names(puzzle_dir) : names)};
+
+    fmt::print("{:<24} {:>5} {:>7} {:>6} {:>6} {:>7} {:>7}\n", "puzzle",
+               "score", "rounds", "slack", "probe", "branch", "nodes");
+    for (const auto& [name, rating] : ratings) {
+        fmt::print("{:<24} {:>5} {:>7} {:>6} {:>6} {:>7} {:>7}{}\n", name,
+                   rating.score, rating.propagation_rounds,
+                   rating.hardest_line_slack,
+                   rating.needed_probing ? "yes" : "no",
+                   rating.needed_branching ? "yes" : "no",
+                   rating.search_nodes,
+                   rating.status == solve_status::unique
+                       ? ""
+                       : "  (warning: solution is not unique)");
+        save_puzzle_difficulty(puzzle_dir / fmt::format("{}_data.json", name),
+                               rating.score);
+    }
+}
+
+}  // namespace grandrounds
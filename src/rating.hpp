@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RATING_HPP
+#define RATING_HPP
+
+#include "nonogram.hpp"
+#include "solver.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace grandrounds {
+
+// How a solver got through a puzzle, and a score summarising it.  Higher
+// scores are harder; a puzzle line propagation finishes alone scores at most
+// 50, probing adds 20, and guessing adds at least 40 more.
+struct difficulty_rating {
+    int score{0};
+    solve_status status{solve_status::contradiction};
+    std::uint64_t propagation_rounds{0};
+    int hardest_line_slack{0};
+    bool needed_probing{false};
+    bool needed_branching{false};
+    std::uint64_t search_nodes{0};
+};
+
+difficulty_rating rate_puzzle(board_coords dimensions,
+                              const std::vector<line_hints>& row_hints,
+                              const std::vector<line_hints>& col_hints);
+
+difficulty_rating rate_puzzle(const nonogram_puzzle& puzzle);
+
+struct named_rating {
+    std::string name;
+    difficulty_rating rating;
+};
+
+// Rate puzzles in `puzzle_dir` by name, one per thread.  Only each puzzle's
+// solution image, and its data for whether it's in colour, is read.
+std::vector<named_rating> rate_puzzle_files(
+    const std::filesystem::path& puzzle_dir,
+    const std::vector<std::string>& names,
+    unsigned int threads = 0);
+
+// Rate the named puzzles (or every puzzle, if none are named), print the
+// results, and cache each score in the puzzle's data file so that the game
+// can order puzzles without solving them.
+void rate_puzzles(const std::vector<std::string>& names);
+
+}  // namespace grandrounds
+
+#endif  // RATING_HPP
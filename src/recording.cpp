@@ -0,0 +1,404 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "recording.hpp"
+#include "file.hpp"
+#include "game.hpp"
+
+#include <fmt/format.h>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+constexpr std::string_view magic{"grandrounds-recording 1\n"};
+
+enum class event_kind : std::uint8_t { character, special, mouse };
+
+// Bits of a mouse event's flags byte.
+constexpr std::uint8_t pressed_flag{1U << 0U};
+constexpr std::uint8_t shift_flag{1U << 1U};
+constexpr std::uint8_t meta_flag{1U << 2U};
+constexpr std::uint8_t control_flag{1U << 3U};
+
+// Seven bits at a time, least significant first, with the top bit set on
+// every byte but the last.
+void put_varint(std::string& out, std::uint64_t value)
+{
+    while (value >= 0x80U) {
+        out += static_cast<char>((value & 0x7FU) | 0x80U);
+        value >>= 7U;
+    }
+    out += static_cast<char>(value);
+}
+
+// Zigzag encoding keeps small negative numbers small.
+void put_signed(std::string& out, std::int64_t value)
+{
+    put_varint(out, (static_cast<std::uint64_t>(value) << 1U) ^
+                        static_cast<std::uint64_t>(value >> 63));
+}
+
+void put_string(std::string& out, std::string_view text)
+{
+    put_varint(out, text.size());
+    out += text;
+}
+
+class reader {
+   public:
+    explicit reader(std::string_view bytes) : bytes_{bytes} {}
+
+    [[nodiscard]] bool done() const noexcept { return bytes_.empty(); }
+
+    std::uint8_t byte()
+    {
+        if (bytes_.empty()) {
+            throw recording_error{"Recording ends in the middle of an event"};
+        }
+        const auto out{static_cast<std::uint8_t>(bytes_.front())};
+        bytes_.remove_prefix(1);
+        return out;
+    }
+
+    std::uint64_t varint()
+    {
+        std::uint64_t out{0};
+        for (unsigned int shift{0}; shift < 64; shift += 7) {
+            const auto next{byte()};
+            out |= static_cast<std::uint64_t>(next & 0x7FU) << shift;
+            if ((next & 0x80U) == 0) {
+                return out;
+            }
+        }
+        throw recording_error{"Recording has an oversized number"};
+    }
+
+    std::int64_t signed_varint()
+    {
+        const auto zigzag{varint()};
+        return static_cast<std::int64_t>(zigzag >> 1U) ^
+               -static_cast<std::int64_t>(zigzag & 1U);
+    }
+
+    std::string_view string()
+    {
+        const auto size{varint()};
+        if (size > bytes_.size()) {
+            throw recording_error{"Recording ends in the middle of an event"};
+        }
+        const auto out{bytes_.substr(0, size)};
+        bytes_.remove_prefix(size);
+        return out;
+    }
+
+    std::string_view line()
+    {
+        const auto end{bytes_.find('\n')};
+        if (end == std::string_view::npos) {
+            throw recording_error{"Recording has no header"};
+        }
+        const auto out{bytes_.substr(0, end)};
+        bytes_.remove_prefix(end + 1);
+        return out;
+    }
+
+   private:
+    std::string_view bytes_;
+};
+
+class recording_component : public ftxui::ComponentBase {
+   public:
+    recording_component(ftxui::Component child,
+                        std::function<void(const ftxui::Event&)> record)
+        : record_{std::move(record)}
+    {
+        Add(std::move(child));
+    }
+
+    bool OnEvent(ftxui::Event event) override
+    {
+        record_(event);
+        return ComponentBase::OnEvent(std::move(event));
+    }
+
+   private:
+    std::function<void(const ftxui::Event&)> record_;
+};
+
+template <typename Clock>
+std::chrono::nanoseconds since(typename Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                start);
+}
+
+std::string format_cost(std::chrono::nanoseconds cost)
+{
+    return fmt::format("{:.3f} ms",
+                       std::chrono::duration<double, std::milli>{cost}.count());
+}
+
+void print_costs(std::string_view what, const cost_summary& costs)
+{
+    fmt::print(
+        "  {:<10} {:>6}  median {}  90% {}  99% {}  max {}  total {}\n", what,
+        costs.count, format_cost(costs.median), format_cost(costs.p90),
+        format_cost(costs.p99), format_cost(costs.max),
+        format_cost(costs.total));
+}
+
+}  // namespace
+
+std::string encode_recording(const event_recording& recording)
+{
+    std::string out{magic};
+    out += recording.puzzle;
+    out += '\n';
+    put_signed(out, recording.frame_size.x);
+    put_signed(out, recording.frame_size.y);
+
+    std::chrono::microseconds previous{0};
+    for (const auto& [time, recorded] : recording.events) {
+        put_varint(out, gsl::narrow<std::uint64_t>((time - previous).count()));
+        previous = time;
+        auto event{recorded};  // mouse() isn't const
+        if (event.is_mouse()) {
+            const auto& mouse{event.mouse()};
+            out += static_cast<char>(event_kind::mouse);
+            out += static_cast<char>(mouse.button);
+            std::uint8_t flags{0};
+            if (mouse.motion == ftxui::Mouse::Pressed) {
+                flags |= pressed_flag;
+            }
+            if (mouse.shift) {
+                flags |= shift_flag;
+            }
+            if (mouse.meta) {
+                flags |= meta_flag;
+            }
+            if (mouse.control) {
+                flags |= control_flag;
+            }
+            out += static_cast<char>(flags);
+            put_signed(out, mouse.x);
+            put_signed(out, mouse.y);
+        }
+        else {
+            out += static_cast<char>(event.is_character()
+                                         ? event_kind::character
+                                         : event_kind::special);
+            put_string(out, event.input());
+        }
+    }
+    return out;
+}
+
+event_recording decode_recording(std::string_view bytes)
+{
+    if (!bytes.starts_with(magic)) {
+        throw recording_error{"Not a recording"};
+    }
+    reader in{bytes.substr(magic.size())};
+    event_recording out;
+    out.puzzle = in.line();
+    out.frame_size.x = gsl::narrow<int>(in.signed_varint());
+    out.frame_size.y = gsl::narrow<int>(in.signed_varint());
+
+    std::chrono::microseconds time{0};
+    while (!in.done()) {
+        time += std::chrono::microseconds{
+            gsl::narrow<std::chrono::microseconds::rep>(in.varint())};
+        const auto kind{in.byte()};
+        if (kind == static_cast<std::uint8_t>(event_kind::mouse)) {
+            ftxui::Mouse mouse;
+            const auto button{in.byte()};
+            if (button > ftxui::Mouse::WheelDown) {
+                throw recording_error{"Recording has an unknown mouse button"};
+            }
+            mouse.button = static_cast<ftxui::Mouse::Button>(button);
+            const auto flags{in.byte()};
+            mouse.motion = (flags & pressed_flag) != 0 ? ftxui::Mouse::Pressed
+                                                       : ftxui::Mouse::Released;
+            mouse.shift = (flags & shift_flag) != 0;
+            mouse.meta = (flags & meta_flag) != 0;
+            mouse.control = (flags & control_flag) != 0;
+            mouse.x = gsl::narrow<int>(in.signed_varint());
+            mouse.y = gsl::narrow<int>(in.signed_varint());
+            out.events.push_back({time, ftxui::Event::Mouse("", mouse)});
+        }
+        else if (kind == static_cast<std::uint8_t>(event_kind::character)) {
+            out.events.push_back(
+                {time, ftxui::Event::Character(std::string{in.string()})});
+        }
+        else if (kind == static_cast<std::uint8_t>(event_kind::special)) {
+            out.events.push_back(
+                {time, ftxui::Event::Special(std::string{in.string()})});
+        }
+        else {
+            throw recording_error{"Recording has an unknown kind of event"};
+        }
+    }
+    return out;
+}
+
+void save_recording(const std::filesystem::path& path,
+                    const event_recording& recording)
+{
+    std::ofstream out{path, std::ios::binary};
+    out << encode_recording(recording);
+    if (!out) {
+        throw file_error{"Could not write recording " + path.string()};
+    }
+}
+
+event_recording load_recording(const std::filesystem::path& path)
+{
+    return decode_recording(slurp(path));
+}
+
+event_recorder::event_recorder(std::string puzzle, term_coords frame_size)
+    : recording_{std::move(puzzle), frame_size, {}},
+      start_{std::chrono::steady_clock::now()}
+{
+}
+
+ftxui::Component event_recorder::wrap(ftxui::Component child)
+{
+    return std::make_shared<recording_component>(
+        std::move(child), [this](const ftxui::Event& event) { record(event); });
+}
+
+void event_recorder::record(const ftxui::Event& event)
+{
+    recording_.events.push_back(
+        {std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start_),
+         event});
+}
+
+cost_summary summarize_costs(std::vector<std::chrono::nanoseconds> costs)
+{
+    cost_summary out;
+    out.count = costs.size();
+    if (costs.empty()) {
+        return out;
+    }
+    std::sort(costs.begin(), costs.end());
+    const auto percentile{[&](std::size_t p) {
+        return costs[(costs.size() - 1) * p / 100];
+    }};
+    for (const auto cost : costs) {
+        out.total += cost;
+    }
+    out.median = percentile(50);
+    out.p90 = percentile(90);
+    out.p99 = percentile(99);
+    out.max = costs.back();
+    return out;
+}
+
+replay_result replay_recording(const event_recording& recording,
+                               bool real_time)
+{
+    using clock = std::chrono::steady_clock;
+    replay_result out;
+    const allocation_meter load_meter;
+    // Quitting and redraw requests only matter to a terminal.
+    const auto puzzle{make_puzzle_screen(recording.puzzle, [] {}, [] {})};
+    out.load_allocations = load_meter.since();
+    auto screen{ftxui::Screen::Create(
+        ftxui::Dimension::Fixed(recording.frame_size.x),
+        ftxui::Dimension::Fixed(recording.frame_size.y))};
+
+    std::vector<std::chrono::nanoseconds> event_costs;
+    std::vector<std::chrono::nanoseconds> frame_costs;
+    event_costs.reserve(recording.events.size());
+    frame_costs.reserve(recording.events.size() + 1);
+    const bool skip_unchanged{current_render_options().skip_unchanged_frames};
+    std::string previous_frame;
+    const auto draw_frame{[&] {
+        const allocation_meter meter;
+        const auto start{clock::now()};
+        screen.Clear();
+        ftxui::Render(screen, puzzle.root->Render());
+        auto frame{screen.ToString()};
+        frame_costs.push_back(since<clock>(start));
+        const auto allocated{meter.since()};
+        out.frame_allocations += allocated;
+        out.max_frame_allocations =
+            std::max(out.max_frame_allocations, allocated.allocations);
+        out.output.add(frame.size(), skip_unchanged && frame == previous_frame);
+        previous_frame = std::move(frame);
+    }};
+
+    const auto start{clock::now()};
+    draw_frame();
+    for (const auto& [time, recorded] : recording.events) {
+        if (real_time) {
+            std::this_thread::sleep_until(start + time);
+        }
+        const allocation_meter meter;
+        const auto event_start{clock::now()};
+        puzzle.root->OnEvent(recorded);
+        event_costs.push_back(since<clock>(event_start));
+        out.event_allocations += meter.since();
+        draw_frame();
+    }
+    out.total = since<clock>(start);
+    out.events = summarize_costs(std::move(event_costs));
+    out.frames = summarize_costs(std::move(frame_costs));
+    return out;
+}
+
+void report_replay(const std::filesystem::path& path, bool real_time)
+{
+    const auto recording{load_recording(path)};
+    const auto result{replay_recording(recording, real_time)};
+    fmt::print("Replayed {} events on {} at {}x{} in {}\n",
+               recording.events.size(), recording.puzzle,
+               recording.frame_size.x, recording.frame_size.y,
+               format_cost(result.total));
+    print_costs("OnEvent", result.events);
+    print_costs("Frame", result.frames);
+    const auto seconds{
+        recording.events.empty()
+            ? 0.0
+            : std::chrono::duration<double>{recording.events.back().time}
+                  .count()};
+    fmt::print("  Output: {}\n", describe_frames(result.output, seconds));
+    if (allocation_tracking_enabled) {
+        const auto per{[](const allocation_counts& counts, std::size_t count) {
+            return fmt::format(
+                "{:.1f} allocations, {:.0f} bytes",
+                static_cast<double>(counts.allocations) /
+                    static_cast<double>(std::max<std::size_t>(count, 1)),
+                static_cast<double>(counts.bytes) /
+                    static_cast<double>(std::max<std::size_t>(count, 1)));
+        }};
+        fmt::print("  Load: {}\n", per(result.load_allocations, 1));
+        fmt::print("  Per event: {}\n",
+                   per(result.event_allocations, result.events.count));
+        fmt::print("  Per frame: {} (at most {} allocations)\n",
+                   per(result.frame_allocations, result.frames.count),
+                   result.max_frame_allocations);
+    }
+}
+
+}  // namespace grandrounds
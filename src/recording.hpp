@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef RECORDING_HPP
+#define RECORDING_HPP
+
+#include "alloc_tracker.hpp"
+#include "nonogram.hpp"
+#include "terminal_output.hpp"
+
+#include <ftxui/component/component.hpp>
+#include <ftxui/component/event.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Recordings of the events a player's puzzle screen handled, which can be
+// played back against the same screen without a terminal.  A recording of a
+// real game makes a repeatable benchmark for the cost of handling events and
+// rendering frames.
+namespace grandrounds {
+
+class recording_error : public std::runtime_error {
+   public:
+    explicit recording_error(const std::string& msg) : std::runtime_error{msg}
+    {
+    }
+};
+
+struct recorded_event {
+    std::chrono::microseconds time{0};  // Since the recording started
+    ftxui::Event event;
+};
+
+struct event_recording {
+    std::string puzzle;
+    term_coords frame_size;  // Of the terminal when recording started
+    std::vector<recorded_event> events;
+};
+
+// A recording is a short text header followed by one entry per event: the
+// microseconds since the previous event and the event itself, in variable
+// length integers.  Mouse events keep their buttons, modifiers and position
+// but not the escape sequence they were parsed from.
+std::string encode_recording(const event_recording& recording);
+event_recording decode_recording(std::string_view bytes);
+void save_recording(const std::filesystem::path& path,
+                    const event_recording& recording);
+event_recording load_recording(const std::filesystem::path& path);
+
+// Records every event that reaches the components it wraps, before they
+// handle it.
+class event_recorder {
+   public:
+    event_recorder(std::string puzzle, term_coords frame_size);
+
+    // The recorder must outlive the component this returns.
+    [[nodiscard]] ftxui::Component wrap(ftxui::Component child);
+
+    [[nodiscard]] const event_recording& recording() const noexcept
+    {
+        return recording_;
+    }
+
+   private:
+    void record(const ftxui::Event& event);
+
+    event_recording recording_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+struct cost_summary {
+    std::size_t count{0};
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds median{0};
+    std::chrono::nanoseconds p90{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds max{0};
+};
+
+[[nodiscard]] cost_summary summarize_costs(
+    std::vector<std::chrono::nanoseconds> costs);
+
+struct replay_result {
+    std::chrono::nanoseconds total{0};  // Including any real-time waiting
+    cost_summary events;                // OnEvent() for each event
+    cost_summary frames;                // Render() and output for each frame
+    // Zero unless built with allocation tracking.  The load is whatever
+    // setting up the screen allocated, so it's small if the puzzle was
+    // already cached.
+    allocation_counts load_allocations;
+    allocation_counts event_allocations;  // Over all events
+    allocation_counts frame_allocations;  // Over all frames
+    std::uint64_t max_frame_allocations{0};
+    // What the frames would write to a terminal, under the render options.
+    frame_stats output;
+};
+
+// Play a recording back against a new puzzle screen, rendering a frame after
+// each event as the terminal would.  Events are handled as fast as possible,
+// or at the times they were recorded.  The assistant's results arrive on
+// their own schedule, so replays are only repeatable with it off.
+replay_result replay_recording(const event_recording& recording,
+                               bool real_time = false);
+
+// Replay a recording file and print its costs.
+void report_replay(const std::filesystem::path& path, bool real_time);
+
+}  // namespace grandrounds
+
+#endif  // RECORDING_HPP
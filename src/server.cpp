@@ -0,0 +1,781 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "server.hpp"
+#include "nonogram_ftxui.hpp"
+
+#include <fmt/format.h>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <gsl/narrow>
+#include <gsl/util>
+
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+// Requests longer than this, or responses a client leaves unread beyond
+// this, end the session.
+constexpr std::size_t max_request_bytes{4096};
+constexpr std::size_t max_pending_output_bytes{16UL * 1024 * 1024};
+constexpr int max_frame_side{1000};
+
+[[noreturn]] void throw_errno(std::string_view what)
+{
+    throw server_error{
+        fmt::format("{}: {}", what, std::generic_category().message(errno))};
+}
+
+class unique_fd {
+   public:
+    unique_fd() = default;
+    explicit unique_fd(int fd) noexcept : fd_{fd} {}
+    ~unique_fd() { reset(); }
+
+    unique_fd(const unique_fd&) = delete;
+    unique_fd& operator=(const unique_fd&) = delete;
+    unique_fd(unique_fd&& other) noexcept : fd_{std::exchange(other.fd_, -1)}
+    {
+    }
+    unique_fd& operator=(unique_fd&& other) noexcept
+    {
+        reset();
+        fd_ = std::exchange(other.fd_, -1);
+        return *this;
+    }
+
+    [[nodiscard]] int get() const noexcept { return fd_; }
+    [[nodiscard]] int release() noexcept { return std::exchange(fd_, -1); }
+
+    void reset() noexcept
+    {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+   private:
+    int fd_{-1};
+};
+
+sockaddr_un socket_address(const std::filesystem::path& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const auto& native{path.native()};
+    if (native.size() >= sizeof(address.sun_path)) {
+        throw server_error{"Socket path is too long: " + native};
+    }
+    std::memcpy(&address.sun_path[0], native.c_str(), native.size() + 1);
+    return address;
+}
+
+std::vector<std::string_view> split_words(std::string_view line)
+{
+    std::vector<std::string_view> out;
+    while (!line.empty()) {
+        const auto start{line.find_first_not_of(' ')};
+        if (start == std::string_view::npos) {
+            break;
+        }
+        line.remove_prefix(start);
+        const auto end{std::min(line.find(' '), line.size())};
+        out.push_back(line.substr(0, end));
+        line.remove_prefix(end);
+    }
+    return out;
+}
+
+std::optional<int> parse_int(std::string_view text)
+{
+    int value{0};
+    const auto* const end{text.data() + text.size()};
+    const auto [ptr, error]{std::from_chars(text.data(), end, value)};
+    if (error != std::errc{} || ptr != end) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Puzzle names are looked up as files, so a name from a client is held to
+// the characters the puzzles are named with: nothing that can leave the
+// puzzle directory.
+bool valid_puzzle_name(std::string_view name) noexcept
+{
+    return !name.empty() && std::ranges::all_of(name, [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_' || c == '-';
+    });
+}
+
+// A puzzle loaded for a session, with the board it shares if it was joined,
+// or what went wrong.
+struct loaded_puzzle {
+    std::shared_ptr<const nonogram_puzzle> puzzle;
+    std::shared_ptr<shared_board> board;
+    std::exception_ptr error;
+};
+
+// Loads finished on the server's worker threads, waiting for the event loop
+// of the session that asked for them.  Shared with the loads still running,
+// so that one finishing after its loop has returned is simply dropped.
+struct finished_loads {
+    struct load {
+        int fd;
+        std::uint64_t session_id;  // Tells sessions that reuse an fd apart
+        loaded_puzzle result;
+    };
+
+    unique_fd wake{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+    std::mutex mutex;
+    std::vector<load> loads;  // Guarded by mutex
+};
+
+class session {
+   public:
+    // Starts loading a puzzle, and joining its board if asked to, for
+    // finish_open() to be called with later.
+    using loader = std::function<void(std::string_view name, bool join)>;
+
+    session(unique_fd fd,
+            std::uint64_t id,
+            term_coords frame_size,
+            loader load)
+        : fd_{std::move(fd)},
+          id_{id},
+          frame_size_{frame_size},
+          load_{std::move(load)}
+    {
+    }
+
+    [[nodiscard]] int fd() const noexcept { return fd_.get(); }
+    [[nodiscard]] std::uint64_t id() const noexcept { return id_; }
+    // Requests after an open are left unread until the puzzle has loaded, so
+    // that they are answered in order.
+    [[nodiscard]] bool wants_read() const noexcept { return !loading_; }
+    [[nodiscard]] bool wants_write() const noexcept { return !output_.empty(); }
+
+    // Read what's available and answer every complete request.  Returns false
+    // once the session should be closed.
+    bool on_readable()
+    {
+        std::array<char, 4096> chunk{};
+        for (;;) {
+            const auto got{::read(fd_.get(), chunk.data(), chunk.size())};
+            if (got > 0) {
+                // Answered a chunk at a time, so a client sending faster than
+                // it's read can't make the session buffer more than a request.
+                input_.append(chunk.data(), gsl::narrow<std::size_t>(got));
+                if (!handle_requests()) {
+                    return false;
+                }
+                if (loading_) {
+                    break;
+                }
+                continue;
+            }
+            if (got == 0) {
+                return false;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        return on_writable();
+    }
+
+    // Returns false once the session should be closed.
+    bool on_writable()
+    {
+        while (!output_.empty()) {
+            const auto sent{::send(fd_.get(), output_.data(), output_.size(),
+                                   MSG_NOSIGNAL)};
+            if (sent >= 0) {
+                output_.erase(0, gsl::narrow<std::size_t>(sent));
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        return true;
+    }
+
+    // Answer the open or join that was waiting for a puzzle, then the
+    // requests that followed it.  Returns false once the session should be
+    // closed.
+    bool finish_open(loaded_puzzle loaded)
+    {
+        loading_ = false;
+        try {
+            if (loaded.error) {
+                std::rethrow_exception(loaded.error);
+            }
+            auto game{std::make_shared<nonogram_game>()};
+            game->puzzle = std::move(loaded.puzzle);
+            game->board.resize(game->puzzle->solution.size());
+            auto component{
+                std::make_shared<nonogram_component>(std::move(game))};
+            if (loaded.board) {
+                component->Share(std::move(loaded.board));
+            }
+            component_ = std::move(component);
+            frame();
+        }
+        catch (const std::exception& e) {
+            error(e.what());
+        }
+        return handle_requests() && on_writable();
+    }
+
+   private:
+    // Answer the complete requests in input_, up to one that has to wait for
+    // a puzzle to load.  Returns false on a request, or the start of one,
+    // that's too long, or once too much output is unsent.
+    bool handle_requests()
+    {
+        std::size_t line_start{0};
+        for (auto line_end{input_.find('\n')};
+             line_end != std::string::npos && !loading_;
+             line_end = input_.find('\n', line_start)) {
+            if (line_end - line_start > max_request_bytes) {
+                return false;
+            }
+            handle(std::string_view{input_}.substr(line_start,
+                                                   line_end - line_start));
+            line_start = line_end + 1;
+        }
+        input_.erase(0, line_start);
+        // Waiting for a load, input_ can hold the rest of a chunk, but no
+        // more is read until it's answered.
+        return (loading_ || input_.size() <= max_request_bytes) &&
+               output_.size() <= max_pending_output_bytes;
+    }
+
+    void handle(std::string_view line)
+    {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        const auto words{split_words(line)};
+        try {
+            if (words.empty()) {
+                error("empty request");
+            }
+            else if ((words[0] == "open" || words[0] == "join") &&
+                     words.size() == 2 && !valid_puzzle_name(words[1])) {
+                error("bad puzzle name");
+            }
+            else if ((words[0] == "open" || words[0] == "join") &&
+                     words.size() == 2) {
+                // Answered by finish_open().  The game is only replaced once
+                // the puzzle has loaded and, if joined, its board is shared,
+                // so a puzzle that can't be played together leaves the old
+                // one open.
+                load_(words[1], words[0] == "join");
+                loading_ = true;
+            }
+            else if (words[0] == "size" && words.size() == 3) {
+                const auto width{parse_int(words[1])};
+                const auto height{parse_int(words[2])};
+                if (!width || !height || *width <= 0 || *height <= 0 ||
+                    *width > max_frame_side || *height > max_frame_side) {
+                    error("bad size");
+                    return;
+                }
+                frame_size_ = {*width, *height};
+                frame();
+            }
+            else if (!component_) {
+                error("no puzzle open");
+            }
+            else if (words[0] == "press" && words.size() == 4) {
+                press(words[1], words[2], words[3]);
+            }
+            else if (words[0] == "solve" && words.size() == 1) {
+                component_->Solve();
+                frame();
+            }
+            else if (words[0] == "reset" && words.size() == 1) {
+                component_->Reset();
+                frame();
+            }
+            else if (words[0] == "frame" && words.size() == 1) {
+                frame();
+            }
+            else {
+                error("unknown request");
+            }
+        }
+        catch (const std::exception& e) {
+            error(e.what());
+        }
+    }
+
+    void press(std::string_view x_text,
+               std::string_view y_text,
+               std::string_view button_text)
+    {
+        const auto x{parse_int(x_text)};
+        const auto y{parse_int(y_text)};
+        ftxui::Mouse mouse;
+        if (button_text == "left") {
+            mouse.button = ftxui::Mouse::Left;
+        }
+        else if (button_text == "middle") {
+            mouse.button = ftxui::Mouse::Middle;
+        }
+        else if (button_text == "right") {
+            mouse.button = ftxui::Mouse::Right;
+        }
+        else {
+            error("bad button");
+            return;
+        }
+        if (!x || !y) {
+            error("bad coordinates");
+            return;
+        }
+        mouse.motion = ftxui::Mouse::Pressed;
+        mouse.x = *x;
+        mouse.y = *y;
+        component_->OnEvent(ftxui::Event::Mouse("", mouse));
+        frame();
+    }
+
+    void frame()
+    {
+        auto screen{
+            ftxui::Screen::Create(ftxui::Dimension::Fixed(frame_size_.x),
+                                  ftxui::Dimension::Fixed(frame_size_.y))};
+        if (component_) {
+            ftxui::Render(screen, component_->Render());
+        }
+        const auto text{screen.ToString()};
+        output_ += fmt::format("frame {}\n", text.size());
+        output_ += text;
+    }
+
+    void error(std::string_view message)
+    {
+        std::string line{message};
+        std::replace(line.begin(), line.end(), '\n', ' ');
+        output_ += fmt::format("error {}\n", line);
+    }
+
+    unique_fd fd_;
+    std::uint64_t id_;
+    term_coords frame_size_;
+    loader load_;
+    bool loading_{false};
+    // Null until a puzzle opens.
+    std::shared_ptr<nonogram_component> component_;
+    std::string input_;
+    std::string output_;
+};
+
+}  // namespace
+
+puzzle_server::puzzle_server(server_options options)
+    : options_{std::move(options)},
+      puzzles_{options_.cache_bytes},
+      loaders_{options_.threads}
+{
+    if (options_.threads == 0) {
+        options_.threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    const auto address{socket_address(options_.socket_path)};
+
+    unique_fd listen_fd{
+        ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+    if (listen_fd.get() < 0) {
+        throw_errno("socket");
+    }
+    // A socket file left behind by a server that didn't shut down cleanly
+    // would make bind() fail.  Anything else at that path is left alone.
+    if (std::filesystem::is_socket(options_.socket_path)) {
+        std::filesystem::remove(options_.socket_path);
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (::bind(listen_fd.get(), reinterpret_cast<const sockaddr*>(&address),
+               sizeof(address)) != 0) {
+        throw_errno("bind " + options_.socket_path.string());
+    }
+    if (::listen(listen_fd.get(), SOMAXCONN) != 0) {
+        throw_errno("listen");
+    }
+    unique_fd stop_fd{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+    if (stop_fd.get() < 0) {
+        throw_errno("eventfd");
+    }
+    listen_fd_ = listen_fd.release();
+    stop_fd_ = stop_fd.release();
+}
+
+puzzle_server::~puzzle_server()
+{
+    ::close(listen_fd_);
+    ::close(stop_fd_);
+    std::error_code ignored;
+    std::filesystem::remove(options_.socket_path, ignored);
+}
+
+void puzzle_server::run()
+{
+    // An exception leaving a thread would terminate the program, so the
+    // first one any loop throws is kept and rethrown once every loop has
+    // returned.
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto loop{[&]() noexcept {
+        try {
+            event_loop();
+        }
+        catch (...) {
+            {
+                const std::lock_guard lock{error_mutex};
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            stop();  // So that the other loops return and can be joined
+        }
+    }};
+    {
+        std::vector<std::jthread> others;
+        for (unsigned int i{1}; i < options_.threads; i++) {
+            others.emplace_back(loop);
+        }
+        loop();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void puzzle_server::stop() noexcept
+{
+    const std::uint64_t one{1};
+    static_cast<void>(::write(stop_fd_, &one, sizeof(one)));
+}
+
+void puzzle_server::event_loop()
+{
+    unique_fd epoll{::epoll_create1(EPOLL_CLOEXEC)};
+    if (epoll.get() < 0) {
+        throw_errno("epoll_create1");
+    }
+    const auto add{[&](int fd, std::uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (::epoll_ctl(epoll.get(), EPOLL_CTL_ADD, fd, &event) != 0) {
+            throw_errno("epoll_ctl");
+        }
+    }};
+    // EPOLLEXCLUSIVE wakes one loop per new connection instead of all of
+    // them.  The stop eventfd is never read, so it wakes every loop.
+    add(listen_fd_, EPOLLIN | EPOLLEXCLUSIVE);
+    add(stop_fd_, EPOLLIN);
+    const auto finished{std::make_shared<finished_loads>()};
+    if (finished->wake.get() < 0) {
+        throw_errno("eventfd");
+    }
+    add(finished->wake.get(), EPOLLIN);
+
+    std::unordered_map<int, session> sessions;
+    std::uint64_t last_session_id{0};
+    const auto close_session{[&](int fd) {
+        ::epoll_ctl(epoll.get(), EPOLL_CTL_DEL, fd, nullptr);
+        sessions.erase(fd);
+    }};
+    const auto interest{[](const session& s) {
+        return (s.wants_read() ? EPOLLIN | EPOLLRDHUP : 0U) |
+               (s.wants_write() ? EPOLLOUT : 0U);
+    }};
+    const auto watch{[&](const session& s) {
+        epoll_event event{};
+        event.events = interest(s);
+        event.data.fd = s.fd();
+        ::epoll_ctl(epoll.get(), EPOLL_CTL_MOD, s.fd(), &event);
+    }};
+    // Puzzles are loaded on the worker threads, which can take long enough
+    // to hold up every other session on this loop.
+    const auto start_load{[&](int fd, std::uint64_t id, std::string_view name,
+                              bool join_board) {
+        loaders_.submit([this, finished, fd, id, name = std::string{name},
+                         join_board] {
+            loaded_puzzle loaded;
+            try {
+                loaded.puzzle = puzzles_.get(name);
+                if (join_board) {
+                    loaded.board = join(name, *loaded.puzzle);
+                }
+            }
+            catch (...) {
+                loaded.error = std::current_exception();
+            }
+            {
+                const std::lock_guard lock{finished->mutex};
+                finished->loads.push_back({fd, id, std::move(loaded)});
+            }
+            const std::uint64_t one{1};
+            static_cast<void>(
+                ::write(finished->wake.get(), &one, sizeof(one)));
+        });
+    }};
+
+    std::array<epoll_event, 64> events{};
+    for (;;) {
+        const int ready{::epoll_wait(epoll.get(), events.data(),
+                                     gsl::narrow<int>(events.size()), -1)};
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("epoll_wait");
+        }
+        for (const auto& event :
+             std::span{events.data(), gsl::narrow<std::size_t>(ready)}) {
+            const int fd{event.data.fd};
+            if (fd == stop_fd_) {
+                return;
+            }
+            if (fd == finished->wake.get()) {
+                std::uint64_t count{0};
+                static_cast<void>(
+                    ::read(finished->wake.get(), &count, sizeof(count)));
+                std::vector<finished_loads::load> loads;
+                {
+                    const std::lock_guard lock{finished->mutex};
+                    std::swap(loads, finished->loads);
+                }
+                for (auto& load : loads) {
+                    const auto found{sessions.find(load.fd)};
+                    if (found == sessions.end() ||
+                        found->second.id() != load.session_id) {
+                        continue;  // Closed while its puzzle loaded
+                    }
+                    auto& s{found->second};
+                    if (!s.finish_open(std::move(load.result))) {
+                        close_session(load.fd);
+                    }
+                    else {
+                        watch(s);
+                    }
+                }
+                continue;
+            }
+            if (fd == listen_fd_) {
+                for (;;) {
+                    unique_fd client{::accept4(listen_fd_, nullptr, nullptr,
+                                               SOCK_NONBLOCK | SOCK_CLOEXEC)};
+                    if (client.get() < 0) {
+                        break;  // EAGAIN, or a connection that went away
+                    }
+                    const int client_fd{client.get()};
+                    const auto id{++last_session_id};
+                    sessions.try_emplace(
+                        client_fd, std::move(client), id, options_.frame_size,
+                        [&start_load, client_fd, id](std::string_view name,
+                                                     bool join_board) {
+                            start_load(client_fd, id, name, join_board);
+                        });
+                    add(client_fd, EPOLLIN | EPOLLRDHUP);
+                }
+                continue;
+            }
+
+            const auto found{sessions.find(fd)};
+            if (found == sessions.end()) {
+                continue;
+            }
+            auto& s{found->second};
+            const auto was_interested{interest(s)};
+            bool keep{(event.events & (EPOLLERR | EPOLLHUP)) == 0};
+            if (keep && (event.events & EPOLLOUT) != 0) {
+                keep = s.on_writable();
+            }
+            if (keep && (event.events & (EPOLLIN | EPOLLRDHUP)) != 0) {
+                keep = s.on_readable();
+            }
+            if (!keep) {
+                close_session(fd);
+            }
+            else if (interest(s) != was_interested) {
+                watch(s);
+            }
+        }
+    }
+}
+
+std::shared_ptr<shared_board> puzzle_server::join(
+    std::string_view name,
+    const nonogram_puzzle& puzzle)
+{
+    const std::lock_guard lock{boards_mutex_};
+    auto found{boards_.find(name)};
+    if (found == boards_.end()) {
+        found = boards_.try_emplace(std::string{name}).first;
+    }
+    auto board{found->second.lock()};
+    // A puzzle edited since its board was made needs a new one.
+    if (!board || board->size() != puzzle.solution.size()) {
+        board = std::make_shared<shared_board>(puzzle.solution);
+        found->second = board;
+    }
+    // Forget boards nobody is playing any more.
+    std::erase_if(boards_, [](const auto& entry) {
+        return entry.second.expired();
+    });
+    return board;
+}
+
+void serve_puzzles(const server_options& options)
+{
+    // Take SIGINT and SIGTERM on a thread of our own rather than in a handler,
+    // so that shutdown can do ordinary work.  The mask is inherited by the
+    // event loop threads started afterwards.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    puzzle_server server{options};
+    fmt::print("Serving puzzles on {}\n", server.socket_path().string());
+    std::jthread signal_waiter{[&] {
+        int signal{0};
+        sigwait(&signals, &signal);
+        server.stop();
+    }};
+    // If run() returns or throws for any other reason, wake the waiter so it
+    // can be joined.
+    const auto wake_waiter{gsl::finally(
+        [&] { pthread_kill(signal_waiter.native_handle(), SIGTERM); })};
+    server.run();
+}
+
+puzzle_client::puzzle_client(const std::filesystem::path& socket_path)
+    : fd_{::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)}
+{
+    if (fd_ < 0) {
+        throw_errno("socket");
+    }
+    const auto address{socket_address(socket_path)};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&address),
+                  sizeof(address)) != 0) {
+        ::close(fd_);
+        throw_errno("connect " + socket_path.string());
+    }
+}
+
+puzzle_client::~puzzle_client()
+{
+    ::close(fd_);
+}
+
+void puzzle_client::send(std::string_view request)
+{
+    std::string line{request};
+    line += '\n';
+    std::string_view remaining{line};
+    while (!remaining.empty()) {
+        const auto sent{
+            ::send(fd_, remaining.data(), remaining.size(), MSG_NOSIGNAL)};
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("send");
+        }
+        remaining.remove_prefix(gsl::narrow<std::size_t>(sent));
+    }
+}
+
+std::string puzzle_client::receive()
+{
+    const auto header{read_line()};
+    if (header.starts_with("error ")) {
+        throw server_error{header.substr(6)};
+    }
+    const auto size{header.starts_with("frame ")
+                        ? parse_int(std::string_view{header}.substr(6))
+                        : std::nullopt};
+    if (!size || *size < 0) {
+        throw server_error{"Bad response: " + header};
+    }
+    const auto bytes{gsl::narrow<std::size_t>(*size)};
+    while (buffer_.size() < bytes) {
+        read_more();
+    }
+    auto out{buffer_.substr(0, bytes)};
+    buffer_.erase(0, bytes);
+    return out;
+}
+
+std::string puzzle_client::read_line()
+{
+    for (auto end{buffer_.find('\n')};; end = buffer_.find('\n')) {
+        if (end != std::string::npos) {
+            auto out{buffer_.substr(0, end)};
+            buffer_.erase(0, end + 1);
+            return out;
+        }
+        read_more();
+    }
+}
+
+void puzzle_client::read_more()
+{
+    std::array<char, 65536> chunk{};
+    for (;;) {
+        const auto got{::read(fd_, chunk.data(), chunk.size())};
+        if (got > 0) {
+            buffer_.append(chunk.data(), gsl::narrow<std::size_t>(got));
+            return;
+        }
+        if (got == 0) {
+            throw server_error{"Server closed the connection"};
+        }
+        if (errno != EINTR) {
+            throw_errno("read");
+        }
+    }
+}
+
+}  // namespace grandrounds
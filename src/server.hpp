@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "nonogram.hpp"
+#include "puzzle_cache.hpp"
+#include "shared_board.hpp"
+#include "task_pool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Serves puzzles to many players over a Unix domain socket.  Every connection
+// is a session with its own game, rendered headlessly by nonogram_component;
+// the puzzles themselves are loaded once and shared through a puzzle_cache.
+//
+// The protocol is line based.  Each request line gets exactly one response,
+// in order:
+//
+//   open <NAME>               Start playing a puzzle.
+//   join <NAME>               Start playing a puzzle together with every
+//                             other session that has joined it.  Frames show
+//                             the moves of all of them.
+//   press <X> <Y> <BUTTON>    A mouse press at terminal column X and row Y of
+//                             the frame; BUTTON is left (fill), middle
+//                             (mark) or right (clear).
+//   solve / reset             As the buttons in the game do.
+//   size <WIDTH> <HEIGHT>     Change the frame size, in characters.
+//   frame                     Render without changing anything.
+//
+// Puzzle names are letters, digits, underscores and hyphens.
+//
+// A response is either "frame <N>\n" followed by N bytes of terminal output,
+// or "error <MESSAGE>\n".
+namespace grandrounds {
+
+class server_error : public std::runtime_error {
+   public:
+    explicit server_error(const std::string& msg) : std::runtime_error{msg} {}
+};
+
+struct server_options {
+    std::filesystem::path socket_path;
+    unsigned int threads{0};  // Event loops; zero means one per hardware thread
+    std::size_t cache_bytes{64UL * 1024 * 1024};
+    term_coords frame_size{100, 40};  // Until a session asks for another
+};
+
+// Listens on construction, replacing a stale socket file if there is one.
+// Each event loop thread has its own epoll instance and keeps the sessions it
+// accepts, so sessions never move between threads or share locks other than
+// the puzzle cache's.  Puzzles are loaded on a pool of worker threads, so a
+// slow load holds up only the session waiting for it.
+class puzzle_server {
+   public:
+    explicit puzzle_server(server_options options);
+    ~puzzle_server();
+
+    puzzle_server(const puzzle_server&) = delete;
+    puzzle_server& operator=(const puzzle_server&) = delete;
+    puzzle_server(puzzle_server&&) = delete;
+    puzzle_server& operator=(puzzle_server&&) = delete;
+
+    // Serve until stop() is called, using the calling thread as one of the
+    // event loops.  Sessions still open are closed when it returns.  If any
+    // loop fails, every loop stops and the error is rethrown here.
+    void run();
+
+    // Safe to call from any thread, including a signal-handling one.
+    void stop() noexcept;
+
+    [[nodiscard]] const std::filesystem::path& socket_path() const noexcept
+    {
+        return options_.socket_path;
+    }
+
+   private:
+    void event_loop();
+    // The board shared by everyone playing this puzzle co-operatively.
+    std::shared_ptr<shared_board> join(std::string_view name,
+                                       const nonogram_puzzle& puzzle);
+
+    server_options options_;
+    puzzle_cache puzzles_;
+    std::mutex boards_mutex_;
+    // Dropped when the last session playing on them closes.
+    std::map<std::string, std::weak_ptr<shared_board>, std::less<>>
+        boards_;  // Guarded by boards_mutex_
+    int listen_fd_{-1};
+    int stop_fd_{-1};  // eventfd that wakes every loop
+    // Last, so that loads still running finish before the cache and boards
+    // they use are destroyed.
+    task_pool loaders_;
+};
+
+// Run a server until SIGINT or SIGTERM.
+void serve_puzzles(const server_options& options);
+
+// A blocking connection to a puzzle_server, for tools and tests.
+class puzzle_client {
+   public:
+    explicit puzzle_client(const std::filesystem::path& socket_path);
+    ~puzzle_client();
+
+    puzzle_client(const puzzle_client&) = delete;
+    puzzle_client& operator=(const puzzle_client&) = delete;
+    puzzle_client(puzzle_client&&) = delete;
+    puzzle_client& operator=(puzzle_client&&) = delete;
+
+    // Send one request line, without its newline.
+    void send(std::string_view request);
+
+    // The next response's frame.  Throws server_error for an error response.
+    std::string receive();
+
+    std::string request(std::string_view request)
+    {
+        send(request);
+        return receive();
+    }
+
+   private:
+    std::string read_line();
+    void read_more();
+
+    int fd_{-1};
+    std::string buffer_;
+};
+
+}  // namespace grandrounds
+
+#endif  // SERVER_HPP
@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "shared_board.hpp"
+
+#include <gsl/assert>
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+constexpr std::uint64_t low_bits{0x5555'5555'5555'5555};
+
+std::uint64_t cell_bits(board_cell cell) noexcept
+{
+    return static_cast<std::uint64_t>(cell);
+}
+
+}  // namespace
+
+shared_board::shared_board(std::span<const board_cell> solution)
+    : size_{solution.size()},
+      word_count_{(solution.size() + cells_per_word - 1) / cells_per_word},
+      solution_(word_count_),
+      words_{std::make_unique<std::atomic<std::uint64_t>[]>(word_count_)}
+{
+    std::ptrdiff_t filled_cells{0};
+    for (std::size_t i{0}; i < size_; i++) {
+        if (solution[i] > board_cell::marked) {
+            throw std::invalid_argument{
+                "Colour puzzles can't be played together"};
+        }
+        if (solution[i] == board_cell::filled) {
+            solution_[i / cells_per_word] |= std::uint64_t{1}
+                                             << (i % cells_per_word * 2);
+            filled_cells++;
+        }
+    }
+    // The board starts clear, so every filled cell is wrong.
+    mismatches_.store(filled_cells, std::memory_order_relaxed);
+}
+
+std::uint64_t shared_board::filled_bits(std::uint64_t word) noexcept
+{
+    // Filled is 0b01: the low bit set and the high bit clear.
+    return word & ~(word >> 1) & low_bits;
+}
+
+board_cell shared_board::get(std::size_t index) const noexcept
+{
+    const auto word{words_[index / cells_per_word].load(
+        std::memory_order_acquire)};
+    return static_cast<board_cell>(
+        (word >> (index % cells_per_word * 2)) & cell_mask);
+}
+
+board_cell shared_board::set(std::size_t index, board_cell cell) noexcept
+{
+    // A colour cell would spill into its neighbour's two bits.
+    Expects(cell <= board_cell::marked);
+    auto& word{words_[index / cells_per_word]};
+    const auto shift{index % cells_per_word * 2};
+    auto old_word{word.load(std::memory_order_relaxed)};
+    std::uint64_t new_word{0};
+    do {
+        new_word =
+            (old_word & ~(cell_mask << shift)) | (cell_bits(cell) << shift);
+        if (new_word == old_word) {
+            return cell;
+        }
+    } while (!word.compare_exchange_weak(old_word, new_word,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_relaxed));
+
+    // The exchange decides which write came first, so the count moves by the
+    // difference this write made to the cell.
+    const auto wanted{(solution_[index / cells_per_word] >> shift) & 1U};
+    const bool was_right{((filled_bits(old_word) >> shift) & 1U) == wanted};
+    const bool is_right{((filled_bits(new_word) >> shift) & 1U) == wanted};
+    if (was_right != is_right) {
+        mismatches_.fetch_add(was_right ? 1 : -1, std::memory_order_acq_rel);
+    }
+    version_.fetch_add(1, std::memory_order_release);
+    return static_cast<board_cell>((old_word >> shift) & cell_mask);
+}
+
+void shared_board::assign(std::span<const board_cell> cells) noexcept
+{
+    for (std::size_t i{0}; i < std::min(size_, cells.size()); i++) {
+        set(i, cells[i]);
+    }
+}
+
+std::size_t shared_board::mismatches() const noexcept
+{
+    return static_cast<std::size_t>(std::max(
+        std::ptrdiff_t{0}, mismatches_.load(std::memory_order_acquire)));
+}
+
+bool shared_board::solved() const noexcept
+{
+    if (mismatches_.load(std::memory_order_acquire) > 0) {
+        return false;
+    }
+    for (std::size_t i{0}; i < word_count_; i++) {
+        if (filled_bits(words_[i].load(std::memory_order_acquire)) !=
+            solution_[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<board_cell> shared_board::snapshot() const
+{
+    std::vector<board_cell> out;
+    out.reserve(size_);
+    for (std::size_t i{0}; i < size_; i++) {
+        out.push_back(get(i));
+    }
+    return out;
+}
+
+shared_board::viewer::viewer(std::shared_ptr<const shared_board> board)
+    : board_{std::move(board)}, seen_(board_->word_count_)
+{
+}
+
+std::vector<shared_board::change> shared_board::viewer::changes()
+{
+    std::vector<change> out;
+    // Read before the words: a write this scan misses bumps the version
+    // after this load, so the next call scans again.
+    const auto version{board_->version()};
+    if (version == seen_version_) {
+        return out;
+    }
+    for (std::size_t w{0}; w < seen_.size(); w++) {
+        const auto word{board_->words_[w].load(std::memory_order_acquire)};
+        // One bit per cell, at the low bit of the cell's pair.
+        const auto diff{word ^ seen_[w]};
+        for (auto changed{(diff | (diff >> 1)) & low_bits}; changed != 0;
+             changed &= changed - 1) {
+            const auto shift{
+                static_cast<std::size_t>(std::countr_zero(changed))};
+            out.push_back(
+                {w * cells_per_word + shift / 2,
+                 static_cast<board_cell>((word >> shift) & cell_mask)});
+        }
+        seen_[w] = word;
+    }
+    seen_version_ = version;
+    return out;
+}
+
+}  // namespace grandrounds
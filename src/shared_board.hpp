@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef SHARED_BOARD_HPP
+#define SHARED_BOARD_HPP
+
+#include "nonogram.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace grandrounds {
+
+// A board that several players edit at once, for co-operative play.  Cells
+// are packed two bits apiece into atomic words and written with
+// compare-and-swap, so writers never block each other or the readers.  A
+// count of the cells that disagree with the solution is kept alongside, so an
+// unsolved board is recognised without scanning it.
+//
+// Writes to different cells never interfere.  Concurrent writes to the same
+// cell are ordered, and the last one wins as it would on a single player's
+// board.
+class shared_board {
+   public:
+    // Two bits a cell leave no room for colours, so a colour puzzle's
+    // solution throws std::invalid_argument.
+    explicit shared_board(std::span<const board_cell> solution);
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+    [[nodiscard]] board_cell get(std::size_t index) const noexcept;
+
+    // Returns the cell's previous state.  The cell must be clear, filled or
+    // marked; anything else is a contract violation.
+    board_cell set(std::size_t index, board_cell cell) noexcept;
+
+    // Set every cell, one at a time; players writing meanwhile may still
+    // change cells after this has passed them.
+    void assign(std::span<const board_cell> cells) noexcept;
+
+    // Cells whose filled state differs from the solution.  Marked cells count
+    // as clear, as they do for check_solution().  Exact once writers are
+    // quiet; while they are writing it can be off by the writes in flight.
+    [[nodiscard]] std::size_t mismatches() const noexcept;
+
+    // Agrees with check_solution() on a snapshot().  The count answers
+    // unless it reaches zero, which is confirmed by comparing the board with
+    // the solution, so a count that lags a write never ends the game early.
+    [[nodiscard]] bool solved() const noexcept;
+
+    // Bumped by every write that changes a cell, so that a viewer can tell
+    // cheaply whether there is anything to redraw.
+    [[nodiscard]] std::uint64_t version() const noexcept
+    {
+        return version_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::vector<board_cell> snapshot() const;
+
+    struct change {
+        std::size_t index{0};
+        board_cell cell{board_cell::clear};
+    };
+
+    // One player's view of the board.  Each call to changes() returns the
+    // cells that differ from what the previous call returned (or from a clear
+    // board, the first time), so a frame only needs to redraw those.  A cell
+    // changed several times between frames is reported once, in its latest
+    // state.  A viewer belongs to a single thread.
+    class viewer {
+       public:
+        explicit viewer(std::shared_ptr<const shared_board> board);
+
+        [[nodiscard]] std::vector<change> changes();
+
+       private:
+        std::shared_ptr<const shared_board> board_;
+        std::vector<std::uint64_t> seen_;  // Packed as the board's words are
+        std::uint64_t seen_version_{0};
+    };
+
+   private:
+    static constexpr std::size_t cells_per_word{32};
+    static constexpr std::uint64_t cell_mask{0b11};
+
+    // Bit 2i of a word is set where cell i is filled.
+    [[nodiscard]] static std::uint64_t filled_bits(std::uint64_t word) noexcept;
+
+    std::size_t size_;
+    std::size_t word_count_;
+    std::vector<std::uint64_t> solution_;  // As filled_bits() of each word
+    std::unique_ptr<std::atomic<std::uint64_t>[]> words_;
+    // Signed, since a write that rights a cell can be counted before the one
+    // that wronged it.
+    std::atomic<std::ptrdiff_t> mismatches_{0};
+    std::atomic<std::uint64_t> version_{0};
+};
+
+}  // namespace grandrounds
+
+#endif  // SHARED_BOARD_HPP
@@ -0,0 +1,715 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "solver.hpp"
+#include "color_solver.hpp"
+#include "fixed_board.hpp"
+#include "task_pool.hpp"
+
+#include <gsl/narrow>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace grandrounds {
+
+bool line_solver::solve(std::span<const std::uint8_t> hints,
+                        std::span<solver_cell> line)
+{
+    const std::size_t n{line.size()};
+    const std::size_t k{hints.size()};
+    const std::size_t stride{k + 1};
+
+    // Counting known-empty cells lets "does a block fit here?" be answered in
+    // constant time.
+    empty_prefix_.assign(n + 1, 0);
+    for (std::size_t i{0}; i < n; i++) {
+        empty_prefix_[i + 1] =
+            empty_prefix_[i] + (line[i] == solver_cell::empty ? 1 : 0);
+    }
+    const auto fits{[&](std::size_t start, std::size_t length) {
+        return start + length <= n &&
+               empty_prefix_[start + length] == empty_prefix_[start];
+    }};
+    const auto filled{
+        [&](std::size_t i) { return line[i] == solver_cell::filled; }};
+
+    // suffix_[i * stride + j]: cells [i, n) can hold exactly blocks j..k-1.
+    suffix_.assign((n + 1) * stride, 0);
+    suffix_[n * stride + k] = 1;
+    for (std::size_t i{n}; i-- > 0;) {
+        for (std::size_t j{0}; j <= k; j++) {
+            bool ok{!filled(i) && suffix_[(i + 1) * stride + j] != 0};
+            if (!ok && j < k && fits(i, hints[j])) {
+                const std::size_t end{i + hints[j]};
+                ok = end == n ? j + 1 == k
+                              : !filled(end) &&
+                                    suffix_[(end + 1) * stride + j + 1] != 0;
+            }
+            suffix_[i * stride + j] = ok ? 1 : 0;
+        }
+    }
+    if (suffix_[0] == 0) {
+        return false;
+    }
+
+    // prefix_[i * stride + j]: cells [0, i) can hold exactly blocks 0..j-1.
+    prefix_.assign((n + 1) * stride, 0);
+    prefix_[0] = 1;
+    for (std::size_t i{0}; i < n; i++) {
+        for (std::size_t j{0}; j <= k; j++) {
+            bool ok{!filled(i) && prefix_[i * stride + j] != 0};
+            if (!ok && j > 0 && i + 1 >= hints[j - 1]) {
+                const std::size_t start{i + 1 - hints[j - 1]};
+                if (fits(start, hints[j - 1])) {
+                    ok = start == 0 ? j == 1
+                                    : !filled(start - 1) &&
+                                          prefix_[(start - 1) * stride + j -
+                                                  1] != 0;
+                }
+            }
+            prefix_[(i + 1) * stride + j] = ok ? 1 : 0;
+        }
+    }
+
+    // Every valid placement of every block covers its cells; count coverage
+    // with a difference array so each placement costs O(1).
+    fill_cover_.assign(n + 1, 0);
+    for (std::size_t j{0}; j < k; j++) {
+        const std::size_t length{hints[j]};
+        for (std::size_t start{0}; start + length <= n; start++) {
+            if (!fits(start, length)) {
+                continue;
+            }
+            const std::size_t end{start + length};
+            const bool left_ok{start == 0 ? j == 0
+                                          : !filled(start - 1) &&
+                                                prefix_[(start - 1) * stride +
+                                                        j] != 0};
+            const bool right_ok{end == n ? j + 1 == k
+                                         : !filled(end) &&
+                                               suffix_[(end + 1) * stride + j +
+                                                       1] != 0};
+            if (left_ok && right_ok) {
+                fill_cover_[start]++;
+                fill_cover_[end]--;
+            }
+        }
+    }
+
+    int cover{0};
+    for (std::size_t c{0}; c < n; c++) {
+        cover += fill_cover_[c];
+        if (line[c] != solver_cell::unknown) {
+            continue;
+        }
+        bool can_be_empty{false};
+        for (std::size_t j{0}; j <= k && !can_be_empty; j++) {
+            can_be_empty = prefix_[c * stride + j] != 0 &&
+                           suffix_[(c + 1) * stride + j] != 0;
+        }
+        const bool can_be_filled{cover > 0};
+        if (can_be_filled && !can_be_empty) {
+            line[c] = solver_cell::filled;
+        }
+        else if (can_be_empty && !can_be_filled) {
+            line[c] = solver_cell::empty;
+        }
+    }
+    return true;
+}
+
+int line_slack(const line_hints& hints, int length) noexcept
+{
+    int needed{hints.empty() ? 0 : static_cast<int>(hints.size()) - 1};
+    for (const auto hint : hints) {
+        needed += hint;
+    }
+    return length - needed;
+}
+
+namespace {
+
+using cells_t = std::vector<solver_cell>;
+
+void set_flags(std::vector<std::uint8_t>& flags) noexcept
+{
+    std::fill(flags.begin(), flags.end(), std::uint8_t{1});
+}
+
+void clear_flags(std::vector<std::uint8_t>& flags) noexcept
+{
+    std::fill(flags.begin(), flags.end(), std::uint8_t{0});
+}
+
+bool any_flag(const std::vector<std::uint8_t>& flags) noexcept
+{
+    return std::any_of(flags.begin(), flags.end(),
+                       [](auto flag) { return flag != 0; });
+}
+
+void merge_stats(solver_stats& into, const solver_stats& from)
+{
+    into.nodes += from.nodes;
+    into.line_solves += from.line_solves;
+    into.probes += from.probes;
+    into.probe_deductions += from.probe_deductions;
+    into.propagation_rounds += from.propagation_rounds;
+    into.root_propagation_rounds += from.root_propagation_rounds;
+    into.hardest_line_slack =
+        std::max(into.hardest_line_slack, from.hardest_line_slack);
+    into.max_depth = std::max(into.max_depth, from.max_depth);
+}
+
+// State shared by every thread working on one puzzle.
+struct shared_search {
+    shared_search(board_coords dims,
+                  const std::vector<line_hints>& rows,
+                  const std::vector<line_hints>& cols,
+                  const solver_options& opts)
+        : dimensions{dims},
+          row_hints{rows},
+          col_hints{cols},
+          options{opts},
+          solution_limit{opts.check_uniqueness ? 2U : 1U}
+    {
+        // A line with no hints is all empty however long it is, so it
+        // doesn't count as a loose line.
+        for (const auto& hints : rows) {
+            row_slack.push_back(hints.empty() ? 0 : line_slack(hints, dims.x));
+        }
+        for (const auto& hints : cols) {
+            col_slack.push_back(hints.empty() ? 0 : line_slack(hints, dims.y));
+        }
+    }
+
+    board_coords dimensions;
+    const std::vector<line_hints>& row_hints;
+    const std::vector<line_hints>& col_hints;
+    const solver_options& options;
+    std::size_t solution_limit;
+    std::vector<int> row_slack;
+    std::vector<int> col_slack;
+    task_pool* pool{nullptr};
+
+    // Cells forced at the root, published by whichever probe learned them.
+    std::unique_ptr<std::atomic<solver_cell>[]> learned;  // NOLINT arrays
+    std::atomic<bool> stop{false};
+
+    std::mutex mutex;  // Guards everything below
+    std::vector<std::vector<board_cell>> solutions;
+    solver_stats stats;
+};
+
+// Repeatedly solves rows and columns until nothing more can be deduced,
+// revisiting only the lines that crossed a newly-deduced cell.
+class propagator {
+   public:
+    explicit propagator(const shared_search& shared)
+        : shared_{shared},
+          row_dirty_(gsl::narrow<std::size_t>(shared.dimensions.y), 0),
+          col_dirty_(gsl::narrow<std::size_t>(shared.dimensions.x), 0)
+    {
+    }
+
+    void touch(std::size_t index) noexcept
+    {
+        const auto width{gsl::narrow<std::size_t>(shared_.dimensions.x)};
+        row_dirty_[index / width] = 1;
+        col_dirty_[index % width] = 1;
+    }
+
+    void touch_all() noexcept
+    {
+        set_flags(row_dirty_);
+        set_flags(col_dirty_);
+    }
+
+    // Returns false on contradiction.
+    bool propagate(cells_t& cells)
+    {
+        const auto width{gsl::narrow<std::size_t>(shared_.dimensions.x)};
+        const auto height{gsl::narrow<std::size_t>(shared_.dimensions.y)};
+        while (any_flag(row_dirty_) || any_flag(col_dirty_)) {
+            stats.propagation_rounds++;
+            for (std::size_t y{0}; y < height; y++) {
+                if (row_dirty_[y] == 0) {
+                    continue;
+                }
+                row_dirty_[y] = 0;
+                line_.assign(
+                    cells.begin() + gsl::narrow<long>(y * width),
+                    cells.begin() + gsl::narrow<long>((y + 1) * width));
+                if (!solve_line(shared_.row_hints[y])) {
+                    return false;
+                }
+                bool deduced{false};
+                for (std::size_t x{0}; x < width; x++) {
+                    if (cells[y * width + x] != line_[x]) {
+                        cells[y * width + x] = line_[x];
+                        col_dirty_[x] = 1;
+                        deduced = true;
+                    }
+                }
+                if (deduced) {
+                    note_deduction(shared_.row_slack[y]);
+                }
+            }
+            for (std::size_t x{0}; x < width; x++) {
+                if (col_dirty_[x] == 0) {
+                    continue;
+                }
+                col_dirty_[x] = 0;
+                line_.resize(height);
+                for (std::size_t y{0}; y < height; y++) {
+                    line_[y] = cells[y * width + x];
+                }
+                if (!solve_line(shared_.col_hints[x])) {
+                    return false;
+                }
+                bool deduced{false};
+                for (std::size_t y{0}; y < height; y++) {
+                    if (cells[y * width + x] != line_[y]) {
+                        cells[y * width + x] = line_[y];
+                        row_dirty_[y] = 1;
+                        deduced = true;
+                    }
+                }
+                if (deduced) {
+                    note_deduction(shared_.col_slack[x]);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Set one cell and propagate its consequences.
+    bool assign(cells_t& cells, std::size_t index, solver_cell value)
+    {
+        cells[index] = value;
+        touch(index);
+        return propagate(cells);
+    }
+
+    solver_stats stats;
+    int hardest_slack{0};  // Of any line that yielded a deduction
+
+   private:
+    void note_deduction(int slack) noexcept
+    {
+        hardest_slack = std::max(hardest_slack, slack);
+    }
+
+    bool solve_line(const line_hints& hints)
+    {
+        stats.line_solves++;
+        if (line_solver_.solve(hints, line_)) {
+            return true;
+        }
+        clear_flags(row_dirty_);
+        clear_flags(col_dirty_);
+        return false;
+    }
+
+    const shared_search& shared_;
+    line_solver line_solver_;
+    cells_t line_;
+    std::vector<std::uint8_t> row_dirty_;
+    std::vector<std::uint8_t> col_dirty_;
+};
+
+enum class probe_outcome { nothing, learned, contradiction };
+
+// Try both values of one unknown cell.  If one contradicts, the cell takes the
+// other; if both survive, any cell they agree on is forced regardless.
+probe_outcome probe_cell(propagator& prop,
+                         cells_t& cells,
+                         std::size_t index,
+                         cells_t& as_filled,
+                         cells_t& as_empty)
+{
+    prop.stats.probes++;
+    as_filled = cells;
+    const bool filled_ok{prop.assign(as_filled, index, solver_cell::filled)};
+    as_empty = cells;
+    const bool empty_ok{prop.assign(as_empty, index, solver_cell::empty)};
+
+    if (!filled_ok && !empty_ok) {
+        return probe_outcome::contradiction;
+    }
+    if (!filled_ok || !empty_ok) {
+        auto& survivor{filled_ok ? as_filled : as_empty};
+        prop.stats.probe_deductions += gsl::narrow<std::uint64_t>(
+            std::count(cells.begin(), cells.end(), solver_cell::unknown) -
+            std::count(survivor.begin(), survivor.end(), solver_cell::unknown));
+        cells.swap(survivor);
+        return probe_outcome::learned;
+    }
+
+    std::uint64_t agreed{0};
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        if (cells[i] == solver_cell::unknown && as_filled[i] == as_empty[i] &&
+            as_filled[i] != solver_cell::unknown) {
+            cells[i] = as_filled[i];
+            prop.touch(i);
+            agreed++;
+        }
+    }
+    if (agreed == 0) {
+        return probe_outcome::nothing;
+    }
+    prop.stats.probe_deductions += agreed;
+    return prop.propagate(cells) ? probe_outcome::learned
+                                 : probe_outcome::contradiction;
+}
+
+// Probe every unknown cell until a full pass learns nothing.  Returns false on
+// contradiction.
+bool probe_all(const shared_search& shared, propagator& prop, cells_t& cells)
+{
+    cells_t as_filled;
+    cells_t as_empty;
+    bool progress{true};
+    while (progress && !shared.stop) {
+        progress = false;
+        for (std::size_t i{0}; i < cells.size(); i++) {
+            if (cells[i] != solver_cell::unknown) {
+                continue;
+            }
+            const auto outcome{probe_cell(prop, cells, i, as_filled, as_empty)};
+            if (outcome == probe_outcome::contradiction) {
+                return false;
+            }
+            progress = progress || outcome == probe_outcome::learned;
+        }
+    }
+    return true;
+}
+
+// Pull any root facts other threads have published into `cells`.  Returns
+// false on contradiction.
+bool pull_learned(const shared_search& shared, propagator& prop, cells_t& cells)
+{
+    bool changed{false};
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        const auto known{shared.learned[i].load(std::memory_order_relaxed)};
+        if (known == solver_cell::unknown || cells[i] == known) {
+            continue;
+        }
+        if (cells[i] != solver_cell::unknown) {
+            return false;
+        }
+        cells[i] = known;
+        prop.touch(i);
+        changed = true;
+    }
+    return !changed || prop.propagate(cells);
+}
+
+// Publish everything `cells` knows as root facts.  Returns false if another
+// thread already published the opposite value for some cell.
+bool publish_learned(shared_search& shared, const cells_t& cells)
+{
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        if (cells[i] == solver_cell::unknown) {
+            continue;
+        }
+        auto expected{solver_cell::unknown};
+        if (!shared.learned[i].compare_exchange_strong(expected, cells[i]) &&
+            expected != cells[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Root-level probing, split across the pool.  Each task probes a slice of the
+// unknown cells, starting from (and regularly refreshing with) the facts other
+// tasks have already published.
+bool parallel_probe(shared_search& shared, cells_t& cells)
+{
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        shared.learned[i].store(cells[i]);
+    }
+
+    std::atomic<bool> progress{true};
+    std::atomic<bool> contradiction{false};
+    while (progress && !contradiction) {
+        progress = false;
+        std::vector<std::size_t> unknown;
+        for (std::size_t i{0}; i < cells.size(); i++) {
+            if (shared.learned[i].load() == solver_cell::unknown) {
+                unknown.push_back(i);
+            }
+        }
+        const std::size_t slices{std::size_t{shared.pool->size()} * 4};
+        const std::size_t slice_size{
+            std::max<std::size_t>(1, (unknown.size() + slices - 1) / slices)};
+        for (std::size_t begin{0}; begin < unknown.size();
+             begin += slice_size) {
+            const std::size_t end{std::min(unknown.size(), begin + slice_size)};
+            shared.pool->submit([&, begin, end] {
+                propagator prop{shared};
+                cells_t local(cells.size(), solver_cell::unknown);
+                cells_t as_filled;
+                cells_t as_empty;
+                for (std::size_t u{begin}; u < end && !contradiction; u++) {
+                    const std::size_t index{unknown[u]};
+                    if (!pull_learned(shared, prop, local)) {
+                        contradiction = true;
+                        break;
+                    }
+                    if (local[index] != solver_cell::unknown) {
+                        continue;
+                    }
+                    const auto outcome{
+                        probe_cell(prop, local, index, as_filled, as_empty)};
+                    if (outcome == probe_outcome::contradiction ||
+                        (outcome == probe_outcome::learned &&
+                         !publish_learned(shared, local))) {
+                        contradiction = true;
+                    }
+                    else if (outcome == probe_outcome::learned) {
+                        progress = true;
+                    }
+                }
+                const std::scoped_lock lock{shared.mutex};
+                merge_stats(shared.stats, prop.stats);
+            });
+        }
+        shared.pool->wait();
+    }
+
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        cells[i] = shared.learned[i].load();
+    }
+    return !contradiction;
+}
+
+// Branch on the first unknown cell of the most nearly complete line, which
+// tends to produce the most deductions per branch.
+std::optional<std::size_t> choose_branch_cell(board_coords dims,
+                                              const cells_t& cells)
+{
+    const auto width{gsl::narrow<std::size_t>(dims.x)};
+    const auto height{gsl::narrow<std::size_t>(dims.y)};
+    std::size_t best_count{width + height + 1};
+    std::optional<std::size_t> best;
+    for (std::size_t y{0}; y < height; y++) {
+        std::size_t count{0};
+        std::optional<std::size_t> first;
+        for (std::size_t x{0}; x < width; x++) {
+            if (cells[y * width + x] == solver_cell::unknown) {
+                count++;
+                first = first.value_or(y * width + x);
+            }
+        }
+        if (count > 0 && count < best_count) {
+            best_count = count;
+            best = first;
+        }
+    }
+    for (std::size_t x{0}; x < width; x++) {
+        std::size_t count{0};
+        std::optional<std::size_t> first;
+        for (std::size_t y{0}; y < height; y++) {
+            if (cells[y * width + x] == solver_cell::unknown) {
+                count++;
+                first = first.value_or(y * width + x);
+            }
+        }
+        if (count > 0 && count < best_count) {
+            best_count = count;
+            best = first;
+        }
+    }
+    return best;
+}
+
+void record_solution(shared_search& shared, const cells_t& cells)
+{
+    std::vector<board_cell> solution(cells.size());
+    std::transform(cells.begin(), cells.end(), solution.begin(), [](auto c) {
+        return c == solver_cell::filled ? board_cell::filled
+                                        : board_cell::clear;
+    });
+    const std::scoped_lock lock{shared.mutex};
+    if (shared.solutions.size() < shared.solution_limit) {
+        shared.solutions.push_back(std::move(solution));
+    }
+    if (shared.solutions.size() >= shared.solution_limit) {
+        shared.stop = true;
+    }
+}
+
+void search(shared_search& shared, propagator& prop, cells_t cells, int depth);
+
+// Entry point for a branch handed to another thread: the branch cell has been
+// set but not yet propagated.
+void search_branch(shared_search& shared,
+                   cells_t cells,
+                   std::size_t index,
+                   int depth)
+{
+    propagator prop{shared};
+    prop.touch(index);
+    if (!shared.stop && prop.propagate(cells)) {
+        search(shared, prop, std::move(cells), depth);
+    }
+    const std::scoped_lock lock{shared.mutex};
+    merge_stats(shared.stats, prop.stats);
+}
+
+// Depth-first search over propagated states.  The second branch of each node
+// is offered to the pool while workers are idle, and explored inline
+// otherwise.
+void search(shared_search& shared, propagator& prop, cells_t cells, int depth)
+{
+    if (shared.stop) {
+        return;
+    }
+    prop.stats.nodes++;
+    prop.stats.max_depth = std::max(prop.stats.max_depth, depth);
+    if (depth > 0 && shared.options.probing &&
+        !probe_all(shared, prop, cells)) {
+        return;
+    }
+
+    const auto branch{choose_branch_cell(shared.dimensions, cells)};
+    if (!branch) {
+        record_solution(shared, cells);
+        return;
+    }
+
+    cells_t other{cells};
+    other[*branch] = solver_cell::empty;
+    const bool split{shared.pool != nullptr &&
+                     depth < shared.options.split_depth &&
+                     shared.pool->has_idle_workers()};
+    if (split) {
+        shared.pool->submit(
+            [&shared, other = std::move(other), index = *branch,
+             depth]() mutable {
+                search_branch(shared, std::move(other), index, depth + 1);
+            });
+    }
+
+    if (prop.assign(cells, *branch, solver_cell::filled)) {
+        search(shared, prop, std::move(cells), depth + 1);
+    }
+    if (!split && !shared.stop &&
+        prop.assign(other, *branch, solver_cell::empty)) {
+        search(shared, prop, std::move(other), depth + 1);
+    }
+}
+
+// Line propagation from the empty board.  The common sizes go through a
+// fixed_board, whose bit-mask lines solve several times faster.
+bool propagate_root(const shared_search& shared,
+                    propagator& prop,
+                    cells_t& cells)
+{
+    propagation_trace trace;
+    const auto fixed{propagate_fixed_size_lines(
+        shared.dimensions, shared.row_hints, shared.col_hints, cells, trace)};
+    if (!fixed) {
+        prop.touch_all();
+        const bool out{prop.propagate(cells)};
+        prop.stats.root_propagation_rounds = prop.stats.propagation_rounds;
+        prop.stats.hardest_line_slack = prop.hardest_slack;
+        return out;
+    }
+
+    prop.stats.propagation_rounds += trace.rounds;
+    prop.stats.root_propagation_rounds = trace.rounds;
+    prop.stats.line_solves += trace.line_solves;
+    const auto note_lines{[&](std::uint64_t deduced,
+                              const std::vector<int>& slack) {
+        for (std::size_t i{0}; i < slack.size(); i++) {
+            if (((deduced >> i) & 1U) != 0) {
+                prop.hardest_slack = std::max(prop.hardest_slack, slack[i]);
+            }
+        }
+    }};
+    note_lines(trace.deduced_rows, shared.row_slack);
+    note_lines(trace.deduced_cols, shared.col_slack);
+    prop.stats.hardest_line_slack = prop.hardest_slack;
+    return *fixed;
+}
+
+}  // namespace
+
+solve_result solve_nonogram(board_coords dimensions,
+                            const std::vector<line_hints>& row_hints,
+                            const std::vector<line_hints>& col_hints,
+                            const solver_options& options)
+{
+    if (dimensions.x <= 0 || dimensions.y <= 0 ||
+        row_hints.size() != gsl::narrow<std::size_t>(dimensions.y) ||
+        col_hints.size() != gsl::narrow<std::size_t>(dimensions.x)) {
+        throw std::invalid_argument{"Hints do not match puzzle dimensions"};
+    }
+
+    const std::size_t cell_count{gsl::narrow<std::size_t>(dimensions.x) *
+                                 gsl::narrow<std::size_t>(dimensions.y)};
+    shared_search shared{dimensions, row_hints, col_hints, options};
+    shared.learned =
+        std::make_unique<std::atomic<solver_cell>[]>(cell_count);  // NOLINT
+
+    std::optional<task_pool> pool;
+    if (options.threads != 1) {
+        pool.emplace(options.threads);
+        shared.pool = &*pool;
+    }
+
+    cells_t cells(cell_count, solver_cell::unknown);
+    propagator prop{shared};
+    bool consistent{propagate_root(shared, prop, cells)};
+    if (consistent && options.probing) {
+        consistent = shared.pool != nullptr ? parallel_probe(shared, cells)
+                                            : probe_all(shared, prop, cells);
+    }
+    if (consistent) {
+        search(shared, prop, std::move(cells), 0);
+    }
+    if (shared.pool != nullptr) {
+        shared.pool->wait();
+    }
+    merge_stats(shared.stats, prop.stats);
+
+    solve_result out;
+    out.solutions = std::move(shared.solutions);
+    out.stats = shared.stats;
+    if (out.solutions.empty()) {
+        out.status = solve_status::contradiction;
+    }
+    else if (out.solutions.size() > 1) {
+        out.status = solve_status::multiple;
+    }
+    else {
+        out.status = options.check_uniqueness ? solve_status::unique
+                                              : solve_status::solved;
+    }
+    return out;
+}
+
+solve_result solve_nonogram(const nonogram_puzzle& puzzle,
+                            const solver_options& options)
+{
+    if (puzzle.is_colored()) {
+        return solve_colored_nonogram(puzzle, options);
+    }
+    return solve_nonogram(puzzle.dimensions, puzzle.row_hints,
+                          puzzle.col_hints, options);
+}
+
+}  // namespace grandrounds
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef SOLVER_HPP
+#define SOLVER_HPP
+
+#include "nonogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace grandrounds {
+
+using line_hints = std::vector<std::uint8_t>;
+
+// What the solver knows about a cell.  Unlike board_cell, "empty" here is a
+// deduction rather than the absence of a player's mark.
+enum class solver_cell : std::uint8_t { unknown, empty, filled };
+
+// Finds every cell of a single row or column that is forced by its hints,
+// given the cells already known.  The scratch buffers are kept between calls
+// so that solving many lines doesn't allocate.
+class line_solver {
+   public:
+    // Narrow the unknown cells of `line` in place.  Returns false if no
+    // placement of the hints is consistent with the known cells, in which case
+    // `line` is left unmodified.
+    bool solve(std::span<const std::uint8_t> hints,
+               std::span<solver_cell> line);
+
+   private:
+    std::vector<std::size_t> empty_prefix_;
+    std::vector<std::uint8_t> prefix_;
+    std::vector<std::uint8_t> suffix_;
+    std::vector<int> fill_cover_;
+};
+
+struct solver_options {
+    bool probing{true};           // Probe cells when propagation stalls
+    bool check_uniqueness{true};  // Keep searching for a second solution
+    unsigned int threads{1};      // Zero means one per hardware thread
+    int split_depth{24};  // Deepest search level that can hand off branches
+};
+
+struct solver_stats {
+    std::uint64_t nodes{0};         // Search nodes visited, including the root
+    std::uint64_t line_solves{0};   // Individual row/column deductions
+    std::uint64_t probes{0};        // Cells tentatively set and propagated
+    std::uint64_t probe_deductions{0};  // Cells learned from probing
+    std::uint64_t propagation_rounds{0};
+    // Rounds of line propagation from the empty board before it stalled (or
+    // solved the puzzle).
+    std::uint64_t root_propagation_rounds{0};
+    // The largest slack (line length minus the minimum length of its hints)
+    // of any line that yielded a deduction during those rounds.  Overlap
+    // deductions on tight lines are easy to spot; deductions on loose lines
+    // need more reasoning.
+    int hardest_line_slack{0};
+    int max_depth{0};  // Deepest branch point reached
+};
+
+// A line's length minus the fewest cells its hints can occupy.
+[[nodiscard]] int line_slack(const line_hints& hints, int length) noexcept;
+
+enum class solve_status {
+    contradiction,  // No solution exists
+    solved,         // A solution was found; uniqueness was not checked
+    unique,         // Exactly one solution exists
+    multiple        // At least two solutions exist
+};
+
+struct solve_result {
+    solve_status status{solve_status::contradiction};
+    // Up to two solutions, using board_cell::filled and board_cell::clear,
+    // or filled_cell() of each colour for a colour puzzle.
+    std::vector<std::vector<board_cell>> solutions;
+    solver_stats stats;
+};
+
+// Solve a nonogram from its hints by line propagation, then probing, then
+// branching when both stall.  With more than one thread, root-level probes and
+// search branches are spread across a work-stealing pool; probes publish the
+// cells they force so other threads can use them, and outstanding branches
+// are abandoned once the requested number of solutions has been found.
+solve_result solve_nonogram(board_coords dimensions,
+                            const std::vector<line_hints>& row_hints,
+                            const std::vector<line_hints>& col_hints,
+                            const solver_options& options = {});
+
+// A colour puzzle goes to solve_colored_nonogram() instead.
+solve_result solve_nonogram(const nonogram_puzzle& puzzle,
+                            const solver_options& options = {});
+
+}  // namespace grandrounds
+
+#endif  // SOLVER_HPP
@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "task_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace grandrounds {
+
+namespace {
+
+// Identifies the pool and deque owned by the current thread, if it is a worker.
+thread_local const task_pool* current_pool{nullptr};
+thread_local std::size_t current_queue{0};
+
+}  // namespace
+
+task_pool::task_pool(unsigned int threads)
+{
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i{0}; i < threads; i++) {
+        queues_.push_back(std::make_unique<worker_queue>());
+    }
+    for (std::size_t i{0}; i < threads; i++) {
+        workers_.emplace_back(
+            [this, i](const std::stop_token& stop) { worker_loop(stop, i); });
+    }
+}
+
+task_pool::~task_pool()
+{
+    for (auto& worker : workers_) {
+        worker.request_stop();
+    }
+    wake_.notify_all();
+    // The jthreads join as they are destroyed, before the queues and
+    // condition variable they use.
+}
+
+void task_pool::submit(task t)
+{
+    const std::size_t index{current_pool == this
+                                ? current_queue
+                                : next_queue_++ % queues_.size()};
+    pending_++;
+    {
+        const std::scoped_lock lock{queues_[index]->mutex};
+        queues_[index]->tasks.push_back(std::move(t));
+        queued_++;
+    }
+    {
+        // Taking the lock orders this notify after a sleeping worker's
+        // predicate check, so the wake-up cannot be lost.
+        const std::scoped_lock lock{wake_mutex_};
+    }
+    wake_.notify_one();
+}
+
+void task_pool::wait()
+{
+    const std::size_t home{current_pool == this ? current_queue : 0};
+    while (pending_ > 0) {
+        if (!try_run_one(home)) {
+            std::unique_lock lock{wake_mutex_};
+            wake_.wait(lock, [&] { return pending_ == 0 || queued_ > 0; });
+        }
+    }
+
+    std::exception_ptr error;
+    {
+        const std::scoped_lock lock{error_mutex_};
+        std::swap(error, error_);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool task_pool::has_idle_workers() const noexcept
+{
+    return idle_ > 0;
+}
+
+unsigned int task_pool::size() const noexcept
+{
+    return static_cast<unsigned int>(workers_.size());
+}
+
+bool task_pool::try_run_one(std::size_t home)
+{
+    task t;
+    if (pop_local(home, t) || steal(home, t)) {
+        run(t);
+        return true;
+    }
+    return false;
+}
+
+bool task_pool::pop_local(std::size_t home, task& out)
+{
+    if (current_pool != this) {
+        // Outside threads only ever steal.
+        return false;
+    }
+    auto& queue{*queues_[home]};
+    const std::scoped_lock lock{queue.mutex};
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    out = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    queued_--;
+    return true;
+}
+
+bool task_pool::steal(std::size_t thief, task& out)
+{
+    const std::size_t count{queues_.size()};
+    for (std::size_t i{1}; i <= count; i++) {
+        auto& queue{*queues_[(thief + i) % count]};
+        const std::scoped_lock lock{queue.mutex};
+        if (!queue.tasks.empty()) {
+            out = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void task_pool::run(task& t) noexcept
+{
+    try {
+        t();
+    }
+    catch (...) {
+        const std::scoped_lock lock{error_mutex_};
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+    if (--pending_ == 0) {
+        const std::scoped_lock lock{wake_mutex_};
+        wake_.notify_all();
+    }
+}
+
+void task_pool::worker_loop(const std::stop_token& stop, std::size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+    while (!stop.stop_requested()) {
+        if (try_run_one(index)) {
+            continue;
+        }
+        idle_++;
+        {
+            std::unique_lock lock{wake_mutex_};
+            wake_.wait(lock, stop, [&] { return queued_ > 0; });
+        }
+        idle_--;
+    }
+}
+
+}  // namespace grandrounds
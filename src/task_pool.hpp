@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace grandrounds {
+
+// A fixed-size pool of worker threads with one task deque per worker.  A
+// worker pushes and pops its own tasks at the back of its deque (so recursive
+// work stays depth-first and cache-warm) and, when it runs dry, steals from
+// the front of the other workers' deques (so thieves take the oldest, and
+// usually largest, pieces of work).
+class task_pool {
+   public:
+    using task = std::function<void()>;
+
+    // A thread count of zero means one worker per hardware thread.
+    explicit task_pool(unsigned int threads = 0);
+    ~task_pool();
+
+    task_pool(const task_pool&) = delete;
+    task_pool& operator=(const task_pool&) = delete;
+    task_pool(task_pool&&) = delete;
+    task_pool& operator=(task_pool&&) = delete;
+
+    // Queue a task.  Called from a worker, the task goes on that worker's own
+    // deque; called from any other thread, tasks are dealt out round-robin.
+    void submit(task t);
+
+    // Run queued tasks on the calling thread until every submitted task has
+    // finished, then rethrow the first exception any task threw.
+    void wait();
+
+    // True when at least one worker is waiting for work, which recursive
+    // algorithms use to decide whether splitting off a subtask is worthwhile.
+    [[nodiscard]] bool has_idle_workers() const noexcept;
+
+    [[nodiscard]] unsigned int size() const noexcept;
+
+   private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    [[nodiscard]] bool try_run_one(std::size_t home);
+    [[nodiscard]] bool pop_local(std::size_t home, task& out);
+    [[nodiscard]] bool steal(std::size_t thief, task& out);
+    void run(task& t) noexcept;
+    void worker_loop(const std::stop_token& stop, std::size_t index);
+
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::atomic<std::size_t> pending_{0};  // Submitted but not yet finished
+    std::atomic<std::size_t> queued_{0};   // Sitting in a deque
+    std::atomic<std::size_t> next_queue_{0};
+    std::atomic<unsigned int> idle_{0};
+    std::mutex wake_mutex_;
+    std::condition_variable_any wake_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+    std::vector<std::jthread> workers_;  // Last, so they stop before the rest
+                                         // is destroyed
+};
+
+}  // namespace grandrounds
+
+#endif  // TASK_POOL_HPP
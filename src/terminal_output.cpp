@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "terminal_output.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+namespace grandrounds {
+
+namespace {
+
+std::atomic<render_options> current_options{render_options{}};
+
+// xterm's defaults for the 16 basic colours, in ftxui's Palette16 order.
+constexpr std::array<color, 16> ansi_colors{{{0, 0, 0},
+                                             {205, 0, 0},
+                                             {0, 205, 0},
+                                             {205, 205, 0},
+                                             {0, 0, 238},
+                                             {205, 0, 205},
+                                             {0, 205, 205},
+                                             {229, 229, 229},
+                                             {127, 127, 127},
+                                             {255, 0, 0},
+                                             {0, 255, 0},
+                                             {255, 255, 0},
+                                             {92, 92, 255},
+                                             {255, 0, 255},
+                                             {0, 255, 255},
+                                             {255, 255, 255}}};
+
+std::uint8_t nearest_ansi_index(color c) noexcept
+{
+    std::uint8_t best{0};
+    for (std::uint8_t i{1}; i < ansi_colors.size(); i++) {
+        if (color_distance(c, ansi_colors[i]) <
+            color_distance(c, ansi_colors[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+render_options current_render_options() noexcept
+{
+    return current_options.load(std::memory_order_relaxed);
+}
+
+void set_render_options(render_options options) noexcept
+{
+    current_options.store(options, std::memory_order_relaxed);
+}
+
+palette parse_palette(std::string_view name)
+{
+    if (name == "true") {
+        return palette::true_color;
+    }
+    if (name == "256") {
+        return palette::xterm256;
+    }
+    if (name == "16") {
+        return palette::ansi16;
+    }
+    throw std::invalid_argument{"Colours must be true, 256 or 16"};
+}
+
+ftxui::Color terminal_color(color c, palette colors)
+{
+    switch (colors) {
+        case palette::xterm256:
+            return ftxui::Color{
+                static_cast<ftxui::Color::Palette256>(nearest_xterm_index(c))};
+        case palette::ansi16:
+            return ftxui::Color{
+                static_cast<ftxui::Color::Palette16>(nearest_ansi_index(c))};
+        default:
+            return ftxui::Color{c.r, c.g, c.b};
+    }
+}
+
+frame_meter::frame_meter(std::ostream& stream, bool skip_unchanged)
+    : stream_{stream}, target_{stream.rdbuf()}, skip_unchanged_{skip_unchanged}
+{
+    stream_.rdbuf(this);
+}
+
+frame_meter::~frame_meter()
+{
+    sync();
+    stream_.rdbuf(target_);
+}
+
+frame_meter::int_type frame_meter::overflow(int_type ch)
+{
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        frame_ += traits_type::to_char_type(ch);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize frame_meter::xsputn(const char_type* s, std::streamsize count)
+{
+    frame_.append(s, static_cast<std::size_t>(count));
+    return count;
+}
+
+int frame_meter::sync()
+{
+    if (frame_.empty()) {
+        return target_->pubsync();
+    }
+    const bool skip{skip_unchanged_ && frame_ == previous_};
+    stats_.add(frame_.size(), skip);
+    if (!skip) {
+        const auto size{static_cast<std::streamsize>(frame_.size())};
+        if (target_->sputn(frame_.data(), size) != size) {
+            return -1;
+        }
+        previous_.swap(frame_);
+    }
+    frame_.clear();
+    return target_->pubsync();
+}
+
+std::string describe_frames(const frame_stats& stats, double seconds)
+{
+    const auto sent{stats.frames - stats.skipped};
+    auto out{fmt::format(
+        "{} frames ({} unchanged{}), {} bytes, {:.0f} per frame on average "
+        "and {} at most",
+        stats.frames, stats.skipped, stats.skipped > 0 ? " and not sent" : "",
+        stats.bytes,
+        static_cast<double>(stats.bytes) /
+            static_cast<double>(std::max<std::uint64_t>(sent, 1)),
+        stats.max_frame_bytes)};
+    if (seconds > 0) {
+        out += fmt::format(
+            ", {:.1f} kbit/s over {:.1f} s",
+            static_cast<double>(stats.bytes) * 8 / 1000 / seconds, seconds);
+    }
+    return out;
+}
+
+}  // namespace grandrounds
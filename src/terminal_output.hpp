@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2022 David Holmes (dholmes at dholmes dot us)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef TERMINAL_OUTPUT_HPP
+#define TERMINAL_OUTPUT_HPP
+
+#include "compact_image.hpp"
+
+#include <ftxui/screen/color.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+// How much the game writes to the terminal.  ftxui redraws the whole screen
+// on every event, and each colour change costs an escape sequence, so over a
+// slow link the colours chosen and the frames sent matter more than anything
+// drawn.
+namespace grandrounds {
+
+enum class palette : std::uint8_t {
+    true_color,  // 24-bit colour: exact, but about 19 bytes per change
+    xterm256,    // The xterm colour cube and greys: about 11 bytes
+    ansi16,      // The 16 basic colours: about 5 bytes, and fewer changes
+};
+
+// Aligned to four bytes so that it's lock-free in a std::atomic.
+struct alignas(std::uint32_t) render_options {
+    palette colors{palette::true_color};
+    // Board cells are characters in a single style rather than coloured
+    // blocks, so a whole row goes out without a colour change.
+    bool glyph_cells{false};
+    // Frames identical to the one before aren't sent.
+    bool skip_unchanged_frames{false};
+
+    friend bool operator==(const render_options&,
+                           const render_options&) = default;
+};
+
+// For links of well under 1 Mbit/s.
+inline constexpr render_options low_bandwidth{palette::xterm256, true, true};
+
+// The options the game draws with.  Defaults to full colour, with every
+// frame sent.
+[[nodiscard]] render_options current_render_options() noexcept;
+void set_render_options(render_options options) noexcept;
+
+// Parse "true", "256" or "16".  Throws std::invalid_argument otherwise.
+[[nodiscard]] palette parse_palette(std::string_view name);
+
+// The nearest colour in a palette.  ansi16 assumes xterm's default colours,
+// which most themes stay close to.
+[[nodiscard]] ftxui::Color terminal_color(color c, palette colors);
+[[nodiscard]] inline ftxui::Color terminal_color(color c)
+{
+    return terminal_color(c, current_render_options().colors);
+}
+
+struct frame_stats {
+    std::uint64_t frames{0};   // Including any skipped
+    std::uint64_t skipped{0};  // Identical to the frame before
+    std::uint64_t bytes{0};    // Sent, so excluding skipped frames
+    std::uint64_t max_frame_bytes{0};
+
+    void add(std::uint64_t frame_bytes, bool skip) noexcept
+    {
+        frames++;
+        if (skip) {
+            skipped++;
+            return;
+        }
+        bytes += frame_bytes;
+        if (frame_bytes > max_frame_bytes) {
+            max_frame_bytes = frame_bytes;
+        }
+    }
+};
+
+// Sits between a stream and its buffer while it exists, treating each flush
+// as the end of a frame, which is how ftxui writes them.  It counts the bytes
+// of every frame and can drop frames identical to the one before.  That's
+// safe because a frame redraws the screen from where the frame before left
+// the cursor, so a repeat of it changes nothing.
+class frame_meter : private std::streambuf {
+   public:
+    frame_meter(std::ostream& stream, bool skip_unchanged);
+    ~frame_meter() override;
+
+    frame_meter(const frame_meter&) = delete;
+    frame_meter& operator=(const frame_meter&) = delete;
+    frame_meter(frame_meter&&) = delete;
+    frame_meter& operator=(frame_meter&&) = delete;
+
+    [[nodiscard]] const frame_stats& stats() const noexcept { return stats_; }
+
+   private:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+    int sync() override;
+
+    std::ostream& stream_;
+    std::streambuf* target_;
+    bool skip_unchanged_;
+    std::string frame_;
+    std::string previous_;
+    frame_stats stats_;
+};
+
+// One line for instrumentation output, with the bandwidth the frames would
+// need if sent over `seconds`, when that's known.
+[[nodiscard]] std::string describe_frames(const frame_stats& stats,
+                                          double seconds = 0);
+
+}  // namespace grandrounds
+
+#endif  // TERMINAL_OUTPUT_HPP
@@ -5,20 +5,72 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 
+#include "fixed_board.hpp"
+
 #define CATCH_CONFIG_NO_WINDOWS_SEH
 #include <catch2/catch.hpp>
 
-// There are no constexpr functions to test at this time.
+namespace {
 
-//constexpr unsigned int Factorial(unsigned int number)// NOLINT(misc-no-recursion)
-//{
-//  return number <= 1 ? number : Factorial(number - 1) * number;
-//}
-//
-//TEST_CASE("Factorials are computed with constexpr", "[factorial]")
-//{
-//  STATIC_REQUIRE(Factorial(1) == 1);
-//  STATIC_REQUIRE(Factorial(2) == 2);
-//  STATIC_REQUIRE(Factorial(3) == 6);
-//  STATIC_REQUIRE(Factorial(10) == 3628800);
-//}
+using grandrounds::fixed_board;
+using grandrounds::fixed_hints;
+using grandrounds::fixed_line;
+
+// A five by five heart.
+constexpr fixed_board<5, 5> heart{
+    ".#.#."
+    "#####"
+    "#####"
+    ".###."
+    "..#.."};
+
+}  // namespace
+
+TEST_CASE("Fixed boards calculate hints at compile time", "[fixed_board]")
+{
+    STATIC_REQUIRE(grandrounds::fixed_line_hints<5>(0b11011) ==
+                   fixed_hints<5>{2, 2});
+    STATIC_REQUIRE(grandrounds::fixed_line_hints<5>(0).count == 0);
+
+    constexpr auto rows{grandrounds::calculate_fixed_row_hints(heart)};
+    constexpr auto cols{grandrounds::calculate_fixed_col_hints(heart)};
+    STATIC_REQUIRE(rows[0] == fixed_hints<5>{1, 1});
+    STATIC_REQUIRE(rows[4] == fixed_hints<5>{1});
+    STATIC_REQUIRE(cols[0] == fixed_hints<5>{2});
+    STATIC_REQUIRE(cols[2] == fixed_hints<5>{4});
+    STATIC_REQUIRE(grandrounds::check_fixed_solution(heart, rows, cols));
+
+    constexpr auto broken{[] {
+        auto board{heart};
+        board.set(2, 4, grandrounds::solver_cell::empty);
+        return board;
+    }()};
+    STATIC_REQUIRE(!grandrounds::check_fixed_solution(broken, rows, cols));
+}
+
+TEST_CASE("Fixed boards solve lines at compile time", "[fixed_board]")
+{
+    // 3 and 1 in six cells: the first block's middle two cells are forced.
+    constexpr auto overlap{[] {
+        fixed_line<6> line;
+        grandrounds::solve_fixed_line(fixed_hints<6>{3, 1}, line);
+        return line;
+    }()};
+    STATIC_REQUIRE(overlap.filled == 0b000110);
+    STATIC_REQUIRE(overlap.empty == 0);
+
+    constexpr auto contradiction{[] {
+        fixed_line<4> line{0b1001, 0};
+        return grandrounds::solve_fixed_line(fixed_hints<4>{3}, line);
+    }()};
+    STATIC_REQUIRE(!contradiction);
+
+    constexpr auto solved{[] {
+        fixed_board<5, 5> board;
+        const bool consistent{grandrounds::propagate_fixed_lines(
+            board, grandrounds::calculate_fixed_row_hints(heart),
+            grandrounds::calculate_fixed_col_hints(heart))};
+        return consistent && board == heart;
+    }()};
+    STATIC_REQUIRE(solved);
+}
@@ -5,13 +5,47 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 
+#include "alloc_tracker.hpp"
+#include "assistant.hpp"
+#include "cnf.hpp"
+#include "color_solver.hpp"
+#include "compact_image.hpp"
+#include "embedded_assets.hpp"
 #include "file.hpp"
+#include "fixed_board.hpp"
+#include "generator.hpp"
+#include "grid.hpp"
 #include "nonogram.hpp"
+#include "puzzle_cache.hpp"
+#include "puzzle_colors.hpp"
+#include "rating.hpp"
+#include "recording.hpp"
+#include "server.hpp"
+#include "shared_board.hpp"
+#include "solver.hpp"
+#include "terminal_output.hpp"
 
+#include <fmt/format.h>
 #include <gsl/narrow>
+#include <gsl/util>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 
 #define CATCH_CONFIG_NO_WINDOWS_SEH
 #include <catch2/catch.hpp>
@@ -39,6 +73,18 @@ TEST_CASE("Parse puzzle data from string", "[nonogram]")
     REQUIRE(data.license == "Public Domain");
     REQUIRE(data.wikipedia ==
             "https://en.wikipedia.org/wiki/Cottontail_on_the_Trail");
+
+    // Missing fields, fields of the wrong type and invalid JSON all throw the
+    // same exception.
+    for (const auto* bad :
+         {R"({"title": "No other fields"})", R"([1, 2, 3])", R"({"title": )",
+          R"({"title": 7, "description": "", "author": "", "date": "",
+              "license": "", "wikipedia": ""})",
+          R"({"title": "", "description": "", "author": "", "date": "",
+              "license": "", "wikipedia": "", "difficulty": 1e300})"}) {
+        REQUIRE_THROWS_AS(grandrounds::parse_puzzle_data(bad),
+                          grandrounds::json_error);
+    }
 }
 
 // Forward-declare this overload of slurp which is omitted from file.hpp
@@ -67,4 +113,929 @@ laborum.)"};
     REQUIRE(grandrounds::slurp(ss_lorem) == lorem);
     REQUIRE(gsl::narrow<std::size_t>(ss_lorem.tellg()) == std::strlen(lorem));
     REQUIRE(!ss_lorem.fail());
-}
\ No newline at end of file
+}
+
+TEST_CASE("Line solver deduces overlapping blocks", "[solver]")
+{
+    using grandrounds::solver_cell;
+    constexpr auto u{solver_cell::unknown};
+    constexpr auto e{solver_cell::empty};
+    constexpr auto f{solver_cell::filled};
+    grandrounds::line_solver solver;
+
+    // A 4 in a line of 5 must cover the middle three cells.
+    std::vector line{u, u, u, u, u};
+    const std::vector<std::uint8_t> four{4};
+    REQUIRE(solver.solve(four, line));
+    REQUIRE(line == std::vector{u, f, f, f, u});
+
+    // Once the first cell is known to be empty the block is fully placed.
+    line = {e, u, u, u, u};
+    REQUIRE(solver.solve(four, line));
+    REQUIRE(line == std::vector{e, f, f, f, f});
+
+    // Two blocks of 2 cannot fit in 4 cells.
+    line = {u, u, u, u};
+    const std::vector<std::uint8_t> two_twos{2, 2};
+    REQUIRE(!solver.solve(two_twos, line));
+}
+
+TEST_CASE("Solver distinguishes unique and ambiguous puzzles", "[solver]")
+{
+    using grandrounds::board_cell;
+    using grandrounds::solve_status;
+    constexpr auto c{board_cell::clear};
+    constexpr auto f{board_cell::filled};
+
+    // Needs no branching: every line is fully determined by propagation.
+    const grandrounds::solve_result unique{grandrounds::solve_nonogram(
+        {3, 3}, {{3}, {1}, {1, 1}}, {{1, 1}, {2}, {1, 1}})};
+    REQUIRE(unique.status == solve_status::unique);
+    REQUIRE(unique.solutions.size() == 1);
+    REQUIRE(unique.solutions[0] == std::vector{f, f, f, c, f, c, f, c, f});
+
+    // The classic ambiguous diagonal.
+    for (const unsigned int threads : {1U, 4U}) {
+        grandrounds::solver_options options;
+        options.threads = threads;
+        const grandrounds::solve_result ambiguous{grandrounds::solve_nonogram(
+            {2, 2}, {{1}, {1}}, {{1}, {1}}, options)};
+        REQUIRE(ambiguous.status == solve_status::multiple);
+        REQUIRE(ambiguous.solutions.size() == 2);
+    }
+
+    const grandrounds::solve_result impossible{
+        grandrounds::solve_nonogram({2, 2}, {{2}, {}}, {{1}, {}})};
+    REQUIRE(impossible.status == solve_status::contradiction);
+}
+
+TEST_CASE("Rating scores guessing above line propagation", "[rating]")
+{
+    const auto easy{grandrounds::rate_puzzle({3, 3}, {{3}, {1}, {1, 1}},
+                                             {{1, 1}, {2}, {1, 1}})};
+    REQUIRE(!easy.needed_probing);
+    REQUIRE(!easy.needed_branching);
+    REQUIRE(easy.propagation_rounds > 0);
+
+    const auto hard{
+        grandrounds::rate_puzzle({2, 2}, {{1}, {1}}, {{1}, {1}})};
+    REQUIRE(hard.needed_branching);
+    REQUIRE(hard.score > easy.score);
+
+    const auto data{grandrounds::parse_puzzle_data(
+        R"({"title": "", "description": "", "author": "", "date": "",
+            "license": "", "wikipedia": "", "difficulty": 42})")};
+    REQUIRE(data.difficulty == 42);
+
+    // Saving a score rewrites the file in place, keeping it one object.
+    const auto json_path{std::filesystem::temp_directory_path() /
+                         fmt::format("grandrounds-test-{}.json",
+                                     std::random_device{}())};
+    const auto remove_json{
+        gsl::finally([&] { std::filesystem::remove(json_path); })};
+    {
+        std::ofstream out{json_path};
+        out << R"({"title": "Round trip", "description": "", "author": "",
+                   "date": "", "license": "", "wikipedia": ""})";
+    }
+    grandrounds::save_puzzle_difficulty(json_path, 7);
+    const auto loaded{grandrounds::load_puzzle_data(json_path)};
+    REQUIRE(loaded.title == "Round trip");
+    REQUIRE(loaded.difficulty == 7);
+}
+
+TEST_CASE("CNF encoding agrees with the native solver", "[cnf]")
+{
+    using grandrounds::solve_status;
+
+    const auto unique{grandrounds::solve_nonogram_cnf(
+        {3, 3}, {{3}, {1}, {1, 1}}, {{1, 1}, {2}, {1, 1}})};
+    REQUIRE(unique.status == solve_status::unique);
+    REQUIRE(unique.solutions[0] ==
+            grandrounds::solve_nonogram({3, 3}, {{3}, {1}, {1, 1}},
+                                        {{1, 1}, {2}, {1, 1}})
+                .solutions[0]);
+
+    const auto ambiguous{
+        grandrounds::solve_nonogram_cnf({2, 2}, {{1}, {1}}, {{1}, {1}})};
+    REQUIRE(ambiguous.status == solve_status::multiple);
+    REQUIRE(ambiguous.solutions.size() == 2);
+    REQUIRE(ambiguous.solutions[0] != ambiguous.solutions[1]);
+
+    const auto impossible{
+        grandrounds::solve_nonogram_cnf({2, 2}, {{2}, {}}, {{1}, {}})};
+    REQUIRE(impossible.status == solve_status::contradiction);
+
+    // Cell variables come first, so a DIMACS header always covers them.
+    const auto encoded{
+        grandrounds::encode_nonogram({2, 2}, {{1}, {1}}, {{1}, {1}})};
+    std::stringstream dimacs;
+    grandrounds::write_dimacs(dimacs, encoded.formula);
+    REQUIRE(dimacs.str().starts_with(
+        fmt::format("p cnf {} {}\n", encoded.formula.variable_count,
+                    encoded.formula.clauses.size())));
+    REQUIRE(encoded.formula.variable_count >= 4);
+}
+
+TEST_CASE("Generator makes a unique puzzle from a photo", "[generator]")
+{
+    // A dark disc on a light, slightly shaded background.
+    grandrounds::loaded_image photo;
+    photo.width = 320;
+    photo.height = 240;
+    for (unsigned int y{0}; y < photo.height; y++) {
+        for (unsigned int x{0}; x < photo.width; x++) {
+            const int dx{gsl::narrow<int>(x) - 160};
+            const int dy{gsl::narrow<int>(y) - 120};
+            const auto value{dx * dx + dy * dy < 90 * 90
+                                 ? std::uint8_t{30}
+                                 : gsl::narrow<std::uint8_t>(180 + x / 8)};
+            photo.rgba_pixel_data.insert(photo.rgba_pixel_data.end(),
+                                         {value, value, value, 255});
+        }
+    }
+
+    const auto square{grandrounds::crop_to_aspect(photo, 1, 1)};
+    REQUIRE(square.width == 240);
+    REQUIRE(square.height == 240);
+
+    // Resampling a flat image must not change its colour.
+    grandrounds::loaded_image flat;
+    flat.width = 9;
+    flat.height = 5;
+    flat.rgba_pixel_data.assign(std::size_t{9 * 5 * 4}, 77);
+    const auto resized{grandrounds::resize_image(flat, 4, 3)};
+    REQUIRE(resized.rgba_pixel_data.size() == std::size_t{4 * 3 * 4});
+    REQUIRE(std::all_of(resized.rgba_pixel_data.begin(),
+                        resized.rgba_pixel_data.end(),
+                        [](auto value) { return value == 77; }));
+
+    grandrounds::generator_options options;
+    options.size = {15, 10};
+    const auto puzzle{grandrounds::generate_puzzle(photo, options)};
+    REQUIRE(puzzle.unique);
+    REQUIRE(puzzle.nonogram.width == 15);
+    REQUIRE(puzzle.nonogram.height == 10);
+    REQUIRE(puzzle.small_photo.width == 30);
+    REQUIRE(puzzle.photo.height == 40);
+    // The middle of the disc is filled and the corners are not.
+    REQUIRE(puzzle.solution[5 * 15 + 7] == grandrounds::board_cell::filled);
+    REQUIRE(puzzle.solution[0] == grandrounds::board_cell::clear);
+
+    // Hints are bytes, so no side may be longer than they can count.
+    options.size = {grandrounds::max_puzzle_side + 1, 10};
+    REQUIRE_THROWS_AS(grandrounds::generate_puzzle(photo, options),
+                      std::invalid_argument);
+}
+
+TEST_CASE("Assistant highlights deducible and conflicting cells", "[assistant]")
+{
+    using grandrounds::assist_hint;
+    using grandrounds::board_cell;
+    constexpr auto c{board_cell::clear};
+    constexpr auto f{board_cell::filled};
+    constexpr auto m{board_cell::marked};
+    constexpr auto fill{assist_hint::filled};
+    constexpr auto empty{assist_hint::empty};
+    constexpr auto conflict{assist_hint::conflict};
+    const std::vector<grandrounds::line_hints> rows{{3}, {1}, {1, 1}};
+    const std::vector<grandrounds::line_hints> cols{{1, 1}, {2}, {1, 1}};
+
+    const auto blank{grandrounds::analyze_board(
+        {3, 3}, rows, cols, std::vector<board_cell>(9, c))};
+    REQUIRE(blank);
+    REQUIRE(blank->cells == std::vector{fill, fill, fill, empty, fill, empty,
+                                        fill, empty, fill});
+
+    // The middle row only has room for one filled cell.
+    const auto wrong{grandrounds::analyze_board(
+        {3, 3}, rows, cols, {f, f, f, f, c, f, c, m, c})};
+    REQUIRE(wrong);
+    REQUIRE(wrong->cells[3] == conflict);
+    REQUIRE(wrong->cells[5] == conflict);
+    REQUIRE(wrong->cells[6] == fill);
+
+    const auto cancelled{grandrounds::analyze_board(
+        {3, 3}, rows, cols, std::vector<board_cell>(9, c),
+        [] { return true; })};
+    REQUIRE(!cancelled);
+
+    std::promise<void> ready;
+    grandrounds::hint_assistant assistant{{3, 3}, rows, cols, [&] {
+                                              ready.set_value();
+                                          }};
+    assistant.analyze(std::vector<board_cell>(9, c));
+    REQUIRE(ready.get_future().wait_for(std::chrono::seconds{5}) ==
+            std::future_status::ready);
+    const auto latest{assistant.latest()};
+    REQUIRE(latest);
+    REQUIRE(latest->generation == assistant.generation());
+    REQUIRE(latest->cells == blank->cells);
+}
+
+TEST_CASE("Embedded puzzles match their solutions", "[embedded]")
+{
+    const auto puzzles{grandrounds::embedded::puzzles()};
+    REQUIRE(!puzzles.empty());
+    REQUIRE(std::is_sorted(puzzles.begin(), puzzles.end(),
+                           [](const auto& a, const auto& b) {
+                               return a.name < b.name;
+                           }));
+    REQUIRE(grandrounds::embedded::title_image().rgba_pixel_data.size() ==
+            std::size_t{4} * grandrounds::embedded::title_image().width *
+                grandrounds::embedded::title_image().height);
+
+    const grandrounds::nonogram_puzzle puzzle{"cottontail"};
+    REQUIRE(puzzle.dimensions.x == 11);
+    REQUIRE(puzzle.dimensions.y == 10);
+    REQUIRE(puzzle.row_hints ==
+            grandrounds::calculate_row_hints(puzzle.solution, 11));
+    REQUIRE(puzzle.col_hints ==
+            grandrounds::calculate_col_hints(puzzle.solution, 11));
+    REQUIRE(puzzle.photo.width() * puzzle.photo.height() > 0);
+    REQUIRE(!puzzle.data.title.empty());
+}
+
+TEST_CASE("Satisfied hints follow each edit", "[nonogram]")
+{
+    const auto puzzle{
+        std::make_shared<grandrounds::nonogram_puzzle>("cottontail")};
+    grandrounds::nonogram_game game{
+        puzzle,
+        std::vector<grandrounds::board_cell>(puzzle->solution.size())};
+    grandrounds::update_satisfied_hints(game);
+    const int width{puzzle->dimensions.x};
+
+    // Compare with recalculating every line's hints from the board, treating
+    // marked cells as clear.
+    const auto check{[&] {
+        std::vector<grandrounds::board_cell> filled;
+        for (const auto cell : game.board) {
+            filled.push_back(cell == grandrounds::board_cell::filled
+                                 ? cell
+                                 : grandrounds::board_cell::clear);
+        }
+        const auto rows{grandrounds::calculate_row_hints(filled, width)};
+        const auto cols{grandrounds::calculate_col_hints(filled, width)};
+        for (std::size_t y{0}; y < rows.size(); y++) {
+            REQUIRE(game.row_satisfied[y] == (rows[y] == puzzle->row_hints[y]));
+        }
+        for (std::size_t x{0}; x < cols.size(); x++) {
+            REQUIRE(game.col_satisfied[x] == (cols[x] == puzzle->col_hints[x]));
+        }
+    }};
+    check();
+
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> x_dist{0, width - 1};
+    std::uniform_int_distribution<int> y_dist{0, puzzle->dimensions.y - 1};
+    std::uniform_int_distribution<int> cell_dist{0, 2};
+    for (int i{0}; i < 300; i++) {
+        const grandrounds::board_coords square{x_dist(rng), y_dist(rng)};
+        const auto index{gsl::narrow<std::size_t>(square.y * width + square.x)};
+        // Lean towards the solution so that lines do become satisfied.
+        const auto cell{i % 2 == 0 ? puzzle->solution[index]
+                                   : static_cast<grandrounds::board_cell>(
+                                         cell_dist(rng))};
+        grandrounds::set_cell(game, square, cell);
+        check();
+    }
+
+    game.board = puzzle->solution;
+    grandrounds::update_satisfied_hints(game);
+    REQUIRE(std::all_of(game.row_satisfied.begin(), game.row_satisfied.end(),
+                        [](bool satisfied) { return satisfied; }));
+    REQUIRE(std::all_of(game.col_satisfied.begin(), game.col_satisfied.end(),
+                        [](bool satisfied) { return satisfied; }));
+}
+
+TEST_CASE("Compact images index few colours exactly", "[image]")
+{
+    using grandrounds::color;
+    using grandrounds::compact_image;
+    using grandrounds::pixel_format;
+
+    // Four colours: indexed without loss even when RGB is asked for.
+    std::vector<std::uint8_t> rgba;
+    const std::array<color, 4> few{
+        {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {12, 34, 56}}};
+    for (std::size_t i{0}; i < 64; i++) {
+        const auto c{few[i % few.size()]};
+        rgba.insert(rgba.end(), {c.r, c.g, c.b, 255});
+    }
+    const auto small{
+        compact_image::from_rgba(rgba, 8, 8, pixel_format::rgb)};
+    REQUIRE(small.format() == pixel_format::indexed);
+    REQUIRE(small.palette().size() == 4);
+    for (std::size_t i{0}; i < 64; i++) {
+        REQUIRE(small.pixel(i % 8, i / 8) == few[i % few.size()]);
+    }
+
+    // Many colours stay exact as RGB, and shrink to one byte a pixel indexed.
+    rgba.clear();
+    for (unsigned int y{0}; y < 32; y++) {
+        for (unsigned int x{0}; x < 32; x++) {
+            rgba.insert(rgba.end(), {static_cast<std::uint8_t>(x * 8),
+                                     static_cast<std::uint8_t>(y * 8),
+                                     static_cast<std::uint8_t>(x ^ y), 255});
+        }
+    }
+    const auto rgb{compact_image::from_rgba(rgba, 32, 32, pixel_format::rgb)};
+    REQUIRE(rgb.format() == pixel_format::rgb);
+    REQUIRE(rgb.pixel(5, 7) == color{40, 56, 5 ^ 7});
+    REQUIRE(rgb.bytes() < rgba.size());
+
+    const auto indexed{
+        compact_image::from_rgba(rgba, 32, 32, pixel_format::indexed)};
+    REQUIRE(indexed.format() == pixel_format::indexed);
+    REQUIRE(indexed.palette().size() <= 256);
+    REQUIRE(indexed.bytes() < rgb.bytes());
+    // Quantized to a nearby xterm colour.
+    const auto near{indexed.pixel(5, 7)};
+    REQUIRE(std::abs(int{near.r} - 40) <= 48);
+    REQUIRE(std::abs(int{near.g} - 56) <= 48);
+
+    REQUIRE_THROWS_AS(compact_image::from_rgba(std::span{rgba}.first(16), 32,
+                                               32, pixel_format::rgb),
+                      grandrounds::file_error);
+}
+
+TEST_CASE("Fixed-size propagation matches the dynamic path", "[fixed_board]")
+{
+    // 25x20 dispatches to a fixed_board; 7x6 falls back to line_solver.
+    for (const auto& [width, height] : {std::pair{25, 20}, std::pair{7, 6}}) {
+        std::mt19937 rng{gsl::narrow<unsigned int>(width)};
+        std::vector<grandrounds::board_cell> solution(
+            gsl::narrow<std::size_t>(width * height));
+        for (auto& cell : solution) {
+            cell = rng() % 3 == 0 ? grandrounds::board_cell::clear
+                                  : grandrounds::board_cell::filled;
+        }
+        auto rows{grandrounds::calculate_row_hints(solution, width)};
+        const auto cols{grandrounds::calculate_col_hints(solution, width)};
+
+        std::vector<grandrounds::solver_cell> fixed(solution.size());
+        std::vector<grandrounds::solver_cell> dynamic(solution.size());
+        REQUIRE(
+            grandrounds::propagate_lines({width, height}, rows, cols, fixed));
+        REQUIRE(grandrounds::propagate_lines_dynamic({width, height}, rows,
+                                                     cols, dynamic));
+        REQUIRE(fixed == dynamic);
+
+        // The solver's root propagation takes the fixed path when it can.
+        grandrounds::propagation_trace trace;
+        std::vector<grandrounds::solver_cell> traced(solution.size());
+        const auto covered{grandrounds::propagate_fixed_size_lines(
+            {width, height}, rows, cols, traced, trace)};
+        REQUIRE(covered.has_value() == (width == 25));
+        if (covered) {
+            const auto result{grandrounds::solve_nonogram(
+                {width, height}, rows, cols)};
+            REQUIRE(result.stats.root_propagation_rounds == trace.rounds);
+        }
+
+        rows[0].push_back(gsl::narrow<std::uint8_t>(width));
+        std::vector<grandrounds::solver_cell> contradiction(solution.size());
+        REQUIRE(!grandrounds::propagate_lines({width, height}, rows, cols,
+                                              contradiction));
+    }
+}
+
+TEST_CASE("Grid columns follow edits to the cells", "[grid]")
+{
+    std::vector<int> cells(40 * 35);
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        cells[i] = gsl::narrow<int>(i);
+    }
+    grandrounds::grid board{40, cells};
+    const auto& view{std::as_const(board)};
+    REQUIRE(view.height() == 35);
+    REQUIRE(view.row(2)[3] == 83);
+    REQUIRE(view.col(3)[2] == 83);
+    REQUIRE(view.col(39)[34] == 40 * 35 - 1);
+
+    board(3, 2) = -1;
+    board.row(34)[39] = -2;
+    REQUIRE(view.col(3)[2] == -1);
+    REQUIRE(view.col(39)[34] == -2);
+
+    std::size_t visited{0};
+    view.for_each_tiled([&](std::size_t x, std::size_t y, int cell) {
+        if (cell == view(x, y)) {
+            visited++;
+        }
+    });
+    REQUIRE(visited == cells.size());
+    REQUIRE_THROWS_AS((grandrounds::grid{40, std::vector<int>(41)}),
+                      std::invalid_argument);
+}
+
+TEST_CASE("Puzzle cache shares loads and evicts under its budget", "[cache]")
+{
+    std::atomic<int> loads{0};
+    const auto load{[&](std::string_view name) {
+        loads++;
+        return std::make_shared<const grandrounds::nonogram_puzzle>(name);
+    }};
+    std::filesystem::file_time_type modified{};
+    const auto modified_time{[&](std::string_view /*name*/) {
+        return std::optional{modified};
+    }};
+
+    const auto cottontail_bytes{grandrounds::puzzle_bytes(
+        grandrounds::nonogram_puzzle{"cottontail"})};
+    grandrounds::puzzle_cache cache{cottontail_bytes, load, modified_time};
+
+    std::vector<std::future<decltype(cache.get(""))>> requests;
+    for (int i{0}; i < 8; i++) {
+        requests.push_back(std::async(std::launch::async,
+                                      [&] { return cache.get("cottontail"); }));
+    }
+    const auto first{requests.front().get()};
+    for (std::size_t i{1}; i < requests.size(); i++) {
+        REQUIRE(requests[i].get() == first);
+    }
+    REQUIRE(loads == 1);
+    REQUIRE(cache.bytes() == cottontail_bytes);
+
+    // A second puzzle pushes the first out of the budget.
+    const auto lake{cache.get("lake_mendoza")};
+    REQUIRE(cache.bytes() <= cottontail_bytes);
+    REQUIRE(cache.get("cottontail") != first);
+    REQUIRE(loads == 3);
+
+    // Changed files are loaded again.
+    cache.set_byte_budget(SIZE_MAX);
+    const auto again{cache.get("cottontail")};
+    REQUIRE(cache.get("cottontail") == again);
+    modified += std::chrono::seconds{1};
+    REQUIRE(cache.get("cottontail") != again);
+    REQUIRE(loads == 4);
+
+    // A colour puzzle's palette and hint colours count against the budget.
+    std::vector<grandrounds::board_cell> cells(20 * 10);
+    for (std::size_t i{0}; i < cells.size(); i++) {
+        cells[i] = grandrounds::filled_cell(gsl::narrow<std::uint8_t>(i % 3));
+    }
+    const grandrounds::nonogram_puzzle colored{
+        {20, 10}, cells, {{200, 0, 0}, {0, 200, 0}, {0, 0, 200}}};
+    auto uncolored{colored};
+    uncolored.palette = std::vector<grandrounds::color>{};
+    uncolored.row_hint_colors = std::vector<std::vector<std::uint8_t>>{};
+    uncolored.col_hint_colors = std::vector<std::vector<std::uint8_t>>{};
+    // Measured on a copy, whose capacities match the cache's copies.
+    const auto colored_bytes{
+        grandrounds::puzzle_bytes(grandrounds::nonogram_puzzle{colored})};
+    REQUIRE(colored_bytes >= grandrounds::puzzle_bytes(uncolored) +
+                                 3 * sizeof(grandrounds::color) + 20 * 10);
+    grandrounds::puzzle_cache colored_cache{
+        colored_bytes,
+        [&](std::string_view /*name*/) {
+            return std::make_shared<const grandrounds::nonogram_puzzle>(
+                colored);
+        },
+        modified_time};
+    const auto rainbow{colored_cache.get("rainbow")};
+    REQUIRE(colored_cache.bytes() == colored_bytes);
+    const auto prism{colored_cache.get("prism")};
+    REQUIRE(colored_cache.bytes() <= colored_bytes);
+    REQUIRE(colored_cache.get("rainbow") != rainbow);
+}
+
+TEST_CASE("Server keeps a game per connection", "[server]")
+{
+    grandrounds::server_options options;
+    options.socket_path = std::filesystem::temp_directory_path() /
+                          fmt::format("grandrounds-test-{}.sock",
+                                      std::random_device{}());
+    options.threads = 2;
+    grandrounds::puzzle_server server{options};
+    std::jthread serving{[&] { server.run(); }};
+    const auto stop_serving{gsl::finally([&] { server.stop(); })};
+
+    grandrounds::puzzle_client first{options.socket_path};
+    grandrounds::puzzle_client second{options.socket_path};
+    REQUIRE_THROWS_AS(first.request("press 0 0 left"),
+                      grandrounds::server_error);
+    REQUIRE_THROWS_AS(first.request("open no_such_puzzle"),
+                      grandrounds::server_error);
+    REQUIRE_THROWS_AS(first.request("open ../puzzles/cottontail"),
+                      grandrounds::server_error);
+    REQUIRE_THROWS_AS(first.request("join /etc/passwd"),
+                      grandrounds::server_error);
+    const auto blank{first.request("open cottontail")};
+    REQUIRE(second.request("open cottontail") == blank);
+
+    // Pipelined requests are answered in order, including those that wait
+    // for a puzzle to load.
+    first.send("open lake_mendoza");
+    first.send("open cottontail");
+    first.send("solve");
+    first.send("frame");
+    REQUIRE_NOTHROW(first.receive());
+    REQUIRE(first.receive() == blank);
+    const auto solved{first.receive()};
+    REQUIRE(solved != blank);
+    REQUIRE(first.receive() == solved);
+    REQUIRE(second.request("frame") == blank);
+    REQUIRE(first.request("reset") == blank);
+
+    // Sessions that join a puzzle play on the same board.
+    REQUIRE(first.request("join cottontail") == blank);
+    REQUIRE(second.request("join cottontail") == blank);
+    const auto together{first.request("solve")};
+    REQUIRE(second.request("frame") == together);
+
+    // A colour puzzle can be opened but not joined, and trying leaves the
+    // session's game as it was.
+    const auto puzzle_dir{std::filesystem::temp_directory_path() /
+                          fmt::format("grandrounds-test-{}",
+                                      std::random_device{}())};
+    std::filesystem::create_directory(puzzle_dir);
+    const auto remove_dir{
+        gsl::finally([&] { std::filesystem::remove_all(puzzle_dir); })};
+    grandrounds::puzzle_data data;
+    data.colors = 2;
+    grandrounds::save_puzzle_data(puzzle_dir / "rainbow_data.json", data);
+    // Red and blue stripes.
+    constexpr std::array<std::uint8_t, 4> red{255, 0, 0, 255};
+    constexpr std::array<std::uint8_t, 4> blue{0, 0, 255, 255};
+    grandrounds::loaded_image image{{}, 4, 4};
+    for (int i{0}; i < 16; i++) {
+        const auto& pixel{i % 2 == 0 ? red : blue};
+        image.rgba_pixel_data.insert(image.rgba_pixel_data.end(),
+                                     pixel.begin(), pixel.end());
+    }
+    for (const auto* suffix : {"nonogram", "photo", "small"}) {
+        grandrounds::save_image(
+            puzzle_dir / fmt::format("rainbow_{}.png", suffix), image);
+    }
+    ::setenv("GRANDROUNDS_PUZZLES", puzzle_dir.c_str(), 1);
+    const auto unset{gsl::finally([] { ::unsetenv("GRANDROUNDS_PUZZLES"); })};
+    REQUIRE_THROWS_AS(first.request("join rainbow"), grandrounds::server_error);
+    REQUIRE(first.request("frame") == together);
+    REQUIRE(first.request("open rainbow") != together);
+
+    // A request too long to be real ends its session, and only its own.
+    grandrounds::puzzle_client flood{options.socket_path};
+    REQUIRE_THROWS(flood.request(std::string(64UL * 1024, 'x')));
+    REQUIRE(second.request("frame") == together);
+}
+
+TEST_CASE("Shared board stays consistent under concurrent writers",
+          "[shared_board]")
+{
+    const auto puzzle{
+        std::make_shared<const grandrounds::nonogram_puzzle>("cottontail")};
+    const auto board{
+        std::make_shared<grandrounds::shared_board>(puzzle->solution)};
+    const auto check{[&] {
+        return grandrounds::check_solution(
+            grandrounds::nonogram_game{puzzle, board->snapshot()});
+    }};
+    REQUIRE(board->mismatches() ==
+            static_cast<std::size_t>(
+                std::count(puzzle->solution.begin(), puzzle->solution.end(),
+                           grandrounds::board_cell::filled)));
+
+    // A viewer polling while the writers run ends up with the same board.
+    constexpr unsigned int writers{8};
+    grandrounds::shared_board::viewer viewer{board};
+    std::vector<grandrounds::board_cell> seen(board->size());
+    const auto catch_up{[&] {
+        for (const auto& change : viewer.changes()) {
+            seen[change.index] = change.cell;
+        }
+    }};
+    {
+        std::atomic<unsigned int> running{writers};
+        std::vector<std::jthread> threads;
+        for (unsigned int t{0}; t < writers; t++) {
+            threads.emplace_back([&, t] {
+                std::mt19937 rng{t};
+                std::uniform_int_distribution<std::size_t> index{
+                    0, board->size() - 1};
+                std::uniform_int_distribution<int> cell{0, 2};
+                for (int i{0}; i < 20000; i++) {
+                    board->set(index(rng),
+                               static_cast<grandrounds::board_cell>(cell(rng)));
+                }
+                running--;
+            });
+        }
+        while (running > 0) {
+            catch_up();
+        }
+    }
+    catch_up();
+    REQUIRE(seen == board->snapshot());
+    REQUIRE(board->solved() == check());
+    const auto snapshot{board->snapshot()};
+    std::size_t wrong{0};
+    for (std::size_t i{0}; i < snapshot.size(); i++) {
+        wrong += (snapshot[i] == grandrounds::board_cell::filled) !=
+                 (puzzle->solution[i] == grandrounds::board_cell::filled);
+    }
+    REQUIRE(board->mismatches() == wrong);
+
+    // Writers finishing the puzzle between them solve it, whatever the order.
+    {
+        std::vector<std::jthread> threads;
+        for (unsigned int t{0}; t < writers; t++) {
+            threads.emplace_back([&, t] {
+                for (std::size_t i{t}; i < board->size(); i += writers) {
+                    board->set(i, puzzle->solution[i] ==
+                                          grandrounds::board_cell::filled
+                                      ? grandrounds::board_cell::filled
+                                      : grandrounds::board_cell::marked);
+                }
+            });
+        }
+    }
+    REQUIRE(board->mismatches() == 0);
+    REQUIRE(board->solved());
+    REQUIRE(check());
+}
+
+namespace {
+
+// A left-button press on the top-left square of a puzzle's board, and its
+// release.
+std::pair<ftxui::Mouse, ftxui::Mouse> board_click(
+    const grandrounds::nonogram_puzzle& puzzle)
+{
+    ftxui::Mouse press;
+    press.button = ftxui::Mouse::Left;
+    press.motion = ftxui::Mouse::Pressed;
+    press.x = puzzle.row_hints_max * 3 + 1;
+    press.y = puzzle.col_hints_max + 1;
+    ftxui::Mouse release{press};
+    release.motion = ftxui::Mouse::Released;
+    return {press, release};
+}
+
+}  // namespace
+
+TEST_CASE("Recordings survive a round trip and replay", "[recording]")
+{
+    const grandrounds::nonogram_puzzle puzzle{"cottontail"};
+    auto [press, release]{board_click(puzzle)};
+    release.control = true;
+    release.x = -1;
+
+    using std::chrono::microseconds;
+    const grandrounds::event_recording recording{
+        "cottontail",
+        {100, 40},
+        {{microseconds{1000}, ftxui::Event::Mouse("", press)},
+         {microseconds{1200}, ftxui::Event::Mouse("", release)},
+         {microseconds{2500}, ftxui::Event::Character("a")},
+         {microseconds{2600}, ftxui::Event::Special("\x1B[A")}}};
+    const auto bytes{grandrounds::encode_recording(recording)};
+    const auto decoded{grandrounds::decode_recording(bytes)};
+    REQUIRE(decoded.puzzle == recording.puzzle);
+    REQUIRE(decoded.frame_size.x == 100);
+    REQUIRE(decoded.frame_size.y == 40);
+    REQUIRE(decoded.events.size() == recording.events.size());
+    for (std::size_t i{0}; i < decoded.events.size(); i++) {
+        auto expected{recording.events[i].event};
+        auto actual{decoded.events[i].event};
+        REQUIRE(decoded.events[i].time == recording.events[i].time);
+        REQUIRE(actual.is_mouse() == expected.is_mouse());
+        if (expected.is_mouse()) {
+            REQUIRE(actual.mouse().button == expected.mouse().button);
+            REQUIRE(actual.mouse().motion == expected.mouse().motion);
+            REQUIRE(actual.mouse().control == expected.mouse().control);
+            REQUIRE(actual.mouse().x == expected.mouse().x);
+            REQUIRE(actual.mouse().y == expected.mouse().y);
+        }
+        else {
+            REQUIRE(actual.is_character() == expected.is_character());
+            REQUIRE(actual.input() == expected.input());
+        }
+    }
+    REQUIRE_THROWS_AS(grandrounds::decode_recording("not a recording"),
+                      grandrounds::recording_error);
+    REQUIRE_THROWS_AS(
+        grandrounds::decode_recording(std::string_view{bytes}.substr(
+            0, bytes.size() - 1)),
+        grandrounds::recording_error);
+
+    // A frame before the first event and after each one.
+    const auto fast{grandrounds::replay_recording(decoded)};
+    REQUIRE(fast.events.count == 4);
+    REQUIRE(fast.frames.count == 5);
+    REQUIRE(fast.frames.max >= fast.frames.median);
+    const auto timed{grandrounds::replay_recording(decoded, true)};
+    REQUIRE(timed.total >= microseconds{2600});
+}
+
+TEST_CASE("Low-bandwidth rendering sends fewer bytes", "[render]")
+{
+    using grandrounds::palette;
+
+    REQUIRE(grandrounds::parse_palette("true") == palette::true_color);
+    REQUIRE(grandrounds::parse_palette("256") == palette::xterm256);
+    REQUIRE(grandrounds::parse_palette("16") == palette::ansi16);
+    REQUIRE_THROWS_AS(grandrounds::parse_palette("8"), std::invalid_argument);
+
+    // The fixed part of the xterm palette maps back to itself.
+    for (int i{16}; i < 256; i++) {
+        const auto index{static_cast<std::uint8_t>(i)};
+        REQUIRE(grandrounds::nearest_xterm_index(
+                    grandrounds::xterm_color(index)) == index);
+    }
+
+    // Each flush is a frame, and a repeated frame isn't passed on.
+    std::ostringstream terminal;
+    grandrounds::frame_stats stats;
+    {
+        const grandrounds::frame_meter meter{terminal, true};
+        terminal << "first" << std::flush;
+        terminal << "first" << std::flush;
+        terminal << "second" << std::flush;
+        stats = meter.stats();
+    }
+    REQUIRE(terminal.str() == "firstsecond");
+    REQUIRE(stats.frames == 3);
+    REQUIRE(stats.skipped == 1);
+    REQUIRE(stats.bytes == 11);
+    REQUIRE(stats.max_frame_bytes == 6);
+    terminal << "after";
+    REQUIRE(terminal.str() == "firstsecondafter");
+
+    // The same play, replayed in full colour and then for a slow link.
+    const grandrounds::nonogram_puzzle puzzle{"cottontail"};
+    const auto [press, release]{board_click(puzzle)};
+    using std::chrono::microseconds;
+    const grandrounds::event_recording recording{
+        "cottontail",
+        {100, 40},
+        {{microseconds{1000}, ftxui::Event::Mouse("", press)},
+         {microseconds{1200}, ftxui::Event::Mouse("", release)},
+         {microseconds{2500}, ftxui::Event::Character("a")}}};
+    const auto full{grandrounds::replay_recording(recording)};
+    REQUIRE(full.output.frames == 4);
+    REQUIRE(full.output.skipped == 0);
+
+    const auto restore{gsl::finally([] {
+        grandrounds::set_render_options(grandrounds::render_options{});
+    })};
+    grandrounds::set_render_options(grandrounds::low_bandwidth);
+    const auto slow{grandrounds::replay_recording(recording)};
+    REQUIRE(slow.output.frames == 4);
+    REQUIRE(slow.output.bytes < full.output.bytes);
+    REQUIRE(slow.output.max_frame_bytes < full.output.max_frame_bytes);
+}
+
+TEST_CASE("Allocations are counted by scope and kept to budget", "[alloc]")
+{
+    if (!grandrounds::allocation_tracking_enabled) {
+        WARN("Built without ENABLE_ALLOCATION_TRACKING");
+        return;
+    }
+    using grandrounds::allocation_tag;
+
+    // Called directly, since the compiler may leave out a new expression
+    // whose memory is never used.
+    const grandrounds::allocation_meter meter;
+    {
+        const grandrounds::allocation_scope render{allocation_tag::render};
+        void* const outer{::operator new(1000)};
+        {
+            const grandrounds::allocation_scope hints{allocation_tag::hints};
+            ::operator delete(::operator new(1));
+        }
+        ::operator delete(outer);
+    }
+    REQUIRE(meter.since(allocation_tag::render).allocations == 1);
+    REQUIRE(meter.since(allocation_tag::render).bytes == 1000);
+    REQUIRE(meter.since(allocation_tag::render).frees == 1);
+    REQUIRE(meter.since(allocation_tag::hints).allocations == 1);
+
+    // Other threads count for themselves.
+    std::jthread{[] {
+        const grandrounds::allocation_scope render{allocation_tag::render};
+        const std::vector<int> elsewhere(100);
+    }}.join();
+    REQUIRE(meter.since(allocation_tag::render).allocations == 1);
+
+    // Budgets: hints take a vector per line plus a few for the whole board,
+    // and loading a built-in puzzle copies it a line at a time.
+    const grandrounds::allocation_meter load_meter;
+    const grandrounds::nonogram_puzzle puzzle{"cottontail"};
+    const auto lines{static_cast<std::uint64_t>(puzzle.dimensions.x +
+                                                puzzle.dimensions.y)};
+    REQUIRE(load_meter.since(allocation_tag::load).allocations <=
+            2 * lines + 32);
+
+    const grandrounds::allocation_meter hints_meter;
+    static_cast<void>(grandrounds::calculate_row_hints(puzzle.solution,
+                                                       puzzle.dimensions.x));
+    static_cast<void>(grandrounds::calculate_col_hints(puzzle.solution,
+                                                       puzzle.dimensions.x));
+    REQUIRE(hints_meter.since(allocation_tag::hints).allocations <=
+            4 * lines + 8);
+}
+
+TEST_CASE("Colour puzzles tell touching runs apart by colour", "[color]")
+{
+    using grandrounds::board_cell;
+    using grandrounds::color;
+    using grandrounds::filled_cell;
+
+    // Near-white is background and near-red is red, so two colours remain,
+    // the commoner first.
+    const std::vector<std::uint8_t> pixels{
+        255, 255, 255, 200, 0, 0,   205, 3, 0,
+        0,   0,   200, 250, 250, 250, 200, 0, 0};
+    std::vector<color> palette;
+    const auto quantized{
+        grandrounds::quantize_solution(pixels, 3, 4, palette)};
+    REQUIRE(palette == std::vector<color>{{200, 0, 0}, {0, 0, 200}});
+    REQUIRE(quantized == std::vector<board_cell>{board_cell::clear,
+                                                 filled_cell(0), filled_cell(0),
+                                                 filled_cell(1),
+                                                 board_cell::clear,
+                                                 filled_cell(0)});
+
+    // Runs of different colours touch; runs of the same colour don't.
+    const std::vector<board_cell> solution{
+        filled_cell(0), filled_cell(0), filled_cell(1), board_cell::clear,
+        filled_cell(1),  //
+        filled_cell(0), board_cell::clear, filled_cell(0), filled_cell(0),
+        filled_cell(1)};
+    const auto puzzle{std::make_shared<grandrounds::nonogram_puzzle>(
+        grandrounds::board_coords{5, 2}, solution, palette)};
+    REQUIRE(puzzle->is_colored());
+    REQUIRE(puzzle->row_hints[0] == grandrounds::line_hints{2, 1, 1});
+    REQUIRE(puzzle->row_hint_colors[0] == std::vector<std::uint8_t>{0, 1, 1});
+    REQUIRE(puzzle->row_hints[1] == grandrounds::line_hints{1, 2, 1});
+    REQUIRE(puzzle->row_hint_colors[1] == std::vector<std::uint8_t>{0, 0, 1});
+    REQUIRE(puzzle->col_hints[2] == grandrounds::line_hints{1, 1});
+    REQUIRE(puzzle->col_hint_colors[2] == std::vector<std::uint8_t>{1, 0});
+
+    // The right cells in the wrong colour satisfy nothing.
+    grandrounds::nonogram_game game{puzzle,
+                                    std::vector<board_cell>(solution.size())};
+    grandrounds::update_satisfied_hints(game);
+    for (int x{0}; x < 5; x++) {
+        const auto wanted{solution[static_cast<std::size_t>(x)]};
+        grandrounds::set_cell(game, {x, 0},
+                              grandrounds::is_filled(wanted)
+                                  ? filled_cell(0)
+                                  : board_cell::clear);
+    }
+    REQUIRE_FALSE(game.row_satisfied[0]);
+    grandrounds::set_cell(game, {2, 0}, filled_cell(1));
+    grandrounds::set_cell(game, {4, 0}, filled_cell(1));
+    REQUIRE(game.row_satisfied[0]);
+    REQUIRE_FALSE(grandrounds::check_solution(game));
+    game.board = solution;
+    game.board[9] = filled_cell(0);
+    REQUIRE_FALSE(grandrounds::check_solution(game));
+    game.board[9] = filled_cell(1);
+    REQUIRE(grandrounds::check_solution(game));
+
+    // A line is forced where the colours leave no room to slide.
+    grandrounds::colored_line_solver line_solver;
+    std::vector<grandrounds::color_mask> line(
+        4, grandrounds::all_colors_mask(2));
+    const std::vector<std::uint8_t> touching{2, 1};
+    REQUIRE(line_solver.solve(touching, std::vector<std::uint8_t>{0, 1},
+                              std::span{line}.first(3)));
+    REQUIRE(line[0] == grandrounds::color_bit(0));
+    REQUIRE(line[2] == grandrounds::color_bit(1));
+    std::fill(line.begin(), line.end(), grandrounds::all_colors_mask(2));
+    REQUIRE(line_solver.solve(touching, std::vector<std::uint8_t>{0, 0}, line));
+    REQUIRE(line[2] == grandrounds::empty_mask);
+    REQUIRE(grandrounds::colored_line_slack(
+                touching, std::vector<std::uint8_t>{0, 1}, 3) == 0);
+
+    const auto result{grandrounds::solve_nonogram(*puzzle)};
+    REQUIRE(result.status == grandrounds::solve_status::unique);
+    REQUIRE(result.solutions.front() == solution);
+
+    const auto data{grandrounds::parse_puzzle_data(
+        R"({"title": "", "description": "", "author": "", "date": "",
+            "license": "", "wikipedia": "", "colors": 4})")};
+    REQUIRE(data.colors == 4);
+    for (const auto* bad : {R"({"title": "", "description": "", "author": "",
+            "date": "", "license": "", "wikipedia": "", "colors": 0})",
+                            R"({"title": "", "description": "", "author": "",
+            "date": "", "license": "", "wikipedia": "", "colors": 17})"}) {
+        REQUIRE_THROWS_AS(grandrounds::parse_puzzle_data(bad),
+                          grandrounds::json_error);
+    }
+
+    // Every cell's colour must be in the palette, and shared boards are
+    // black and white.
+    REQUIRE_THROWS_AS((grandrounds::nonogram_puzzle{
+                          {2, 1}, {filled_cell(0), filled_cell(2)}, palette}),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS((grandrounds::nonogram_puzzle{
+                          {1, 1}, {board_cell::marked}, palette}),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(grandrounds::shared_board{solution},
+                      std::invalid_argument);
+}